@@ -0,0 +1,109 @@
+#!/bin/sh
+# Standard benchmark suite: runs ./gameoflife --benchmark over a fixed matrix
+# of grid sizes, random densities and known patterns, and prints one CSV row
+# per case on stdout. Seeds are fixed so every machine and engine runs the
+# exact same boards.
+#
+# Environment variables:
+#   BENCH_ENGINES          engines of random grid cases
+#                          (default: "byte packed simd tiled block temporal")
+#   BENCH_PATTERN_ENGINES  engines of pattern cases
+#                          (default: "$BENCH_ENGINES hashlife")
+#   BENCH_SIZES            square grid sizes, from 256 that fits in L2 cache
+#                          to 32768 that needs 3 GiB with byte grids; sizes
+#                          needing more than the available memory are skipped
+#                          (default: "256 2048 16384 32768")
+#   BENCH_DENSITIES        random grid densities (default: "0.05 0.1 0.25 0.5")
+#   BENCH_THREADS          threads per run (default: 1)
+
+BIN=./gameoflife
+ENGINES=${BENCH_ENGINES:-"byte packed simd tiled block temporal"}
+PATTERN_ENGINES=${BENCH_PATTERN_ENGINES:-"$ENGINES hashlife"}
+SIZES=${BENCH_SIZES:-"256 2048 16384 32768"}
+DENSITIES=${BENCH_DENSITIES:-"0.05 0.1 0.25 0.5"}
+THREADS=${BENCH_THREADS:-1}
+SEED=20240101
+PATTERN_SIZE=1024
+PATTERN_GENERATIONS=1000
+PATTERNS="gosper_glider_gun r_pentomino acorn diehard"
+TMP=${TMPDIR:-/tmp}/gameoflife-bench.$$
+
+trap 'rm -rf "$TMP"' EXIT
+mkdir -p "$TMP"
+
+# generations (and warm-up) per size, so that every case runs a few seconds
+generations() {
+  if [ "$1" -le 512 ]; then echo "1000 100"
+  elif [ "$1" -le 4096 ]; then echo "100 10"
+  elif [ "$1" -le 32768 ]; then echo "5 1"
+  else echo "2 1"
+  fi
+}
+
+# KiB needed by a $1 x $1 case: byte engines hold the initial grid and two
+# generations, one byte per cell
+needed_kb() {
+  echo $(( 3 * $1 * $1 / 1024 ))
+}
+
+# KiB of memory available (0 if unknown, sizes are then not checked)
+available_kb() {
+  awk '/^MemAvailable:/ { print $2; found = 1 }
+       END { if (!found) print 0 }' /proc/meminfo 2>/dev/null || echo 0
+}
+
+# center pattern file $1 on a $2 x $2 dead board written to $3
+embed() {
+  awk -v size="$2" 'NR == 1 { w = $1; h = $2; print size, size;
+                              top = int((size - h) / 2);
+                              left = int((size - w) / 2);
+                              blank = sprintf("%" size "s", "");
+                              next }
+                    { rows[NR - 2] = $0 }
+                    END { for (i = 0; i < size; i++) {
+                            if (i >= top && i < top + h) {
+                              row = sprintf("%-" w "s", rows[i - top]);
+                              print substr(blank, 1, left) row \
+                                    substr(blank, 1, size - left - w);
+                            } else {
+                              print blank;
+                            }
+                          } }' "$1" > "$3"
+}
+
+run() {
+  case_name=$1
+  density=$2
+  seed=$3
+  shift 3
+  "$BIN" --benchmark --bench_format csv -t "$THREADS" "$@" |
+    tail -n 1 | sed "s/^/$case_name,$density,$seed,/"
+}
+
+echo "case,density,seed,engine,width,height,threads,warmup,generations,seconds,generations_per_sec,cell_updates_per_sec,ns_per_cell,peak_rss_kb,traffic_saving"
+for size in $SIZES; do
+  available=$(available_kb)
+  if [ "$available" -gt 0 ] && [ "$(needed_kb "$size")" -gt "$available" ]
+  then
+    echo "skipping ${size}x${size}: needs $(( $(needed_kb "$size") >> 20 ))" \
+      "GiB, $(( available >> 20 )) GiB available" >&2
+    continue
+  fi
+  set -- $(generations "$size")
+  gens=$1
+  warmup=$2
+  for density in $DENSITIES; do
+    for engine in $ENGINES; do
+      run "random" "$density" "$SEED" -e "$engine" -w "$size" -h "$size" \
+        --seed "$SEED" --density "$density" -i "$gens" --warmup "$warmup"
+    done
+  done
+done
+for pattern in $PATTERNS; do
+  board="$TMP/$pattern.txt"
+  embed "patterns/$pattern.txt" "$PATTERN_SIZE" "$board"
+  for engine in $PATTERN_ENGINES; do
+    run "$pattern" "" "" -e "$engine" -f "$board" -i "$PATTERN_GENERATIONS" \
+      --warmup 0
+  done
+done
@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "benchmark.h"
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int run_benchmark(GameOfLifeEngine_t *engine, int threads, int warmup,
+                  int generations, const char *format) {
+  if (warmup < 0) {
+    printf("Invalid warmup: %d (expected: at least 0)\n", warmup);
+    return -1;
+  }
+  if (generations < 1) {
+    printf("Invalid iter: %d (expected: at least 1)\n", generations);
+    return -1;
+  }
+  GameOfLifeData_t *data = engine_data(engine);
+  int w = data->w, h = data->h;
+  double cells = (double)w * h;
+
+  engine_step(engine, warmup);
+  long from = engine->generation;
+  double naive_from, traffic_from = engine_traffic(engine, &naive_from);
+  double start = now();
+  engine_step(engine, generations);
+  double seconds = now() - start;
+  if (engine_failed(engine)) {
+    return -1;
+  }
+  double naive, traffic = engine_traffic(engine, &naive);
+  // bytes moved by timed generations and saving over a pass per generation
+  traffic -= traffic_from;
+  naive -= naive_from;
+  double saving = traffic_from >= 0 && traffic > 0 ? naive / traffic : 0;
+  // fewer generations are computed when engine stops on a cycle, possibly
+  // none if it was found during warm-up
+  generations = (int)(engine->generation - from);
+
+  double gens_per_sec = generations > 0 ? generations / seconds : 0;
+  double cell_updates_per_sec = gens_per_sec * cells;
+  double ns_per_cell =
+      generations > 0 ? seconds * 1e9 / (cells * generations) : 0;
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  long peak_rss_kb = usage.ru_maxrss;
+  const char *name = engine->ops->name;
+  if (strcmp(format, "json") == 0) {
+    printf("{\"engine\": \"%s\", \"width\": %d, \"height\": %d, "
+           "\"threads\": %d, \"warmup\": %d, \"generations\": %d, "
+           "\"seconds\": %.6f, \"generations_per_sec\": %.3f, "
+           "\"cell_updates_per_sec\": %.0f, \"ns_per_cell\": %.4f, "
+           "\"peak_rss_kb\": %ld",
+           name, w, h, threads, warmup, generations, seconds, gens_per_sec,
+           cell_updates_per_sec, ns_per_cell, peak_rss_kb);
+    if (saving > 0) {
+      printf(", \"traffic_bytes\": %.0f, \"naive_traffic_bytes\": %.0f, "
+             "\"traffic_saving\": %.3f",
+             traffic, naive, saving);
+    }
+    printf("}\n");
+  } else if (strcmp(format, "csv") == 0) {
+    printf("engine,width,height,threads,warmup,generations,seconds,"
+           "generations_per_sec,cell_updates_per_sec,ns_per_cell,"
+           "peak_rss_kb,traffic_saving\n");
+    printf("%s,%d,%d,%d,%d,%d,%.6f,%.3f,%.0f,%.4f,%ld,", name, w, h, threads,
+           warmup, generations, seconds, gens_per_sec, cell_updates_per_sec,
+           ns_per_cell, peak_rss_kb);
+    if (saving > 0) {
+      printf("%.3f", saving);
+    }
+    printf("\n");
+  } else {
+    printf("engine:               %s\n", name);
+    printf("grid:                 %dx%d\n", w, h);
+    printf("threads:              %d\n", threads);
+    printf("generations:          %d (+ %d warm-up)\n", generations, warmup);
+    printf("time:                 %.6f s\n", seconds);
+    printf("generations/sec:      %.3f\n", gens_per_sec);
+    printf("cell-updates/sec:     %.4g\n", cell_updates_per_sec);
+    printf("ns/cell:              %.4f\n", ns_per_cell);
+    printf("peak RSS:             %ld KiB\n", peak_rss_kb);
+    if (saving > 0) {
+      printf("memory traffic:       %.4g bytes (%.2fx less than a pass per "
+             "generation)\n",
+             traffic, saving);
+    }
+  }
+  return 0;
+}
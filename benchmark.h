@@ -0,0 +1,21 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "engine.h"
+
+/**
+ * @brief Headless benchmark: step engine warmup generations, then time
+ * generations generations and print throughput to stdout (nothing is
+ * printed if engine fails, see engine_failed)
+ *
+ * @param engine engine to benchmark
+ * @param threads number of threads used by engine (reported only)
+ * @param warmup number of generations computed before timing (at least 0)
+ * @param generations number of timed generations (at least 1)
+ * @param format output format ("text", "json" or "csv")
+ * @return int 0 if OK, -1 if a count is invalid or if engine failed
+ */
+int run_benchmark(GameOfLifeEngine_t *engine, int threads, int warmup,
+                  int generations, const char *format);
+
+#endif /* BENCHMARK_H */
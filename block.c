@@ -0,0 +1,331 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "packed.h"
+
+#define BLOCK_TABLE_SIZE (1 << 16)
+#define NIBBLES 0x0f0f0f0f0f0f0f0fULL // low nibble of each byte
+#define COUNT_WORDS 32 // words of a row counted at once by block_step_rows
+
+/**
+ * @brief Block lookup-table engine state: the grid is computed in 2x2 blocks,
+ * the 4x4 neighbourhood of a block (16 cells, hence 16 bits) indexing a table
+ * of its next state. Rows are bit-packed like the packed engine but shifted by
+ * one column (bit 0 of a row holds column -1), so that the 4 columns around
+ * columns 2m and 2m + 1 are the 4 bits starting at bit 2m. Both grids have one
+ * extra row above and two below, so that the last block row of a grid of odd
+ * height reads existing rows.
+ */
+struct BlockEngine {
+  int w;                  // grid width
+  int h;                  // grid height
+  int nw;                 // number of words per row (cells + halo columns)
+  word last_mask;         // valid bits of the last word of computed rows
+  word *cur;              // current generation ((h + 3) * nw words)
+  word *next;             // preallocated grid receiving next generation
+  int torus;              // whether grid wraps around
+  GameOfLifeData_t *view; // byte grid returned by data()
+  int view_valid;         // whether view is up to date with cur
+  int count;              // whether step_rows collects counters
+  GenerationStats_t stats; // counters since last stats() call
+  int hashing;            // whether step_rows hashes rows
+  uint64_t hash;          // hash of current generation (sum of rows hashes,
+                          // halo columns excluded)
+  uint64_t next_hash;     // hash of rows of next generation computed so far
+  byte table[BLOCK_TABLE_SIZE]; // next state of 2x2 blocks (see block_table)
+};
+typedef struct BlockEngine BlockEngine_t;
+
+#define block_row(e, g, i) ((g) + (size_t)(e)->nw * ((i) + 1))
+
+/**
+ * @brief Fill block table of rule: entry n is the next state of the 2x2
+ * centre of the 4x4 neighbourhood n (cell (r, c) being bit 4 * r + c), cell
+ * (dr, dc) of the block being bit 2 * dr + dc
+ *
+ * @param rule rule
+ * @param table table of BLOCK_TABLE_SIZE entries
+ */
+static void block_table(const Rule_t *rule, byte *table) {
+  for (int n = 0; n < BLOCK_TABLE_SIZE; n++) {
+    byte next = 0;
+    for (int dr = 0; dr < 2; dr++) {
+      for (int dc = 0; dc < 2; dc++) {
+        byte alive = (byte)((n >> (4 * (dr + 1) + dc + 1)) & 1);
+        byte count = 0;
+        for (int r = dr; r < dr + 3; r++) {
+          for (int c = dc; c < dc + 3; c++) {
+            count += (byte)((n >> (4 * r + c)) & 1);
+          }
+        }
+        next |= (byte)(rule_cell((byte)(count - alive), alive, rule->birth,
+                                 rule->survive)
+                       << (2 * dr + dc));
+      }
+    }
+    table[n] = next;
+  }
+}
+
+/**
+ * @brief Copy opposite edge columns into halo columns of a row (torus), halo
+ * bits being dead beforehand
+ *
+ * @param row row (bit c + 1 holds column c)
+ * @param w grid width
+ */
+static void wrap_columns(word *row, int w) {
+  int bits[3][2] = {{0, w}, {w + 1, 1}, {w + 2, 1 + 1 % w}};
+  for (int k = 0; k < 3; k++) {
+    int to = bits[k][0], from = bits[k][1];
+    row[to / WORD_BITS] |= ((row[from / WORD_BITS] >> (from % WORD_BITS)) & 1)
+                           << (to % WORD_BITS);
+  }
+}
+
+/**
+ * @brief Copy opposite edge rows into halo rows (torus)
+ *
+ * @param e engine
+ * @param g grid
+ */
+static void wrap_block_rows(BlockEngine_t *e, word *g) {
+  size_t size = (size_t)e->nw * sizeof(word);
+  memcpy(block_row(e, g, -1), block_row(e, g, e->h - 1), size);
+  memcpy(block_row(e, g, e->h), block_row(e, g, 0), size);
+  memcpy(block_row(e, g, e->h + 1), block_row(e, g, 1 % e->h), size);
+}
+
+/**
+ * @brief Compute next state of rows i and i + 1
+ *
+ * @param e engine
+ * @param i first row of block row (even)
+ * @param stats counters to update (NULL if not counting)
+ * @return uint64_t hash of the computed rows (0 unless e->hashing)
+ */
+static uint64_t block_step_rows(BlockEngine_t *e, int i,
+                                GenerationStats_t *stats) {
+  const word *r0 = block_row(e, e->cur, i - 1);
+  const word *r1 = block_row(e, e->cur, i);
+  const word *r2 = block_row(e, e->cur, i + 1);
+  const word *r3 = block_row(e, e->cur, i + 2);
+  word *out0 = block_row(e, e->next, i);
+  word *out1 = block_row(e, e->next, i + 1);
+  const byte *table = e->table;
+  int cw = e->nw - 1; // words of cells (last word holds halo columns only)
+  word carry0 = 0, carry1 = 0;
+  // unshifted words of both rows in both generations, counted by chunks
+  word prev[2][COUNT_WORDS], next[2][COUNT_WORDS];
+  for (int k = 0; k < cw; k++) {
+    word o0 = 0, o1 = 0;
+    // block at bits s = 8q + 2p: rows shifted by 2p, their nibbles at 8q
+    // interleaved two by two so that byte q of ab and cd makes the index
+    for (int p = 0; p < 4; p++) {
+      int s = 2 * p;
+      word a = r0[k] >> s, b = r1[k] >> s, c = r2[k] >> s, d = r3[k] >> s;
+      if (s > 0) {
+        a |= r0[k + 1] << (WORD_BITS - s);
+        b |= r1[k + 1] << (WORD_BITS - s);
+        c |= r2[k + 1] << (WORD_BITS - s);
+        d |= r3[k + 1] << (WORD_BITS - s);
+      }
+      word ab = (a & NIBBLES) | (b & NIBBLES) << 4;
+      word cd = (c & NIBBLES) | (d & NIBBLES) << 4;
+      for (int q = 0; q < WORD_BITS; q += 8) {
+        word t = table[(ab >> q & 255) | (cd >> q & 255) << 8];
+        o0 |= (t & 3) << (q + s);
+        o1 |= (t >> 2) << (q + s);
+      }
+    }
+    word mask = k == cw - 1 ? e->last_mask : ~(word)0;
+    o0 &= mask;
+    o1 &= mask;
+    if (stats != NULL) {
+      int c = k % COUNT_WORDS;
+      prev[0][c] = (r1[k] >> 1 | r1[k + 1] << 63) & mask;
+      prev[1][c] = (r2[k] >> 1 | r2[k + 1] << 63) & mask;
+      next[0][c] = o0;
+      next[1][c] = o1;
+      if (c == COUNT_WORDS - 1 || k == cw - 1) {
+        stats_count_segment(prev[0], next[0], c + 1, i, WORD_BITS * (k - c),
+                            stats);
+        if (i + 1 < e->h) {
+          stats_count_segment(prev[1], next[1], c + 1, i + 1,
+                              WORD_BITS * (k - c), stats);
+        }
+      }
+    }
+    // shift back by one column
+    out0[k] = o0 << 1 | carry0;
+    carry0 = o0 >> 63;
+    out1[k] = o1 << 1 | carry1;
+    carry1 = o1 >> 63;
+  }
+  out0[cw] = carry0;
+  out1[cw] = carry1;
+  // rows are hashed before halo columns are wrapped
+  uint64_t hash = 0;
+  if (e->hashing) {
+    hash = hash_words(out0, e->nw, i);
+  }
+  if (e->torus) {
+    wrap_columns(out0, e->w);
+  }
+  if (i + 1 == e->h) {
+    // halo row below an odd number of rows stays dead (rewrapped on a torus)
+    memset(out1, 0, (size_t)e->nw * sizeof(word));
+  } else {
+    if (e->hashing) {
+      hash += hash_words(out1, e->nw, i + 1);
+    }
+    if (e->torus) {
+      wrap_columns(out1, e->w);
+    }
+  }
+  return hash;
+}
+
+static void *block_engine_create(GameOfLifeData_t *data,
+                                 const EngineConfig_t *config) {
+  BlockEngine_t *e = (BlockEngine_t *)malloc(sizeof(BlockEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->w = data->w;
+  e->h = data->h;
+  e->nw = (data->w + WORD_BITS - 1) / WORD_BITS + 1;
+  e->last_mask = data->w % WORD_BITS == 0
+                     ? ~(word)0
+                     : ((word)1 << (data->w % WORD_BITS)) - 1;
+  size_t words = (size_t)e->nw * (e->h + 3);
+  e->cur = (word *)calloc(words, sizeof(word));
+  e->next = (word *)calloc(words, sizeof(word));
+  if (e->cur == NULL || e->next == NULL) {
+    free(e->cur);
+    free(e->next);
+    free(e);
+    return NULL;
+  }
+  e->torus = config->torus;
+  e->count = config->stats;
+  stats_clear(&e->stats);
+  e->hashing = config->hash;
+  e->hash = 0;
+  e->next_hash = 0;
+  for (int i = 0; i < e->h; i++) {
+    word *row = block_row(e, e->cur, i);
+    for (int j = 0; j < e->w; j++) {
+      row[(j + 1) / WORD_BITS] |= (word)get_cell_state(i, j, data)
+                                  << ((j + 1) % WORD_BITS);
+    }
+    if (e->hashing) {
+      e->hash += hash_words(row, e->nw, i);
+    }
+    if (e->torus) {
+      wrap_columns(row, e->w);
+    }
+  }
+  if (e->torus) {
+    wrap_block_rows(e, e->cur);
+  }
+  block_table(&config->rule, e->table);
+  e->view = data;
+  e->view_valid = 1;
+  return e;
+}
+
+static void block_engine_step_rows(void *state, int begin, int end) {
+  BlockEngine_t *e = (BlockEngine_t *)state;
+  // block rows start on even rows, each band computes those starting in it
+  GenerationStats_t band;
+  stats_clear(&band);
+  uint64_t hash = 0;
+  for (int i = begin + (begin & 1); i < end; i += 2) {
+    hash += block_step_rows(e, i, e->count ? &band : NULL);
+  }
+  if (e->count) {
+    stats_merge(&e->stats, &band);
+  }
+  if (e->hashing) {
+    __atomic_fetch_add(&e->next_hash, hash, __ATOMIC_RELAXED);
+  }
+}
+
+static void block_engine_swap(void *state) {
+  BlockEngine_t *e = (BlockEngine_t *)state;
+  word *tmp = e->cur;
+  e->cur = e->next;
+  e->next = tmp;
+  if (e->torus) {
+    wrap_block_rows(e, e->cur);
+  }
+  e->view_valid = 0;
+  e->hash = e->next_hash;
+  e->next_hash = 0;
+}
+
+static void block_engine_stats(void *state, GenerationStats_t *stats) {
+  BlockEngine_t *e = (BlockEngine_t *)state;
+  *stats = e->stats;
+  stats_clear(&e->stats);
+}
+
+static uint64_t block_engine_hash(void *state) {
+  BlockEngine_t *e = (BlockEngine_t *)state;
+  return e->hash;
+}
+
+static void block_engine_pack(void *state, uint64_t *rows) {
+  BlockEngine_t *e = (BlockEngine_t *)state;
+  int cw = e->nw - 1;
+  for (int i = 0; i < e->h; i++) {
+    // shift back by one column, dropping halo columns
+    const word *row = block_row(e, e->cur, i);
+    word *out = rows + (size_t)cw * i;
+    for (int k = 0; k < cw; k++) {
+      out[k] = row[k] >> 1 | row[k + 1] << (WORD_BITS - 1);
+    }
+    out[cw - 1] &= e->last_mask;
+  }
+}
+
+static GameOfLifeData_t *block_engine_data(void *state) {
+  BlockEngine_t *e = (BlockEngine_t *)state;
+  if (!e->view_valid) {
+    for (int i = 0; i < e->h; i++) {
+      const word *row = block_row(e, e->cur, i);
+      for (int j = 0; j < e->w; j++) {
+        set_cell_state(
+            i, j, e->view,
+            (byte)((row[(j + 1) / WORD_BITS] >> ((j + 1) % WORD_BITS)) & 1));
+      }
+    }
+    e->view_valid = 1;
+  }
+  return e->view;
+}
+
+static void block_engine_destroy(void *state) {
+  BlockEngine_t *e = (BlockEngine_t *)state;
+  free(e->cur);
+  free(e->next);
+  free_data(e->view);
+  free(e);
+}
+
+const EngineOps_t block_engine_ops = {
+    .name = "block",
+    .torus = 1,
+    .birth0 = 1,
+    .bounded = 1,
+    .create = block_engine_create,
+    .step_rows = block_engine_step_rows,
+    .swap = block_engine_swap,
+    .stats = block_engine_stats,
+    .hash = block_engine_hash,
+    .pack = block_engine_pack,
+    .data = block_engine_data,
+    .destroy = block_engine_destroy,
+};
@@ -0,0 +1,174 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "cycle.h"
+
+#define CHUNK_SIZE (1 << 20)
+
+/**
+ * @brief Checksum task shared by pool threads
+ */
+struct ChecksumTask {
+  const byte *grid;
+  size_t size;      // grid size in bytes
+  size_t chunks;    // number of chunks
+  uint64_t *hashes; // hash of each chunk
+};
+typedef struct ChecksumTask ChecksumTask_t;
+
+static void hash_chunks(void *arg, int id, int count) {
+  ChecksumTask_t *task = (ChecksumTask_t *)arg;
+  size_t begin = task->chunks * id / count;
+  size_t end = task->chunks * (id + 1) / count;
+  for (size_t c = begin; c < end; c++) {
+    size_t offset = c * CHUNK_SIZE;
+    size_t len = task->size - offset < CHUNK_SIZE ? task->size - offset
+                                                  : CHUNK_SIZE;
+    task->hashes[c] = hash_bytes(task->grid + offset, len);
+  }
+}
+
+uint64_t checkpoint_checksum(GameOfLifeData_t *data, ThreadPool_t *pool) {
+  size_t size = (size_t)data->w * data->h;
+  ChecksumTask_t task = {data->grid, size, (size + CHUNK_SIZE - 1) / CHUNK_SIZE,
+                         NULL};
+  task.hashes = (uint64_t *)malloc(task.chunks * sizeof(uint64_t));
+  if (task.hashes == NULL) {
+    // no room for chunk hashes: fold them on the fly
+    uint64_t hash = FNV_OFFSET;
+    for (size_t c = 0; c < task.chunks; c++) {
+      size_t offset = c * CHUNK_SIZE;
+      size_t len = size - offset < CHUNK_SIZE ? size - offset : CHUNK_SIZE;
+      hash = (hash ^ hash_bytes(data->grid + offset, len)) * FNV_PRIME;
+    }
+    return hash;
+  }
+  if (pool != NULL) {
+    threadpool_run(pool, hash_chunks, &task);
+  } else {
+    hash_chunks(&task, 0, 1);
+  }
+  uint64_t hash = FNV_OFFSET;
+  for (size_t c = 0; c < task.chunks; c++) {
+    hash = (hash ^ task.hashes[c]) * FNV_PRIME;
+  }
+  free(task.hashes);
+  return hash;
+}
+
+int write_checkpoint(const char *path, GameOfLifeData_t *data,
+                     long generation, const Rule_t *rule, int torus,
+                     ThreadPool_t *pool) {
+  CheckpointHeader_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+  header.version = CHECKPOINT_VERSION;
+  header.grid_offset = CHECKPOINT_GRID_OFFSET;
+  header.w = data->w;
+  header.h = data->h;
+  header.generation = generation;
+  header.birth = rule->birth;
+  header.survive = rule->survive;
+  header.torus = torus != 0;
+  header.checksum = checkpoint_checksum(data, pool);
+
+  size_t tmp_len = strlen(path) + sizeof(".tmp");
+  char *tmp_path = (char *)malloc(tmp_len);
+  if (tmp_path == NULL) {
+    printf("Failed to write checkpoint: %s\n", path);
+    return -1;
+  }
+  snprintf(tmp_path, tmp_len, "%s.tmp", path);
+  FILE *file = fopen(tmp_path, "w");
+  if (file == NULL) {
+    printf("Failed to open file: %s\n", tmp_path);
+    free(tmp_path);
+    return -1;
+  }
+  static const byte padding[CHECKPOINT_GRID_OFFSET];
+  size_t size = (size_t)data->w * data->h;
+  int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+           fwrite(padding, CHECKPOINT_GRID_OFFSET - sizeof(header), 1,
+                  file) == 1 &&
+           fwrite(data->grid, 1, size, file) == size;
+  if (fclose(file) != 0 || !ok || rename(tmp_path, path) != 0) {
+    printf("Failed to write checkpoint: %s\n", path);
+    unlink(tmp_path);
+    free(tmp_path);
+    return -1;
+  }
+  free(tmp_path);
+  return 0;
+}
+
+GameOfLifeData_t *read_checkpoint(const char *path, Rule_t *rule, int *torus,
+                                  long *generation, int threads) {
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    printf("Failed to open file: %s\n", path);
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < CHECKPOINT_GRID_OFFSET) {
+    printf("Invalid checkpoint: %s (file too small)\n", path);
+    close(fd);
+    return NULL;
+  }
+  size_t map_size = (size_t)st.st_size;
+  // private mapping: cells are read from the page cache without parsing, the
+  // engine then copies them into its own representation
+  void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    printf("Failed to map file: %s\n", path);
+    return NULL;
+  }
+  const CheckpointHeader_t *header = (const CheckpointHeader_t *)map;
+  if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+    printf("Invalid checkpoint: %s (bad magic)\n", path);
+    goto fail;
+  }
+  if (header->version != CHECKPOINT_VERSION) {
+    printf("Invalid checkpoint: %s (unsupported version %u, expected: %d)\n",
+           path, header->version, CHECKPOINT_VERSION);
+    goto fail;
+  }
+  if (header->w <= 0 || header->h <= 0 ||
+      header->grid_offset < sizeof(CheckpointHeader_t) ||
+      header->grid_offset > map_size ||
+      map_size - header->grid_offset !=
+          (size_t)header->w * (size_t)header->h) {
+    printf("Invalid checkpoint: %s (grid size does not match %dx%d)\n", path,
+           header->w, header->h);
+    goto fail;
+  }
+  GameOfLifeData_t *data =
+      init(header->w, header->h, (byte *)map + header->grid_offset);
+  data->map = map;
+  data->map_size = map_size;
+  // checksum is computed by calling thread if threads could not be started
+  ThreadPool_t *pool = threadpool_init(threads < 1 ? 1 : threads);
+  uint64_t checksum = checkpoint_checksum(data, pool);
+  if (pool != NULL) {
+    free_threadpool(pool);
+  }
+  if (checksum != header->checksum) {
+    printf("Invalid checkpoint: %s (checksum mismatch)\n", path);
+    free_data(data);
+    return NULL;
+  }
+  rule->birth = header->birth;
+  rule->survive = header->survive;
+  *torus = header->torus != 0;
+  *generation = header->generation;
+  return data;
+fail:
+  munmap(map, map_size);
+  return NULL;
+}
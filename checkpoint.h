@@ -0,0 +1,87 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#include "gameoflife.h"
+#include "rule.h"
+#include "threadpool.h"
+
+#define CHECKPOINT_MAGIC "GOLCKPT"
+#define CHECKPOINT_VERSION 1
+// grid starts on a page boundary so that it can be used in place once mapped
+#define CHECKPOINT_GRID_OFFSET 4096
+
+/**
+ * @brief Checkpoint file header (host byte order), followed at grid_offset
+ * by the w x h byte grid (one byte per cell, DEAD or ALIVE, rows first)
+ */
+struct CheckpointHeader {
+  char magic[8];        // CHECKPOINT_MAGIC
+  uint32_t version;     // CHECKPOINT_VERSION
+  uint32_t grid_offset; // offset of grid in file
+  int32_t w;            // grid width
+  int32_t h;            // grid height
+  int64_t generation;   // generation of grid
+  uint16_t birth;       // rule birth mask (see Rule_t)
+  uint16_t survive;     // rule survive mask (see Rule_t)
+  uint32_t torus;       // 1 if grid wraps around, 0 if cells outside are dead
+                        // (see EngineConfig_t)
+  uint64_t checksum;    // checksum of grid (see checkpoint_checksum)
+};
+typedef struct CheckpointHeader CheckpointHeader_t;
+
+/**
+ * @brief Periodic checkpoints of a run
+ */
+struct Checkpointer {
+  const char *path; // checkpoint file (replaced by each checkpoint)
+  long every;       // number of generations between two checkpoints
+  Rule_t rule;      // rule of the run
+  int torus;        // whether grid wraps around
+};
+typedef struct Checkpointer Checkpointer_t;
+
+/**
+ * @brief Compute checksum of grid: FNV-1a over 64-bit words of 1 MiB
+ * chunks, chunk hashes being folded in order. Chunks are hashed in parallel
+ * by pool threads.
+ *
+ * @param data grid to hash
+ * @param pool threads hashing chunks (NULL to hash on calling thread)
+ * @return uint64_t checksum
+ */
+uint64_t checkpoint_checksum(GameOfLifeData_t *data, ThreadPool_t *pool);
+
+/**
+ * @brief Write checkpoint file. File is written next to path then renamed,
+ * so that an interrupted write keeps previous checkpoint.
+ *
+ * @param path path of checkpoint file
+ * @param data grid to save
+ * @param generation generation of grid
+ * @param rule rule of the run
+ * @param torus whether grid wraps around
+ * @param pool threads computing checksum (NULL to use calling thread)
+ * @return int 0 if OK, -1 otherwise
+ */
+int write_checkpoint(const char *path, GameOfLifeData_t *data,
+                     long generation, const Rule_t *rule, int torus,
+                     ThreadPool_t *pool);
+
+/**
+ * @brief Restore checkpoint file: file is mapped copy-on-write and grid is
+ * used in place, so that no cell is parsed (only checksum is verified).
+ * Engines still copy the grid into their own representation when created.
+ *
+ * @param path path of checkpoint file
+ * @param rule receives rule of the run
+ * @param torus receives whether grid wraps around
+ * @param generation receives generation of grid
+ * @param threads number of threads verifying checksum
+ * @return GameOfLifeData_t* data (must be free'd by caller, NULL on error)
+ */
+GameOfLifeData_t *read_checkpoint(const char *path, Rule_t *rule, int *torus,
+                                  long *generation, int threads);
+
+#endif /* CHECKPOINT_H */
@@ -34,19 +34,49 @@ const char *gengetopt_args_info_versiontext = "";
 const char *gengetopt_args_info_description = "Run a randomly initialized Conway's Game of Life.";
 
 const char *gengetopt_args_info_help[] = {
-  "      --help              Print help and exit",
-  "  -V, --version           Print version and exit",
-  "  -w, --width=INT         Grid with  (default=`20')",
-  "  -h, --height=INT        Grid height  (default=`10')",
-  "  -d, --display_time=INT  Display time of a single iteration in seconds\n                            (default=`1')",
-  "  -i, --iter=INT          Number of iteration  (default=`10')",
-  "  -f, --file=filename     Fullpath to file with initial Game of Life state\n                            (width and height options are ignored when this is\n                            on)",
+  "      --help                   Print help and exit",
+  "  -V, --version                Print version and exit",
+  "  -w, --width=INT              Grid with  (default=`20')",
+  "  -h, --height=INT             Grid height  (default=`10')",
+  "  -d, --display_time=INT       Display time of a single iteration in seconds\n                                 (default=`1')",
+  "      --fps=DOUBLE             Display rate in frames per second (overrides\n                                 display_time), frames are skipped when display\n                                 falls behind",
+  "  -i, --iter=INT               Number of iteration  (default=`10')",
+  "  -f, --file=filename          Fullpath to file with initial Game of Life state,\n                                 plaintext or RLE format (width and height\n                                 options are ignored when this is on)",
+  "  -r, --rule=STRING            Rule in B/S notation (eg. B36/S23 for HighLife,\n                                 B3678/S34678 for Day & Night, B2/S for Seeds),\n                                 overrides the rule of RLE and checkpoint files\n                                 (default: B3/S23, Conway's Game of Life)",
+  "  -e, --engine=STRING          Simulation engine (byte: reference grid with one\n                                 byte per cell, packed: 64 cells per 64-bit word\n                                 updated with bitwise operations, simd: byte\n                                 grid updated 16/32/64 cells at once with\n                                 SSE2/AVX2/AVX-512, hashlife: memoized quadtree\n                                 simulating the unbounded plane, the grid being\n                                 the displayed window, tiled: packed grid where\n                                 only 64x64 tiles that changed during last\n                                 generation and their neighbours are computed,\n                                 block: packed grid computed 2x2 cells at once\n                                 by looking up their 4x4 neighbourhood in a\n                                 65536 entries table, sparse: unbounded plane\n                                 stored as a hash map of 64x64 chunks allocated\n                                 when activity reaches them and freed once\n                                 empty, the grid being the displayed window,\n                                 distributed: packed grid split in horizontal\n                                 bands computed by worker processes exchanging\n                                 their boundary rows every generation, temporal:\n                                 packed grid advanced temporal_depth generations\n                                 per pass over memory in cache resident tiles)\n                                 (possible values=\"byte\", \"packed\",\n                                 \"simd\", \"hashlife\", \"tiled\", \"block\",\n                                 \"sparse\", \"distributed\", \"temporal\"\n                                 default=`byte')",
+  "      --isa=STRING             Instruction set of simd engine kernel (auto:\n                                 widest one supported by the CPU)  (possible\n                                 values=\"auto\", \"scalar\", \"sse2\",\n                                 \"avx2\", \"avx512\" default=`auto')",
+  "      --boundary=STRING        Cells outside the grid (dead: always dead, torus:\n                                 grid edges wrap around, not supported by\n                                 hashlife and sparse engines), overrides the\n                                 boundary of checkpoint and recording files\n                                 (possible values=\"dead\", \"torus\"\n                                 default=`dead')",
+  "  -t, --threads=INT            Number of threads computing each generation (grid\n                                 is split in horizontal bands of rows)\n                                 (default=`1')",
+  "      --processes=INT          Number of worker processes of distributed engine\n                                 (one band of rows each)  (default=`2')",
+  "      --temporal_depth=INT     Number of generations computed per pass over\n                                 memory by temporal engine (1 to 64, tiles are\n                                 loaded with a ghost zone as deep)\n                                 (default=`8')",
+  "  -s, --step=LONG              Number of generations computed between two\n                                 displayed iterations (hashlife engine computes\n                                 power of 2 steps in a single jump)\n                                 (default=`1')",
+  "      --hashlife_memory=INT    Memory budget of hashlife engine node cache in\n                                 MiB (unused nodes are garbage collected when it\n                                 is reached)  (default=`512')",
+  "  -b, --benchmark              Headless benchmark: no display nor sleep, warmup\n                                 generations are computed then iter generations\n                                 are timed  (default=off)",
+  "      --warmup=INT             Number of generations computed before timing in\n                                 benchmark mode  (default=`10')",
+  "      --bench_format=STRING    Benchmark report format  (possible\n                                 values=\"text\", \"json\", \"csv\"\n                                 default=`text')",
+  "      --seed=LONG              Seed of the random initial grid (same seed gives\n                                 the same grid whatever the number of threads)\n                                 (default=`1')",
+  "      --density=DOUBLE         Probability of a cell of the random initial grid\n                                 to be alive  (default=`0.5')",
+  "  -o, --output=filename        Fullpath to file receiving last Game of Life\n                                 state (RLE format if file name ends with .rle,\n                                 plaintext format otherwise)",
+  "      --checkpoint=filename    Checkpoint file written every checkpoint_every\n                                 generations  (default=`gameoflife.ckpt')",
+  "      --checkpoint_every=LONG  Number of generations between two checkpoints (0\n                                 disables checkpoints)  (default=`0')",
+  "      --restore=filename       Resume run from checkpoint file",
+  "      --record=filename        Recording file receiving the initial grid then\n                                 every computed generation (keyframes and deltas\n                                 of changed cells, written by a background\n                                 thread)",
+  "      --keyframe_every=LONG    Maximum number of generations between two\n                                 keyframes of the recording (replay decodes at\n                                 most that many deltas)  (default=`100')",
+  "      --replay=filename        Resume run from the generation given by seek of a\n                                 recording file",
+  "      --seek=LONG              Generation of the replay recording to load\n                                 (negative: last recorded generation)\n                                 (default=`-1')",
+  "      --stats=filename         Statistics file receiving one JSON line per step\n                                 (population, births, deaths, bounding box of\n                                 live cells and wall time) then a summary line\n                                 with step time percentiles",
+  "      --trace=filename         Trace file receiving timing spans of each phase\n                                 (load, generate, step, display, sleep) and of\n                                 each worker thread in Chrome trace-event JSON\n                                 (chrome://tracing, Perfetto)",
+  "      --ensemble=INT           Run that many independent random boards of width\n                                 x height together (64 boards per 64-bit word,\n                                 engine option is ignored) and print per-board\n                                 statistics as CSV (board, initial and final\n                                 population, status: extinct, still, period2 or\n                                 active, and the generation it holds since),\n                                 throughput being reported on stderr",
+  "      --cycle_window=INT       Number of past generations compared with each new\n                                 one to detect extinction, still lifes and\n                                 cycles, the run stops early when the grid\n                                 repeats (0 disables detection)  (default=`0')",
     0
 };
 
 typedef enum {ARG_NO
+  , ARG_FLAG
   , ARG_STRING
   , ARG_INT
+  , ARG_LONG
+  , ARG_DOUBLE
 } cmdline_parser_arg_type;
 
 static
@@ -59,6 +89,11 @@ cmdline_parser_internal (int argc, char **argv, struct gengetopt_args_info *args
                         struct cmdline_parser_params *params, const char *additional_error);
 
 
+const char *cmdline_parser_engine_values[] = {"byte", "packed", "simd", "hashlife", "tiled", "block", "sparse", "distributed", "temporal", 0}; /*< Possible values for engine. */
+const char *cmdline_parser_isa_values[] = {"auto", "scalar", "sse2", "avx2", "avx512", 0}; /*< Possible values for isa. */
+const char *cmdline_parser_boundary_values[] = {"dead", "torus", 0}; /*< Possible values for boundary. */
+const char *cmdline_parser_bench_format_values[] = {"text", "json", "csv", 0}; /*< Possible values for bench_format. */
+
 static char *
 gengetopt_strdup (const char *s);
 
@@ -70,8 +105,35 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->width_given = 0 ;
   args_info->height_given = 0 ;
   args_info->display_time_given = 0 ;
+  args_info->fps_given = 0 ;
   args_info->iter_given = 0 ;
   args_info->file_given = 0 ;
+  args_info->rule_given = 0 ;
+  args_info->engine_given = 0 ;
+  args_info->isa_given = 0 ;
+  args_info->boundary_given = 0 ;
+  args_info->threads_given = 0 ;
+  args_info->processes_given = 0 ;
+  args_info->temporal_depth_given = 0 ;
+  args_info->step_given = 0 ;
+  args_info->hashlife_memory_given = 0 ;
+  args_info->benchmark_given = 0 ;
+  args_info->warmup_given = 0 ;
+  args_info->bench_format_given = 0 ;
+  args_info->seed_given = 0 ;
+  args_info->density_given = 0 ;
+  args_info->output_given = 0 ;
+  args_info->checkpoint_given = 0 ;
+  args_info->checkpoint_every_given = 0 ;
+  args_info->restore_given = 0 ;
+  args_info->record_given = 0 ;
+  args_info->keyframe_every_given = 0 ;
+  args_info->replay_given = 0 ;
+  args_info->seek_given = 0 ;
+  args_info->stats_given = 0 ;
+  args_info->trace_given = 0 ;
+  args_info->ensemble_given = 0 ;
+  args_info->cycle_window_given = 0 ;
 }
 
 static
@@ -84,10 +146,61 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->height_orig = NULL;
   args_info->display_time_arg = 1;
   args_info->display_time_orig = NULL;
+  args_info->fps_orig = NULL;
   args_info->iter_arg = 10;
   args_info->iter_orig = NULL;
   args_info->file_arg = NULL;
   args_info->file_orig = NULL;
+  args_info->rule_arg = NULL;
+  args_info->rule_orig = NULL;
+  args_info->engine_arg = gengetopt_strdup ("byte");
+  args_info->engine_orig = NULL;
+  args_info->isa_arg = gengetopt_strdup ("auto");
+  args_info->isa_orig = NULL;
+  args_info->boundary_arg = gengetopt_strdup ("dead");
+  args_info->boundary_orig = NULL;
+  args_info->threads_arg = 1;
+  args_info->threads_orig = NULL;
+  args_info->processes_arg = 2;
+  args_info->processes_orig = NULL;
+  args_info->temporal_depth_arg = 8;
+  args_info->temporal_depth_orig = NULL;
+  args_info->step_arg = 1;
+  args_info->step_orig = NULL;
+  args_info->hashlife_memory_arg = 512;
+  args_info->hashlife_memory_orig = NULL;
+  args_info->benchmark_flag = 0;
+  args_info->warmup_arg = 10;
+  args_info->warmup_orig = NULL;
+  args_info->bench_format_arg = gengetopt_strdup ("text");
+  args_info->bench_format_orig = NULL;
+  args_info->seed_arg = 1;
+  args_info->seed_orig = NULL;
+  args_info->density_arg = 0.5;
+  args_info->density_orig = NULL;
+  args_info->output_arg = NULL;
+  args_info->output_orig = NULL;
+  args_info->checkpoint_arg = gengetopt_strdup ("gameoflife.ckpt");
+  args_info->checkpoint_orig = NULL;
+  args_info->checkpoint_every_arg = 0;
+  args_info->checkpoint_every_orig = NULL;
+  args_info->restore_arg = NULL;
+  args_info->restore_orig = NULL;
+  args_info->record_arg = NULL;
+  args_info->record_orig = NULL;
+  args_info->keyframe_every_arg = 100;
+  args_info->keyframe_every_orig = NULL;
+  args_info->replay_arg = NULL;
+  args_info->replay_orig = NULL;
+  args_info->seek_arg = -1;
+  args_info->seek_orig = NULL;
+  args_info->stats_arg = NULL;
+  args_info->stats_orig = NULL;
+  args_info->trace_arg = NULL;
+  args_info->trace_orig = NULL;
+  args_info->ensemble_orig = NULL;
+  args_info->cycle_window_arg = 0;
+  args_info->cycle_window_orig = NULL;
   
 }
 
@@ -101,8 +214,35 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->width_help = gengetopt_args_info_help[2] ;
   args_info->height_help = gengetopt_args_info_help[3] ;
   args_info->display_time_help = gengetopt_args_info_help[4] ;
-  args_info->iter_help = gengetopt_args_info_help[5] ;
-  args_info->file_help = gengetopt_args_info_help[6] ;
+  args_info->fps_help = gengetopt_args_info_help[5] ;
+  args_info->iter_help = gengetopt_args_info_help[6] ;
+  args_info->file_help = gengetopt_args_info_help[7] ;
+  args_info->rule_help = gengetopt_args_info_help[8] ;
+  args_info->engine_help = gengetopt_args_info_help[9] ;
+  args_info->isa_help = gengetopt_args_info_help[10] ;
+  args_info->boundary_help = gengetopt_args_info_help[11] ;
+  args_info->threads_help = gengetopt_args_info_help[12] ;
+  args_info->processes_help = gengetopt_args_info_help[13] ;
+  args_info->temporal_depth_help = gengetopt_args_info_help[14] ;
+  args_info->step_help = gengetopt_args_info_help[15] ;
+  args_info->hashlife_memory_help = gengetopt_args_info_help[16] ;
+  args_info->benchmark_help = gengetopt_args_info_help[17] ;
+  args_info->warmup_help = gengetopt_args_info_help[18] ;
+  args_info->bench_format_help = gengetopt_args_info_help[19] ;
+  args_info->seed_help = gengetopt_args_info_help[20] ;
+  args_info->density_help = gengetopt_args_info_help[21] ;
+  args_info->output_help = gengetopt_args_info_help[22] ;
+  args_info->checkpoint_help = gengetopt_args_info_help[23] ;
+  args_info->checkpoint_every_help = gengetopt_args_info_help[24] ;
+  args_info->restore_help = gengetopt_args_info_help[25] ;
+  args_info->record_help = gengetopt_args_info_help[26] ;
+  args_info->keyframe_every_help = gengetopt_args_info_help[27] ;
+  args_info->replay_help = gengetopt_args_info_help[28] ;
+  args_info->seek_help = gengetopt_args_info_help[29] ;
+  args_info->stats_help = gengetopt_args_info_help[30] ;
+  args_info->trace_help = gengetopt_args_info_help[31] ;
+  args_info->ensemble_help = gengetopt_args_info_help[32] ;
+  args_info->cycle_window_help = gengetopt_args_info_help[33] ;
   
 }
 
@@ -195,22 +335,101 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
   free_string_field (&(args_info->width_orig));
   free_string_field (&(args_info->height_orig));
   free_string_field (&(args_info->display_time_orig));
+  free_string_field (&(args_info->fps_orig));
   free_string_field (&(args_info->iter_orig));
   free_string_field (&(args_info->file_arg));
   free_string_field (&(args_info->file_orig));
+  free_string_field (&(args_info->rule_arg));
+  free_string_field (&(args_info->rule_orig));
+  free_string_field (&(args_info->engine_arg));
+  free_string_field (&(args_info->engine_orig));
+  free_string_field (&(args_info->isa_arg));
+  free_string_field (&(args_info->isa_orig));
+  free_string_field (&(args_info->boundary_arg));
+  free_string_field (&(args_info->boundary_orig));
+  free_string_field (&(args_info->threads_orig));
+  free_string_field (&(args_info->processes_orig));
+  free_string_field (&(args_info->temporal_depth_orig));
+  free_string_field (&(args_info->step_orig));
+  free_string_field (&(args_info->hashlife_memory_orig));
+  free_string_field (&(args_info->warmup_orig));
+  free_string_field (&(args_info->bench_format_arg));
+  free_string_field (&(args_info->bench_format_orig));
+  free_string_field (&(args_info->seed_orig));
+  free_string_field (&(args_info->density_orig));
+  free_string_field (&(args_info->output_arg));
+  free_string_field (&(args_info->output_orig));
+  free_string_field (&(args_info->checkpoint_arg));
+  free_string_field (&(args_info->checkpoint_orig));
+  free_string_field (&(args_info->checkpoint_every_orig));
+  free_string_field (&(args_info->restore_arg));
+  free_string_field (&(args_info->restore_orig));
+  free_string_field (&(args_info->record_arg));
+  free_string_field (&(args_info->record_orig));
+  free_string_field (&(args_info->keyframe_every_orig));
+  free_string_field (&(args_info->replay_arg));
+  free_string_field (&(args_info->replay_orig));
+  free_string_field (&(args_info->seek_orig));
+  free_string_field (&(args_info->stats_arg));
+  free_string_field (&(args_info->stats_orig));
+  free_string_field (&(args_info->trace_arg));
+  free_string_field (&(args_info->trace_orig));
+  free_string_field (&(args_info->ensemble_orig));
+  free_string_field (&(args_info->cycle_window_orig));
   
   
 
   clear_given (args_info);
 }
 
+/**
+ * @param val the value to check
+ * @param values the possible values
+ * @return the index of the matched value:
+ * -1 if no value matched,
+ * -2 if more than one value has matched
+ */
+static int
+check_possible_values(const char *val, const char *values[])
+{
+  int i, found, last;
+  size_t len;
+
+  if (!val)   /* otherwise strlen() crashes below */
+    return -1; /* -1 means no argument for the option */
+
+  found = last = 0;
+
+  for (i = 0, len = strlen(val); values[i]; ++i)
+    {
+      if (strncmp(val, values[i], len) == 0)
+        {
+          ++found;
+          last = i;
+          if (strlen(values[i]) == len)
+            return i; /* exact macth no need to check more */
+        }
+    }
+
+  if (found == 1) /* one match: OK */
+    return last;
+
+  return (found ? -2 : -1); /* return many values or none matched */
+}
+
 
 static void
 write_into_file(FILE *outfile, const char *opt, const char *arg, const char *values[])
 {
-  FIX_UNUSED (values);
+  int found = -1;
   if (arg) {
-    fprintf(outfile, "%s=\"%s\"\n", opt, arg);
+    if (values) {
+      found = check_possible_values(arg, values);      
+    }
+    if (found >= 0)
+      fprintf(outfile, "%s=\"%s\" # %s\n", opt, arg, values[found]);
+    else
+      fprintf(outfile, "%s=\"%s\"\n", opt, arg);
   } else {
     fprintf(outfile, "%s\n", opt);
   }
@@ -238,10 +457,64 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "height", args_info->height_orig, 0);
   if (args_info->display_time_given)
     write_into_file(outfile, "display_time", args_info->display_time_orig, 0);
+  if (args_info->fps_given)
+    write_into_file(outfile, "fps", args_info->fps_orig, 0);
   if (args_info->iter_given)
     write_into_file(outfile, "iter", args_info->iter_orig, 0);
   if (args_info->file_given)
     write_into_file(outfile, "file", args_info->file_orig, 0);
+  if (args_info->rule_given)
+    write_into_file(outfile, "rule", args_info->rule_orig, 0);
+  if (args_info->engine_given)
+    write_into_file(outfile, "engine", args_info->engine_orig, cmdline_parser_engine_values);
+  if (args_info->isa_given)
+    write_into_file(outfile, "isa", args_info->isa_orig, cmdline_parser_isa_values);
+  if (args_info->boundary_given)
+    write_into_file(outfile, "boundary", args_info->boundary_orig, cmdline_parser_boundary_values);
+  if (args_info->threads_given)
+    write_into_file(outfile, "threads", args_info->threads_orig, 0);
+  if (args_info->processes_given)
+    write_into_file(outfile, "processes", args_info->processes_orig, 0);
+  if (args_info->temporal_depth_given)
+    write_into_file(outfile, "temporal_depth", args_info->temporal_depth_orig, 0);
+  if (args_info->step_given)
+    write_into_file(outfile, "step", args_info->step_orig, 0);
+  if (args_info->hashlife_memory_given)
+    write_into_file(outfile, "hashlife_memory", args_info->hashlife_memory_orig, 0);
+  if (args_info->benchmark_given)
+    write_into_file(outfile, "benchmark", 0, 0 );
+  if (args_info->warmup_given)
+    write_into_file(outfile, "warmup", args_info->warmup_orig, 0);
+  if (args_info->bench_format_given)
+    write_into_file(outfile, "bench_format", args_info->bench_format_orig, cmdline_parser_bench_format_values);
+  if (args_info->seed_given)
+    write_into_file(outfile, "seed", args_info->seed_orig, 0);
+  if (args_info->density_given)
+    write_into_file(outfile, "density", args_info->density_orig, 0);
+  if (args_info->output_given)
+    write_into_file(outfile, "output", args_info->output_orig, 0);
+  if (args_info->checkpoint_given)
+    write_into_file(outfile, "checkpoint", args_info->checkpoint_orig, 0);
+  if (args_info->checkpoint_every_given)
+    write_into_file(outfile, "checkpoint_every", args_info->checkpoint_every_orig, 0);
+  if (args_info->restore_given)
+    write_into_file(outfile, "restore", args_info->restore_orig, 0);
+  if (args_info->record_given)
+    write_into_file(outfile, "record", args_info->record_orig, 0);
+  if (args_info->keyframe_every_given)
+    write_into_file(outfile, "keyframe_every", args_info->keyframe_every_orig, 0);
+  if (args_info->replay_given)
+    write_into_file(outfile, "replay", args_info->replay_orig, 0);
+  if (args_info->seek_given)
+    write_into_file(outfile, "seek", args_info->seek_orig, 0);
+  if (args_info->stats_given)
+    write_into_file(outfile, "stats", args_info->stats_orig, 0);
+  if (args_info->trace_given)
+    write_into_file(outfile, "trace", args_info->trace_orig, 0);
+  if (args_info->ensemble_given)
+    write_into_file(outfile, "ensemble", args_info->ensemble_orig, 0);
+  if (args_info->cycle_window_given)
+    write_into_file(outfile, "cycle_window", args_info->cycle_window_orig, 0);
   
 
   i = EXIT_SUCCESS;
@@ -396,7 +669,18 @@ int update_arg(void *field, char **orig_field,
       return 1; /* failure */
     }
 
-  FIX_UNUSED (default_value);
+  if (possible_values && (found = check_possible_values((value ? value : default_value), possible_values)) < 0)
+    {
+      if (short_opt != '-')
+        fprintf (stderr, "%s: %s argument, \"%s\", for option `--%s' (`-%c')%s\n", 
+          package_name, (found == -2) ? "ambiguous" : "invalid", value, long_opt, short_opt,
+          (additional_error ? additional_error : ""));
+      else
+        fprintf (stderr, "%s: %s argument, \"%s\", for option `--%s'%s\n", 
+          package_name, (found == -2) ? "ambiguous" : "invalid", value, long_opt,
+          (additional_error ? additional_error : ""));
+      return 1; /* failure */
+    }
     
   if (field_given && *field_given && ! override)
     return 0;
@@ -408,9 +692,18 @@ int update_arg(void *field, char **orig_field,
     val = possible_values[found];
 
   switch(arg_type) {
+  case ARG_FLAG:
+    *((int *)field) = !*((int *)field);
+    break;
   case ARG_INT:
     if (val) *((int *)field) = strtol (val, &stop_char, 0);
     break;
+  case ARG_LONG:
+    if (val) *((long *)field) = (long)strtol (val, &stop_char, 0);
+    break;
+  case ARG_DOUBLE:
+    if (val) *((double *)field) = strtod (val, &stop_char);
+    break;
   case ARG_STRING:
     if (val) {
       string_field = (char **)field;
@@ -426,6 +719,8 @@ int update_arg(void *field, char **orig_field,
   /* check numeric conversion */
   switch(arg_type) {
   case ARG_INT:
+  case ARG_LONG:
+  case ARG_DOUBLE:
     if (val && !(stop_char && *stop_char == '\0')) {
       fprintf(stderr, "%s: invalid numeric value: %s\n", package_name, val);
       return 1; /* failure */
@@ -438,6 +733,7 @@ int update_arg(void *field, char **orig_field,
   /* store the original value */
   switch(arg_type) {
   case ARG_NO:
+  case ARG_FLAG:
     break;
   default:
     if (value && orig_field) {
@@ -503,12 +799,39 @@ cmdline_parser_internal (
         { "width",	1, NULL, 'w' },
         { "height",	1, NULL, 'h' },
         { "display_time",	1, NULL, 'd' },
+        { "fps",	1, NULL, 0 },
         { "iter",	1, NULL, 'i' },
         { "file",	1, NULL, 'f' },
+        { "rule",	1, NULL, 'r' },
+        { "engine",	1, NULL, 'e' },
+        { "isa",	1, NULL, 0 },
+        { "boundary",	1, NULL, 0 },
+        { "threads",	1, NULL, 't' },
+        { "processes",	1, NULL, 0 },
+        { "temporal_depth",	1, NULL, 0 },
+        { "step",	1, NULL, 's' },
+        { "hashlife_memory",	1, NULL, 0 },
+        { "benchmark",	0, NULL, 'b' },
+        { "warmup",	1, NULL, 0 },
+        { "bench_format",	1, NULL, 0 },
+        { "seed",	1, NULL, 0 },
+        { "density",	1, NULL, 0 },
+        { "output",	1, NULL, 'o' },
+        { "checkpoint",	1, NULL, 0 },
+        { "checkpoint_every",	1, NULL, 0 },
+        { "restore",	1, NULL, 0 },
+        { "record",	1, NULL, 0 },
+        { "keyframe_every",	1, NULL, 0 },
+        { "replay",	1, NULL, 0 },
+        { "seek",	1, NULL, 0 },
+        { "stats",	1, NULL, 0 },
+        { "trace",	1, NULL, 0 },
+        { "ensemble",	1, NULL, 0 },
+        { "cycle_window",	1, NULL, 0 },
         { 0,  0, 0, 0 }
       };
 
-      c = getopt_long (argc, argv, "Vw:h:d:i:f:", long_options, &option_index);
+      c = getopt_long (argc, argv, "Vw:h:d:i:f:r:e:t:s:bo:", long_options, &option_index);
 
       if (c == -1) break;	/* Exit from `while (1)' loop.  */
 
@@ -567,7 +890,7 @@ cmdline_parser_internal (
             goto failure;
         
           break;
-        case 'f':	/* Fullpath to file with initial Game of Life state (width and height options are ignored when this is on).  */
+        case 'f':	/* Fullpath to file with initial Game of Life state, plaintext or RLE format (width and height options are ignored when this is on).  */
         
         
           if (update_arg( (void *)&(args_info->file_arg), 
@@ -579,6 +902,76 @@ cmdline_parser_internal (
             goto failure;
         
           break;
+        case 'r':	/* Rule in B/S notation (eg. B36/S23 for HighLife, B3678/S34678 for Day & Night, B2/S for Seeds), overrides the rule of RLE and checkpoint files (default: B3/S23, Conway's Game of Life).  */
+        
+        
+          if (update_arg( (void *)&(args_info->rule_arg), 
+               &(args_info->rule_orig), &(args_info->rule_given),
+              &(local_args_info.rule_given), optarg, 0, 0, ARG_STRING,
+              check_ambiguity, override, 0, 0,
+              "rule", 'r',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'e':	/* Simulation engine (byte: reference grid with one byte per cell, packed: 64 cells per 64-bit word updated with bitwise operations, simd: byte grid updated 16/32/64 cells at once with SSE2/AVX2/AVX-512, hashlife: memoized quadtree simulating the unbounded plane, the grid being the displayed window, tiled: packed grid where only 64x64 tiles that changed during last generation and their neighbours are computed, block: packed grid computed 2x2 cells at once by looking up their 4x4 neighbourhood in a 65536 entries table, sparse: unbounded plane stored as a hash map of 64x64 chunks allocated when activity reaches them and freed once empty, the grid being the displayed window, distributed: packed grid split in horizontal bands computed by worker processes exchanging their boundary rows every generation, temporal: packed grid advanced temporal_depth generations per pass over memory in cache resident tiles).  */
+        
+        
+          if (update_arg( (void *)&(args_info->engine_arg), 
+               &(args_info->engine_orig), &(args_info->engine_given),
+              &(local_args_info.engine_given), optarg, cmdline_parser_engine_values, "byte", ARG_STRING,
+              check_ambiguity, override, 0, 0,
+              "engine", 'e',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 't':	/* Number of threads computing each generation (grid is split in horizontal bands of rows).  */
+        
+        
+          if (update_arg( (void *)&(args_info->threads_arg), 
+               &(args_info->threads_orig), &(args_info->threads_given),
+              &(local_args_info.threads_given), optarg, 0, "1", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "threads", 't',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 's':	/* Number of generations computed between two displayed iterations (hashlife engine computes power of 2 steps in a single jump).  */
+        
+        
+          if (update_arg( (void *)&(args_info->step_arg), 
+               &(args_info->step_orig), &(args_info->step_given),
+              &(local_args_info.step_given), optarg, 0, "1", ARG_LONG,
+              check_ambiguity, override, 0, 0,
+              "step", 's',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'b':	/* Headless benchmark: no display nor sleep, warmup generations are computed then iter generations are timed.  */
+        
+        
+          if (update_arg((void *)&(args_info->benchmark_flag), 0, &(args_info->benchmark_given),
+              &(local_args_info.benchmark_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "benchmark", 'b',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'o':	/* Fullpath to file receiving last Game of Life state (RLE format if file name ends with .rle, plaintext format otherwise).  */
+        
+        
+          if (update_arg( (void *)&(args_info->output_arg), 
+               &(args_info->output_orig), &(args_info->output_given),
+              &(local_args_info.output_given), optarg, 0, 0, ARG_STRING,
+              check_ambiguity, override, 0, 0,
+              "output", 'o',
+              additional_error))
+            goto failure;
+        
+          break;
 
         case 0:	/* Long option with no short option */
           if (strcmp (long_options[option_index].name, "help") == 0) {
@@ -587,6 +980,302 @@ cmdline_parser_internal (
             exit (EXIT_SUCCESS);
           }
 
+          /* Display rate in frames per second (overrides display_time), frames are skipped when display falls behind.  */
+          if (strcmp (long_options[option_index].name, "fps") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->fps_arg), 
+                 &(args_info->fps_orig), &(args_info->fps_given),
+                &(local_args_info.fps_given), optarg, 0, 0, ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "fps", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Instruction set of simd engine kernel (auto: widest one supported by the CPU).  */
+          else if (strcmp (long_options[option_index].name, "isa") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->isa_arg), 
+                 &(args_info->isa_orig), &(args_info->isa_given),
+                &(local_args_info.isa_given), optarg, cmdline_parser_isa_values, "auto", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "isa", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Cells outside the grid (dead: always dead, torus: grid edges wrap around, not supported by hashlife and sparse engines), overrides the boundary of checkpoint and recording files.  */
+          else if (strcmp (long_options[option_index].name, "boundary") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->boundary_arg), 
+                 &(args_info->boundary_orig), &(args_info->boundary_given),
+                &(local_args_info.boundary_given), optarg, cmdline_parser_boundary_values, "dead", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "boundary", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Number of worker processes of distributed engine (one band of rows each).  */
+          else if (strcmp (long_options[option_index].name, "processes") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->processes_arg), 
+                 &(args_info->processes_orig), &(args_info->processes_given),
+                &(local_args_info.processes_given), optarg, 0, "2", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "processes", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Number of generations computed per pass over memory by temporal engine (1 to 64, tiles are loaded with a ghost zone as deep).  */
+          else if (strcmp (long_options[option_index].name, "temporal_depth") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->temporal_depth_arg), 
+                 &(args_info->temporal_depth_orig), &(args_info->temporal_depth_given),
+                &(local_args_info.temporal_depth_given), optarg, 0, "8", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "temporal_depth", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Memory budget of hashlife engine node cache in MiB (unused nodes are garbage collected when it is reached).  */
+          else if (strcmp (long_options[option_index].name, "hashlife_memory") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->hashlife_memory_arg), 
+                 &(args_info->hashlife_memory_orig), &(args_info->hashlife_memory_given),
+                &(local_args_info.hashlife_memory_given), optarg, 0, "512", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "hashlife_memory", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Number of generations computed before timing in benchmark mode.  */
+          else if (strcmp (long_options[option_index].name, "warmup") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->warmup_arg), 
+                 &(args_info->warmup_orig), &(args_info->warmup_given),
+                &(local_args_info.warmup_given), optarg, 0, "10", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "warmup", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Benchmark report format.  */
+          else if (strcmp (long_options[option_index].name, "bench_format") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->bench_format_arg), 
+                 &(args_info->bench_format_orig), &(args_info->bench_format_given),
+                &(local_args_info.bench_format_given), optarg, cmdline_parser_bench_format_values, "text", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "bench_format", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Seed of the random initial grid (same seed gives the same grid whatever the number of threads).  */
+          else if (strcmp (long_options[option_index].name, "seed") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->seed_arg), 
+                 &(args_info->seed_orig), &(args_info->seed_given),
+                &(local_args_info.seed_given), optarg, 0, "1", ARG_LONG,
+                check_ambiguity, override, 0, 0,
+                "seed", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Probability of a cell of the random initial grid to be alive.  */
+          else if (strcmp (long_options[option_index].name, "density") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->density_arg), 
+                 &(args_info->density_orig), &(args_info->density_given),
+                &(local_args_info.density_given), optarg, 0, "0.5", ARG_DOUBLE,
+                check_ambiguity, override, 0, 0,
+                "density", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Checkpoint file written every checkpoint_every generations.  */
+          else if (strcmp (long_options[option_index].name, "checkpoint") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->checkpoint_arg), 
+                 &(args_info->checkpoint_orig), &(args_info->checkpoint_given),
+                &(local_args_info.checkpoint_given), optarg, 0, "gameoflife.ckpt", ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "checkpoint", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Number of generations between two checkpoints (0 disables checkpoints).  */
+          else if (strcmp (long_options[option_index].name, "checkpoint_every") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->checkpoint_every_arg), 
+                 &(args_info->checkpoint_every_orig), &(args_info->checkpoint_every_given),
+                &(local_args_info.checkpoint_every_given), optarg, 0, "0", ARG_LONG,
+                check_ambiguity, override, 0, 0,
+                "checkpoint_every", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Resume run from checkpoint file.  */
+          else if (strcmp (long_options[option_index].name, "restore") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->restore_arg), 
+                 &(args_info->restore_orig), &(args_info->restore_given),
+                &(local_args_info.restore_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "restore", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Recording file receiving the initial grid then every computed generation (keyframes and deltas of changed cells, written by a background thread).  */
+          else if (strcmp (long_options[option_index].name, "record") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->record_arg), 
+                 &(args_info->record_orig), &(args_info->record_given),
+                &(local_args_info.record_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "record", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Maximum number of generations between two keyframes of the recording (replay decodes at most that many deltas).  */
+          else if (strcmp (long_options[option_index].name, "keyframe_every") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->keyframe_every_arg), 
+                 &(args_info->keyframe_every_orig), &(args_info->keyframe_every_given),
+                &(local_args_info.keyframe_every_given), optarg, 0, "100", ARG_LONG,
+                check_ambiguity, override, 0, 0,
+                "keyframe_every", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Resume run from the generation given by seek of a recording file.  */
+          else if (strcmp (long_options[option_index].name, "replay") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->replay_arg), 
+                 &(args_info->replay_orig), &(args_info->replay_given),
+                &(local_args_info.replay_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "replay", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Generation of the replay recording to load (negative: last recorded generation).  */
+          else if (strcmp (long_options[option_index].name, "seek") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->seek_arg), 
+                 &(args_info->seek_orig), &(args_info->seek_given),
+                &(local_args_info.seek_given), optarg, 0, "-1", ARG_LONG,
+                check_ambiguity, override, 0, 0,
+                "seek", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Statistics file receiving one JSON line per step (population, births, deaths, bounding box of live cells and wall time) then a summary line with step time percentiles.  */
+          else if (strcmp (long_options[option_index].name, "stats") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->stats_arg), 
+                 &(args_info->stats_orig), &(args_info->stats_given),
+                &(local_args_info.stats_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "stats", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Trace file receiving timing spans of each phase (load, generate, step, display, sleep) and of each worker thread in Chrome trace-event JSON (chrome://tracing, Perfetto).  */
+          else if (strcmp (long_options[option_index].name, "trace") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->trace_arg), 
+                 &(args_info->trace_orig), &(args_info->trace_given),
+                &(local_args_info.trace_given), optarg, 0, 0, ARG_STRING,
+                check_ambiguity, override, 0, 0,
+                "trace", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Run that many independent random boards of width x height together (64 boards per 64-bit word, engine option is ignored) and print per-board statistics as CSV (board, initial and final population, status: extinct, still, period2 or active, and the generation it holds since), throughput being reported on stderr.  */
+          else if (strcmp (long_options[option_index].name, "ensemble") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->ensemble_arg), 
+                 &(args_info->ensemble_orig), &(args_info->ensemble_given),
+                &(local_args_info.ensemble_given), optarg, 0, 0, ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "ensemble", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          /* Number of past generations compared with each new one to detect extinction, still lifes and cycles, the run stops early when the grid repeats (0 disables detection).  */
+          else if (strcmp (long_options[option_index].name, "cycle_window") == 0)
+          {
+          
+          
+            if (update_arg( (void *)&(args_info->cycle_window_arg), 
+                 &(args_info->cycle_window_orig), &(args_info->cycle_window_given),
+                &(local_args_info.cycle_window_given), optarg, 0, "0", ARG_INT,
+                check_ambiguity, override, 0, 0,
+                "cycle_window", '-',
+                additional_error))
+              goto failure;
+          
+          }
+          
+          break;
         case '?':	/* Invalid option.  */
           /* `getopt_long' already printed an error message.  */
           goto failure;
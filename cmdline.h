@@ -48,20 +48,127 @@ struct gengetopt_args_info
   int display_time_arg;	/**< @brief Display time of a single iteration in seconds (default='1').  */
   char * display_time_orig;	/**< @brief Display time of a single iteration in seconds original value given at command line.  */
   const char *display_time_help; /**< @brief Display time of a single iteration in seconds help description.  */
+  double fps_arg;	/**< @brief Display rate in frames per second (overrides display_time), frames are skipped when display falls behind.  */
+  char * fps_orig;	/**< @brief Display rate in frames per second (overrides display_time), frames are skipped when display falls behind original value given at command line.  */
+  const char *fps_help; /**< @brief Display rate in frames per second (overrides display_time), frames are skipped when display falls behind help description.  */
   int iter_arg;	/**< @brief Number of iteration (default='10').  */
   char * iter_orig;	/**< @brief Number of iteration original value given at command line.  */
   const char *iter_help; /**< @brief Number of iteration help description.  */
-  char * file_arg;	/**< @brief Fullpath to file with initial Game of Life state (width and height options are ignored when this is on).  */
-  char * file_orig;	/**< @brief Fullpath to file with initial Game of Life state (width and height options are ignored when this is on) original value given at command line.  */
-  const char *file_help; /**< @brief Fullpath to file with initial Game of Life state (width and height options are ignored when this is on) help description.  */
+  char * file_arg;	/**< @brief Fullpath to file with initial Game of Life state, plaintext or RLE format (width and height options are ignored when this is on).  */
+  char * file_orig;	/**< @brief Fullpath to file with initial Game of Life state, plaintext or RLE format (width and height options are ignored when this is on) original value given at command line.  */
+  const char *file_help; /**< @brief Fullpath to file with initial Game of Life state, plaintext or RLE format (width and height options are ignored when this is on) help description.  */
+  char * rule_arg;	/**< @brief Rule in B/S notation (eg. B36/S23 for HighLife, B3678/S34678 for Day & Night, B2/S for Seeds), overrides the rule of RLE and checkpoint files (default: B3/S23, Conway's Game of Life).  */
+  char * rule_orig;	/**< @brief Rule in B/S notation (eg. B36/S23 for HighLife, B3678/S34678 for Day & Night, B2/S for Seeds), overrides the rule of RLE and checkpoint files (default: B3/S23, Conway's Game of Life) original value given at command line.  */
+  const char *rule_help; /**< @brief Rule in B/S notation (eg. B36/S23 for HighLife, B3678/S34678 for Day & Night, B2/S for Seeds), overrides the rule of RLE and checkpoint files (default: B3/S23, Conway's Game of Life) help description.  */
+  char * engine_arg;	/**< @brief Simulation engine (byte: reference grid with one byte per cell, packed: 64 cells per 64-bit word updated with bitwise operations, simd: byte grid updated 16/32/64 cells at once with SSE2/AVX2/AVX-512, hashlife: memoized quadtree simulating the unbounded plane, the grid being the displayed window, tiled: packed grid where only 64x64 tiles that changed during last generation and their neighbours are computed, block: packed grid computed 2x2 cells at once by looking up their 4x4 neighbourhood in a 65536 entries table, sparse: unbounded plane stored as a hash map of 64x64 chunks allocated when activity reaches them and freed once empty, the grid being the displayed window, distributed: packed grid split in horizontal bands computed by worker processes exchanging their boundary rows every generation, temporal: packed grid advanced temporal_depth generations per pass over memory in cache resident tiles) (default='byte').  */
+  char * engine_orig;	/**< @brief Simulation engine (byte: reference grid with one byte per cell, packed: 64 cells per 64-bit word updated with bitwise operations, simd: byte grid updated 16/32/64 cells at once with SSE2/AVX2/AVX-512, hashlife: memoized quadtree simulating the unbounded plane, the grid being the displayed window, tiled: packed grid where only 64x64 tiles that changed during last generation and their neighbours are computed, block: packed grid computed 2x2 cells at once by looking up their 4x4 neighbourhood in a 65536 entries table, sparse: unbounded plane stored as a hash map of 64x64 chunks allocated when activity reaches them and freed once empty, the grid being the displayed window, distributed: packed grid split in horizontal bands computed by worker processes exchanging their boundary rows every generation, temporal: packed grid advanced temporal_depth generations per pass over memory in cache resident tiles) original value given at command line.  */
+  const char *engine_help; /**< @brief Simulation engine (byte: reference grid with one byte per cell, packed: 64 cells per 64-bit word updated with bitwise operations, simd: byte grid updated 16/32/64 cells at once with SSE2/AVX2/AVX-512, hashlife: memoized quadtree simulating the unbounded plane, the grid being the displayed window, tiled: packed grid where only 64x64 tiles that changed during last generation and their neighbours are computed, block: packed grid computed 2x2 cells at once by looking up their 4x4 neighbourhood in a 65536 entries table, sparse: unbounded plane stored as a hash map of 64x64 chunks allocated when activity reaches them and freed once empty, the grid being the displayed window, distributed: packed grid split in horizontal bands computed by worker processes exchanging their boundary rows every generation, temporal: packed grid advanced temporal_depth generations per pass over memory in cache resident tiles) help description.  */
+  char * isa_arg;	/**< @brief Instruction set of simd engine kernel (auto: widest one supported by the CPU) (default='auto').  */
+  char * isa_orig;	/**< @brief Instruction set of simd engine kernel (auto: widest one supported by the CPU) original value given at command line.  */
+  const char *isa_help; /**< @brief Instruction set of simd engine kernel (auto: widest one supported by the CPU) help description.  */
+  char * boundary_arg;	/**< @brief Cells outside the grid (dead: always dead, torus: grid edges wrap around, not supported by hashlife and sparse engines), overrides the boundary of checkpoint and recording files (default='dead').  */
+  char * boundary_orig;	/**< @brief Cells outside the grid (dead: always dead, torus: grid edges wrap around, not supported by hashlife and sparse engines), overrides the boundary of checkpoint and recording files original value given at command line.  */
+  const char *boundary_help; /**< @brief Cells outside the grid (dead: always dead, torus: grid edges wrap around, not supported by hashlife and sparse engines), overrides the boundary of checkpoint and recording files help description.  */
+  int threads_arg;	/**< @brief Number of threads computing each generation (grid is split in horizontal bands of rows) (default='1').  */
+  char * threads_orig;	/**< @brief Number of threads computing each generation (grid is split in horizontal bands of rows) original value given at command line.  */
+  const char *threads_help; /**< @brief Number of threads computing each generation (grid is split in horizontal bands of rows) help description.  */
+  int processes_arg;	/**< @brief Number of worker processes of distributed engine (one band of rows each) (default='2').  */
+  char * processes_orig;	/**< @brief Number of worker processes of distributed engine (one band of rows each) original value given at command line.  */
+  const char *processes_help; /**< @brief Number of worker processes of distributed engine (one band of rows each) help description.  */
+  int temporal_depth_arg;	/**< @brief Number of generations computed per pass over memory by temporal engine (1 to 64, tiles are loaded with a ghost zone as deep) (default='8').  */
+  char * temporal_depth_orig;	/**< @brief Number of generations computed per pass over memory by temporal engine (1 to 64, tiles are loaded with a ghost zone as deep) original value given at command line.  */
+  const char *temporal_depth_help; /**< @brief Number of generations computed per pass over memory by temporal engine (1 to 64, tiles are loaded with a ghost zone as deep) help description.  */
+  long step_arg;	/**< @brief Number of generations computed between two displayed iterations (hashlife engine computes power of 2 steps in a single jump) (default='1').  */
+  char * step_orig;	/**< @brief Number of generations computed between two displayed iterations (hashlife engine computes power of 2 steps in a single jump) original value given at command line.  */
+  const char *step_help; /**< @brief Number of generations computed between two displayed iterations (hashlife engine computes power of 2 steps in a single jump) help description.  */
+  int hashlife_memory_arg;	/**< @brief Memory budget of hashlife engine node cache in MiB (unused nodes are garbage collected when it is reached) (default='512').  */
+  char * hashlife_memory_orig;	/**< @brief Memory budget of hashlife engine node cache in MiB (unused nodes are garbage collected when it is reached) original value given at command line.  */
+  const char *hashlife_memory_help; /**< @brief Memory budget of hashlife engine node cache in MiB (unused nodes are garbage collected when it is reached) help description.  */
+  int benchmark_flag;	/**< @brief Headless benchmark: no display nor sleep, warmup generations are computed then iter generations are timed (default=off).  */
+  const char *benchmark_help; /**< @brief Headless benchmark: no display nor sleep, warmup generations are computed then iter generations are timed help description.  */
+  int warmup_arg;	/**< @brief Number of generations computed before timing in benchmark mode (default='10').  */
+  char * warmup_orig;	/**< @brief Number of generations computed before timing in benchmark mode original value given at command line.  */
+  const char *warmup_help; /**< @brief Number of generations computed before timing in benchmark mode help description.  */
+  char * bench_format_arg;	/**< @brief Benchmark report format (default='text').  */
+  char * bench_format_orig;	/**< @brief Benchmark report format original value given at command line.  */
+  const char *bench_format_help; /**< @brief Benchmark report format help description.  */
+  long seed_arg;	/**< @brief Seed of the random initial grid (same seed gives the same grid whatever the number of threads) (default='1').  */
+  char * seed_orig;	/**< @brief Seed of the random initial grid (same seed gives the same grid whatever the number of threads) original value given at command line.  */
+  const char *seed_help; /**< @brief Seed of the random initial grid (same seed gives the same grid whatever the number of threads) help description.  */
+  double density_arg;	/**< @brief Probability of a cell of the random initial grid to be alive (default='0.5').  */
+  char * density_orig;	/**< @brief Probability of a cell of the random initial grid to be alive original value given at command line.  */
+  const char *density_help; /**< @brief Probability of a cell of the random initial grid to be alive help description.  */
+  char * output_arg;	/**< @brief Fullpath to file receiving last Game of Life state (RLE format if file name ends with .rle, plaintext format otherwise).  */
+  char * output_orig;	/**< @brief Fullpath to file receiving last Game of Life state (RLE format if file name ends with .rle, plaintext format otherwise) original value given at command line.  */
+  const char *output_help; /**< @brief Fullpath to file receiving last Game of Life state (RLE format if file name ends with .rle, plaintext format otherwise) help description.  */
+  char * checkpoint_arg;	/**< @brief Checkpoint file written every checkpoint_every generations (default='gameoflife.ckpt').  */
+  char * checkpoint_orig;	/**< @brief Checkpoint file written every checkpoint_every generations original value given at command line.  */
+  const char *checkpoint_help; /**< @brief Checkpoint file written every checkpoint_every generations help description.  */
+  long checkpoint_every_arg;	/**< @brief Number of generations between two checkpoints (0 disables checkpoints) (default='0').  */
+  char * checkpoint_every_orig;	/**< @brief Number of generations between two checkpoints (0 disables checkpoints) original value given at command line.  */
+  const char *checkpoint_every_help; /**< @brief Number of generations between two checkpoints (0 disables checkpoints) help description.  */
+  char * restore_arg;	/**< @brief Resume run from checkpoint file.  */
+  char * restore_orig;	/**< @brief Resume run from checkpoint file original value given at command line.  */
+  const char *restore_help; /**< @brief Resume run from checkpoint file help description.  */
+  char * record_arg;	/**< @brief Recording file receiving the initial grid then every computed generation (keyframes and deltas of changed cells, written by a background thread).  */
+  char * record_orig;	/**< @brief Recording file receiving the initial grid then every computed generation (keyframes and deltas of changed cells, written by a background thread) original value given at command line.  */
+  const char *record_help; /**< @brief Recording file receiving the initial grid then every computed generation (keyframes and deltas of changed cells, written by a background thread) help description.  */
+  long keyframe_every_arg;	/**< @brief Maximum number of generations between two keyframes of the recording (replay decodes at most that many deltas) (default='100').  */
+  char * keyframe_every_orig;	/**< @brief Maximum number of generations between two keyframes of the recording (replay decodes at most that many deltas) original value given at command line.  */
+  const char *keyframe_every_help; /**< @brief Maximum number of generations between two keyframes of the recording (replay decodes at most that many deltas) help description.  */
+  char * replay_arg;	/**< @brief Resume run from the generation given by seek of a recording file.  */
+  char * replay_orig;	/**< @brief Resume run from the generation given by seek of a recording file original value given at command line.  */
+  const char *replay_help; /**< @brief Resume run from the generation given by seek of a recording file help description.  */
+  long seek_arg;	/**< @brief Generation of the replay recording to load (negative: last recorded generation) (default='-1').  */
+  char * seek_orig;	/**< @brief Generation of the replay recording to load (negative: last recorded generation) original value given at command line.  */
+  const char *seek_help; /**< @brief Generation of the replay recording to load (negative: last recorded generation) help description.  */
+  char * stats_arg;	/**< @brief Statistics file receiving one JSON line per step (population, births, deaths, bounding box of live cells and wall time) then a summary line with step time percentiles.  */
+  char * stats_orig;	/**< @brief Statistics file receiving one JSON line per step (population, births, deaths, bounding box of live cells and wall time) then a summary line with step time percentiles original value given at command line.  */
+  const char *stats_help; /**< @brief Statistics file receiving one JSON line per step (population, births, deaths, bounding box of live cells and wall time) then a summary line with step time percentiles help description.  */
+  char * trace_arg;	/**< @brief Trace file receiving timing spans of each phase (load, generate, step, display, sleep) and of each worker thread in Chrome trace-event JSON (chrome://tracing, Perfetto).  */
+  char * trace_orig;	/**< @brief Trace file receiving timing spans of each phase (load, generate, step, display, sleep) and of each worker thread in Chrome trace-event JSON (chrome://tracing, Perfetto) original value given at command line.  */
+  const char *trace_help; /**< @brief Trace file receiving timing spans of each phase (load, generate, step, display, sleep) and of each worker thread in Chrome trace-event JSON (chrome://tracing, Perfetto) help description.  */
+  int ensemble_arg;	/**< @brief Run that many independent random boards of width x height together (64 boards per 64-bit word, engine option is ignored) and print per-board statistics as CSV (board, initial and final population, status: extinct, still, period2 or active, and the generation it holds since), throughput being reported on stderr.  */
+  char * ensemble_orig;	/**< @brief Run that many independent random boards of width x height together (64 boards per 64-bit word, engine option is ignored) and print per-board statistics as CSV (board, initial and final population, status: extinct, still, period2 or active, and the generation it holds since), throughput being reported on stderr original value given at command line.  */
+  const char *ensemble_help; /**< @brief Run that many independent random boards of width x height together (64 boards per 64-bit word, engine option is ignored) and print per-board statistics as CSV (board, initial and final population, status: extinct, still, period2 or active, and the generation it holds since), throughput being reported on stderr help description.  */
+  int cycle_window_arg;	/**< @brief Number of past generations compared with each new one to detect extinction, still lifes and cycles, the run stops early when the grid repeats (0 disables detection) (default='0').  */
+  char * cycle_window_orig;	/**< @brief Number of past generations compared with each new one to detect extinction, still lifes and cycles, the run stops early when the grid repeats (0 disables detection) original value given at command line.  */
+  const char *cycle_window_help; /**< @brief Number of past generations compared with each new one to detect extinction, still lifes and cycles, the run stops early when the grid repeats (0 disables detection) help description.  */
   
   unsigned int help_given ;	/**< @brief Whether help was given.  */
   unsigned int version_given ;	/**< @brief Whether version was given.  */
   unsigned int width_given ;	/**< @brief Whether width was given.  */
   unsigned int height_given ;	/**< @brief Whether height was given.  */
   unsigned int display_time_given ;	/**< @brief Whether display_time was given.  */
+  unsigned int fps_given ;	/**< @brief Whether fps was given.  */
   unsigned int iter_given ;	/**< @brief Whether iter was given.  */
   unsigned int file_given ;	/**< @brief Whether file was given.  */
+  unsigned int rule_given ;	/**< @brief Whether rule was given.  */
+  unsigned int engine_given ;	/**< @brief Whether engine was given.  */
+  unsigned int isa_given ;	/**< @brief Whether isa was given.  */
+  unsigned int boundary_given ;	/**< @brief Whether boundary was given.  */
+  unsigned int threads_given ;	/**< @brief Whether threads was given.  */
+  unsigned int processes_given ;	/**< @brief Whether processes was given.  */
+  unsigned int temporal_depth_given ;	/**< @brief Whether temporal_depth was given.  */
+  unsigned int step_given ;	/**< @brief Whether step was given.  */
+  unsigned int hashlife_memory_given ;	/**< @brief Whether hashlife_memory was given.  */
+  unsigned int benchmark_given ;	/**< @brief Whether benchmark was given.  */
+  unsigned int warmup_given ;	/**< @brief Whether warmup was given.  */
+  unsigned int bench_format_given ;	/**< @brief Whether bench_format was given.  */
+  unsigned int seed_given ;	/**< @brief Whether seed was given.  */
+  unsigned int density_given ;	/**< @brief Whether density was given.  */
+  unsigned int output_given ;	/**< @brief Whether output was given.  */
+  unsigned int checkpoint_given ;	/**< @brief Whether checkpoint was given.  */
+  unsigned int checkpoint_every_given ;	/**< @brief Whether checkpoint_every was given.  */
+  unsigned int restore_given ;	/**< @brief Whether restore was given.  */
+  unsigned int record_given ;	/**< @brief Whether record was given.  */
+  unsigned int keyframe_every_given ;	/**< @brief Whether keyframe_every was given.  */
+  unsigned int replay_given ;	/**< @brief Whether replay was given.  */
+  unsigned int seek_given ;	/**< @brief Whether seek was given.  */
+  unsigned int stats_given ;	/**< @brief Whether stats was given.  */
+  unsigned int trace_given ;	/**< @brief Whether trace was given.  */
+  unsigned int ensemble_given ;	/**< @brief Whether ensemble was given.  */
+  unsigned int cycle_window_given ;	/**< @brief Whether cycle_window was given.  */
 
 } ;
 
@@ -186,6 +293,11 @@ void cmdline_parser_free (struct gengetopt_args_info *args_info);
 int cmdline_parser_required (struct gengetopt_args_info *args_info,
   const char *prog_name);
 
+extern const char *cmdline_parser_engine_values[];  /**< @brief Possible values for engine. */
+extern const char *cmdline_parser_isa_values[];  /**< @brief Possible values for isa. */
+extern const char *cmdline_parser_boundary_values[];  /**< @brief Possible values for boundary. */
+extern const char *cmdline_parser_bench_format_values[];  /**< @brief Possible values for bench_format. */
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,149 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycle.h"
+
+uint64_t hash_bytes(const void *buf, size_t len) {
+  const unsigned char *bytes = (const unsigned char *)buf;
+  uint64_t hash = FNV_OFFSET;
+  size_t k = 0;
+  for (; k + 8 <= len; k += 8) {
+    uint64_t word;
+    memcpy(&word, bytes + k, 8);
+    hash = (hash ^ word) * FNV_PRIME;
+  }
+  if (k < len) {
+    uint64_t word = 0;
+    memcpy(&word, bytes + k, len - k);
+    hash = (hash ^ word) * FNV_PRIME;
+  }
+  return hash;
+}
+
+uint64_t hash_part(uint64_t hash, uint64_t pos) {
+  // SplitMix64 finalizer, so that summed parts do not cancel out
+  uint64_t z = hash + (pos + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t hash_words(const uint64_t *words, size_t n, uint64_t pos) {
+  // word k is folded into lane k % 4: lanes do not wait for each other's
+  // multiplies
+  uint64_t lanes[4] = {FNV_OFFSET, FNV_OFFSET, FNV_OFFSET, FNV_OFFSET};
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    for (int l = 0; l < 4; l++) {
+      lanes[l] = hash_fold(lanes[l], words[k + l]);
+    }
+  }
+  for (; k < n; k++) {
+    lanes[k % 4] = hash_fold(lanes[k % 4], words[k]);
+  }
+  uint64_t hash = lanes[0];
+  for (int l = 1; l < 4; l++) {
+    hash = hash_fold(hash, lanes[l]);
+  }
+  return hash_part(hash, pos);
+}
+
+uint64_t hash_cells(const unsigned char *cells, size_t n, uint64_t pos) {
+  uint64_t hash = FNV_OFFSET;
+  size_t j = 0;
+  for (; j + 64 <= n; j += 64) {
+    uint64_t word = 0;
+#ifdef __SSE2__
+    for (int k = 0; k < 4; k++) {
+      // cells are 0 or 1: shifted to the top bit of their byte, which
+      // movemask gathers
+      __m128i v = _mm_loadu_si128((const __m128i *)(cells + j + 16 * k));
+      word |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_slli_epi64(v, 7))
+              << (16 * k);
+    }
+#else
+    for (int k = 0; k < 8; k++) {
+      // cells are 0 or 1: the multiply gathers the low bits of 8 bytes
+      // (first byte lowest) in the top byte
+      uint64_t x;
+      memcpy(&x, cells + j + 8 * k, sizeof(x));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      x = __builtin_bswap64(x);
+#endif
+      word |= (x * 0x0102040810204080ULL) >> 56 << (8 * k);
+    }
+#endif
+    hash = hash_fold(hash, word);
+  }
+  if (j < n) {
+    uint64_t word = 0;
+    for (size_t k = j; k < n; k++) {
+      word |= (uint64_t)cells[k] << (k - j);
+    }
+    hash = hash_fold(hash, word);
+  }
+  return hash_part(hash, pos);
+}
+
+CycleDetector_t *cycle_detector_init(int window) {
+  CycleDetector_t *detector =
+      (CycleDetector_t *)calloc(1, sizeof(CycleDetector_t));
+  if (detector == NULL) {
+    return NULL;
+  }
+  detector->window = window;
+  detector->hashes = (uint64_t *)malloc(window * sizeof(uint64_t));
+  detector->generations = (long *)malloc(window * sizeof(long));
+  if (detector->hashes == NULL || detector->generations == NULL) {
+    free_cycle_detector(detector);
+    return NULL;
+  }
+  return detector;
+}
+
+int cycle_detector_add(CycleDetector_t *detector, uint64_t hash,
+                       long generation) {
+  // most recent match gives the smallest period
+  for (int k = 1; k <= detector->count; k++) {
+    int idx = (detector->next - k + detector->window) % detector->window;
+    if (detector->hashes[idx] == hash) {
+      detector->start = detector->generations[idx];
+      detector->period = generation - detector->start;
+      return 1;
+    }
+  }
+  detector->hashes[detector->next] = hash;
+  detector->generations[detector->next] = generation;
+  detector->next = (detector->next + 1) % detector->window;
+  if (detector->count < detector->window) {
+    detector->count++;
+  }
+  return 0;
+}
+
+void print_cycle(const CycleDetector_t *detector) {
+  if (detector->period == 0) {
+    return;
+  }
+  if (detector->extinct) {
+    printf("Extinction at generation %ld\n", detector->start);
+  } else if (detector->period == 1) {
+    printf("Still life from generation %ld\n", detector->start);
+  } else {
+    printf("Cycle of period %ld from generation %ld\n", detector->period,
+           detector->start);
+  }
+}
+
+void free_cycle_detector(CycleDetector_t *detector) {
+  if (detector == NULL) {
+    return;
+  }
+  free(detector->hashes);
+  free(detector->generations);
+  free(detector);
+}
@@ -0,0 +1,116 @@
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+/**
+ * @brief Detect generations repeating an earlier one from their hashes: the
+ * hashes of the last window generations are kept, a new generation whose
+ * hash is among them starts a cycle (64-bit hash collisions are ignored).
+ */
+struct CycleDetector {
+  int window;            // number of generations kept
+  uint64_t *hashes;      // ring of hashes of last generations
+  long *generations;     // generation of each hash
+  int count;             // number of hashes in ring
+  int next;              // ring index receiving next hash
+  long period;           // period of detected cycle (0 until detected)
+  long start;            // first generation of detected cycle
+  int extinct;           // whether detected cycle is an empty grid
+};
+typedef struct CycleDetector CycleDetector_t;
+
+/**
+ * @brief Hash buffer with FNV-1a over 64-bit words (last word zero padded)
+ *
+ * @param buf buffer to hash
+ * @param len buffer size in bytes
+ * @return uint64_t hash
+ */
+uint64_t hash_bytes(const void *buf, size_t len);
+
+/**
+ * @brief Fold one word into the FNV-1a hash of a grid part (hash starting at
+ * FNV_OFFSET, see hash_part)
+ */
+static inline uint64_t hash_fold(uint64_t hash, uint64_t word) {
+  return (hash ^ word) * FNV_PRIME;
+}
+
+/**
+ * @brief Finish the folded hash of a part of a grid (a row, a tile...), pos
+ * identifying the part within the grid. Grid hash is the sum of the hashes of
+ * its parts, so that engines hash parts while computing them (bands of
+ * concurrent threads merge in any order) and update the hash of a grid from
+ * the parts that changed.
+ *
+ * @param hash hash folded with hash_fold
+ * @param pos position of the part
+ * @return uint64_t hash of the part
+ */
+uint64_t hash_part(uint64_t hash, uint64_t pos);
+
+/**
+ * @brief Hash a part of a grid made of n bit-packed words (see hash_part),
+ * words being folded in 4 interleaved lanes (hash differs from folding them
+ * one by one with hash_fold)
+ *
+ * @param words words of the part
+ * @param n number of words
+ * @param pos position of the part
+ * @return uint64_t hash of the part
+ */
+uint64_t hash_words(const uint64_t *words, size_t n, uint64_t pos);
+
+/**
+ * @brief Hash a part of a grid made of n byte cells (0 or 1): the
+ * bit-packed words they make are folded one by one with hash_fold (see
+ * hash_part)
+ *
+ * @param cells cells of the part
+ * @param n number of cells
+ * @param pos position of the part
+ * @return uint64_t hash of the part
+ */
+uint64_t hash_cells(const unsigned char *cells, size_t n, uint64_t pos);
+
+/**
+ * @brief Allocate cycle detector
+ *
+ * @param window number of past generations compared with each new one
+ * @return CycleDetector_t* detector (must be free'd by caller with
+ * free_cycle_detector, NULL on allocation failure)
+ */
+CycleDetector_t *cycle_detector_init(int window);
+
+/**
+ * @brief Record hash of a generation
+ *
+ * @param detector cycle detector
+ * @param hash hash of grid
+ * @param generation generation of grid
+ * @return int 1 if grid repeats an earlier generation of the window (period
+ * and start are set), 0 otherwise
+ */
+int cycle_detector_add(CycleDetector_t *detector, uint64_t hash,
+                       long generation);
+
+/**
+ * @brief Print detected cycle (nothing if none was detected)
+ *
+ * @param detector cycle detector
+ */
+void print_cycle(const CycleDetector_t *detector);
+
+/**
+ * @brief Free cycle detector
+ *
+ * @param detector cycle detector to free
+ */
+void free_cycle_detector(CycleDetector_t *detector);
+
+#endif /* CYCLE_H */
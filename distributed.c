@@ -0,0 +1,536 @@
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "engine.h"
+#include "packed.h"
+
+enum { COMMAND_STEP, COMMAND_GET, COMMAND_QUIT };
+
+/**
+ * @brief Command sent by the engine to a worker process
+ */
+struct Command {
+  int op; // COMMAND_STEP: step n generations, COMMAND_GET: send band rows,
+          // COMMAND_QUIT: exit
+  long n; // number of generations (COMMAND_STEP)
+};
+typedef struct Command Command_t;
+
+/**
+ * @brief Band of rows owned by a worker process, bit-packed like the packed
+ * engine with a halo row above and below receiving the boundary rows of the
+ * neighbour bands
+ */
+struct Band {
+  int w;                  // grid width
+  int h;                  // number of rows of band
+  int nw;                 // number of words per row
+  word last_mask;         // valid bits of the last word of a row
+  word *cur;              // current generation ((h + 2) * nw words)
+  word *next;             // preallocated rows receiving next generation
+  int torus;              // whether grid wraps around
+  Rule_t rule;            // rule (read by generic kernel)
+  PackedRowKernel kernel; // row kernel for rule
+  int up;                 // socket to band above (-1 if none)
+  int down;               // socket to band below (-1 if none)
+};
+typedef struct Band Band_t;
+
+/**
+ * @brief Worker process as seen by the engine
+ */
+struct Worker {
+  pid_t pid;   // process id
+  int control; // socket receiving commands (-1 once closed)
+  int begin;   // first row of band
+  int end;     // row after last row of band
+};
+typedef struct Worker Worker_t;
+
+/**
+ * @brief Distributed engine state: the grid is split in horizontal bands, one
+ * per worker process. Workers exchange their first and last rows with the
+ * workers of the bands above and below over socket pairs every generation and
+ * compute their band with the packed engine row kernels, so that results are
+ * bit-identical to the packed engine. The engine itself does not keep the
+ * grid: the byte grid returned by data() is assembled from the bands on
+ * demand into reserved address space whose pages are released at next step.
+ */
+struct DistributedEngine {
+  int nw;                 // number of words per row
+  int count;              // number of workers
+  Worker_t *workers;      // workers, top band first
+  word *rows;             // rows of a band received by data()
+  GameOfLifeData_t *view; // byte grid returned by data() (pages only hold
+                          // cells between a data() call and next step)
+  int view_valid;         // whether view is up to date with workers
+  int failed;             // whether a worker failed (grid is lost)
+};
+typedef struct DistributedEngine DistributedEngine_t;
+
+/**
+ * @brief Pending transfer of a row to or from a neighbour band
+ */
+struct Transfer {
+  int fd;      // socket to neighbour
+  char *buf;   // remaining bytes
+  size_t left; // number of remaining bytes
+  int out;     // send (1) or receive (0)
+};
+typedef struct Transfer Transfer_t;
+
+#define band_row(b, g, i) ((g) + (size_t)(b)->nw * ((i) + 1))
+
+/**
+ * @brief Write whole buffer to socket (without SIGPIPE when peer exited)
+ *
+ * @return int 0 on success, -1 on error
+ */
+static int send_all(int fd, const void *buf, size_t size) {
+  const char *p = (const char *)buf;
+  while (size > 0) {
+    ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+    p += n;
+    size -= (size_t)n;
+  }
+  return 0;
+}
+
+/**
+ * @brief Read whole buffer from socket
+ *
+ * @return int 0 on success, -1 on error or end of stream
+ */
+static int recv_all(int fd, void *buf, size_t size) {
+  char *p = (char *)buf;
+  while (size > 0) {
+    ssize_t n = recv(fd, p, size, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return -1;
+    }
+    p += n;
+    size -= (size_t)n;
+  }
+  return 0;
+}
+
+/**
+ * @brief Send first and last rows of band to neighbour bands and receive
+ * their boundary rows into halo rows. The up to 4 transfers progress together
+ * (sockets are non-blocking) so that rows larger than socket buffers cannot
+ * deadlock neighbours sending to each other.
+ *
+ * @param b band
+ * @return int 0 on success, -1 on error
+ */
+static int exchange_halos(Band_t *b) {
+  size_t size = (size_t)b->nw * sizeof(word);
+  Transfer_t transfers[4];
+  int count = 0;
+  if (b->up >= 0) {
+    transfers[count++] =
+        (Transfer_t){b->up, (char *)band_row(b, b->cur, 0), size, 1};
+    transfers[count++] =
+        (Transfer_t){b->up, (char *)band_row(b, b->cur, -1), size, 0};
+  }
+  if (b->down >= 0) {
+    transfers[count++] =
+        (Transfer_t){b->down, (char *)band_row(b, b->cur, b->h - 1), size, 1};
+    transfers[count++] =
+        (Transfer_t){b->down, (char *)band_row(b, b->cur, b->h), size, 0};
+  }
+  for (;;) {
+    struct pollfd fds[4];
+    int pending = 0;
+    for (int k = 0; k < count; k++) {
+      if (transfers[k].left > 0) {
+        fds[pending].fd = transfers[k].fd;
+        fds[pending].events = transfers[k].out ? POLLOUT : POLLIN;
+        pending++;
+      }
+    }
+    if (pending == 0) {
+      return 0;
+    }
+    if (poll(fds, (nfds_t)pending, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    for (int k = 0; k < count; k++) {
+      if (transfers[k].left == 0) {
+        continue;
+      }
+      ssize_t n = transfers[k].out
+                      ? send(transfers[k].fd, transfers[k].buf,
+                             transfers[k].left, MSG_NOSIGNAL | MSG_DONTWAIT)
+                      : recv(transfers[k].fd, transfers[k].buf,
+                             transfers[k].left, MSG_DONTWAIT);
+      if (n < 0 &&
+          (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        continue;
+      }
+      if (n <= 0) {
+        return -1;
+      }
+      transfers[k].buf += n;
+      transfers[k].left -= (size_t)n;
+    }
+  }
+}
+
+/**
+ * @brief Step band n generations forward
+ *
+ * @return int 0 on success, -1 if a neighbour failed
+ */
+static int step_band(Band_t *b, long n) {
+  for (long g = 0; g < n; g++) {
+    if (exchange_halos(b) != 0) {
+      return -1;
+    }
+    for (int i = 0; i < b->h; i++) {
+      b->kernel(band_row(b, b->cur, i - 1), band_row(b, b->cur, i),
+                band_row(b, b->cur, i + 1), band_row(b, b->next, i), b->nw,
+                b->last_mask, b->w, b->torus, &b->rule);
+    }
+    word *tmp = b->cur;
+    b->cur = b->next;
+    b->next = tmp;
+    if (b->torus && b->up < 0) {
+      // single band wraps onto itself
+      wrap_rows(band_row(b, b->cur, 0), b->nw, b->h);
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Worker process main loop: run commands until told to quit or until
+ * the engine exits
+ *
+ * @param b band
+ * @param control socket receiving commands
+ * @return int process exit status
+ */
+static int run_worker(Band_t *b, int control) {
+  Command_t command;
+  while (recv_all(control, &command, sizeof(command)) == 0) {
+    int status = 0;
+    switch (command.op) {
+    case COMMAND_STEP:
+      status = step_band(b, command.n);
+      if (send_all(control, &status, sizeof(status)) != 0 || status != 0) {
+        return 1;
+      }
+      break;
+    case COMMAND_GET:
+      if (send_all(control, band_row(b, b->cur, 0),
+                   (size_t)b->nw * b->h * sizeof(word)) != 0) {
+        return 1;
+      }
+      break;
+    default:
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * @brief Worker process entry: pack band rows of data and serve commands
+ *
+ * @return int process exit status
+ */
+static int worker_main(GameOfLifeData_t *data, int begin, int end,
+                       const EngineConfig_t *config, int control, int up,
+                       int down) {
+  Band_t b;
+  b.w = data->w;
+  b.h = end - begin;
+  b.nw = (data->w + WORD_BITS - 1) / WORD_BITS;
+  b.last_mask = data->w % WORD_BITS == 0
+                    ? ~(word)0
+                    : ((word)1 << (data->w % WORD_BITS)) - 1;
+  size_t words = (size_t)b.nw * (b.h + 2);
+  b.cur = (word *)calloc(words, sizeof(word));
+  b.next = (word *)calloc(words, sizeof(word));
+  if (b.cur == NULL || b.next == NULL) {
+    printf("Failed to allocate band of %dx%d\n", b.w, b.h);
+    return 1;
+  }
+  GameOfLifeData_t band = {data->w, b.h, data->grid + (size_t)data->w * begin,
+                           NULL, 0};
+  pack_rows(&band, band_row(&b, b.cur, 0), b.nw);
+  // drop the copy of the grid inherited from the engine
+  free_data(data);
+  b.torus = config->torus;
+  b.rule = config->rule;
+  b.kernel = packed_row_kernel(&b.rule);
+  b.up = up;
+  b.down = down;
+  if (b.torus && b.up < 0) {
+    wrap_rows(band_row(&b, b.cur, 0), b.nw, b.h);
+  }
+  return run_worker(&b, control);
+}
+
+/**
+ * @brief Report failed worker once: the grid is lost with the worker, engine
+ * does not step anymore
+ */
+static void worker_failed(DistributedEngine_t *e) {
+  if (!e->failed) {
+    printf("Worker process failed\n");
+    e->failed = 1;
+  }
+}
+
+/**
+ * @brief Tell started workers to quit, wait for them and free engine (the
+ * view is not part of the engine yet)
+ */
+static void stop_workers(DistributedEngine_t *e, int started) {
+  Command_t command = {COMMAND_QUIT, 0};
+  for (int k = 0; k < started; k++) {
+    send_all(e->workers[k].control, &command, sizeof(command));
+    close(e->workers[k].control);
+  }
+  for (int k = 0; k < started; k++) {
+    waitpid(e->workers[k].pid, NULL, 0);
+  }
+  free(e->workers);
+  free(e->rows);
+  free(e);
+}
+
+/**
+ * @brief Close the first count sockets of fds (socket pairs)
+ */
+static void close_sockets(int *fds, int count) {
+  for (int k = 0; k < count; k++) {
+    close(fds[k]);
+  }
+}
+
+static void *distributed_engine_create(GameOfLifeData_t *data,
+                                       const EngineConfig_t *config) {
+  // every process owns a band of at least one row
+  if (data->w < 1 || data->h < 1) {
+    printf("Invalid grid size for engine distributed: %dx%d (expected: at "
+           "least 1x1)\n",
+           data->w, data->h);
+    return NULL;
+  }
+  int count = config->processes < data->h ? config->processes : data->h;
+  DistributedEngine_t *e =
+      (DistributedEngine_t *)calloc(1, sizeof(DistributedEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->nw = (data->w + WORD_BITS - 1) / WORD_BITS;
+  e->workers = (Worker_t *)calloc(count, sizeof(Worker_t));
+  e->rows = (word *)malloc((size_t)e->nw * (data->h / count + 1) *
+                           sizeof(word));
+  // link k joins band k (down end, [2 * k]) and band k + 1 (up end,
+  // [2 * k + 1]), last band joining first one on a torus
+  int *links = (int *)malloc(2 * count * sizeof(int));
+  int links_count = config->torus && count > 1 ? count : count - 1;
+  int *controls = (int *)malloc(2 * count * sizeof(int));
+  // address space of the view, only backed by memory once data() fills it
+  size_t size = (size_t)data->w * data->h;
+  byte *grid = (byte *)mmap(NULL, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (e->workers == NULL || e->rows == NULL || links == NULL ||
+      controls == NULL || grid == MAP_FAILED) {
+    free(links);
+    free(controls);
+    if (grid != MAP_FAILED) {
+      munmap(grid, size);
+    }
+    stop_workers(e, 0);
+    return NULL;
+  }
+  int sockets = 0;
+  while (sockets < count &&
+         socketpair(AF_UNIX, SOCK_STREAM, 0, &controls[2 * sockets]) == 0) {
+    sockets++;
+  }
+  int linked = 0;
+  while (sockets == count && linked < links_count &&
+         socketpair(AF_UNIX, SOCK_STREAM, 0, &links[2 * linked]) == 0) {
+    linked++;
+  }
+  if (sockets < count || linked < links_count) {
+    printf("Failed to create worker sockets\n");
+    close_sockets(controls, 2 * sockets);
+    close_sockets(links, 2 * linked);
+    free(links);
+    free(controls);
+    munmap(grid, size);
+    stop_workers(e, 0);
+    return NULL;
+  }
+  // children must not inherit unflushed output
+  fflush(stdout);
+  int started = 0;
+  for (int k = 0; k < count; k++) {
+    int begin = (int)((long)data->h * k / count);
+    int end = (int)((long)data->h * (k + 1) / count);
+    pid_t pid = fork();
+    if (pid == 0) {
+      int up = k > 0 || links_count == count
+                   ? links[2 * ((k + count - 1) % count) + 1]
+                   : -1;
+      int down = k < links_count ? links[2 * k] : -1;
+      for (int j = 0; j < 2 * links_count; j++) {
+        if (links[j] != up && links[j] != down) {
+          close(links[j]);
+        }
+      }
+      for (int j = 0; j < count; j++) {
+        close(controls[2 * j]);
+        if (j != k) {
+          close(controls[2 * j + 1]);
+        }
+      }
+      munmap(grid, size);
+      _exit(worker_main(data, begin, end, config, controls[2 * k + 1], up,
+                        down));
+    }
+    if (pid < 0) {
+      break;
+    }
+    e->workers[k].pid = pid;
+    e->workers[k].control = controls[2 * k];
+    e->workers[k].begin = begin;
+    e->workers[k].end = end;
+    close(controls[2 * k + 1]);
+    started++;
+  }
+  close_sockets(links, 2 * links_count);
+  free(links);
+  if (started < count) {
+    printf("Failed to start worker process\n");
+    for (int k = started; k < count; k++) {
+      close(controls[2 * k]);
+      close(controls[2 * k + 1]);
+    }
+    free(controls);
+    munmap(grid, size);
+    stop_workers(e, started);
+    return NULL;
+  }
+  free(controls);
+  e->count = count;
+  // workers own the grid from now on, the initial one is released
+  if (data->map != NULL) {
+    munmap(data->map, data->map_size);
+  } else {
+    free(data->grid);
+  }
+  data->grid = grid;
+  data->map = grid;
+  data->map_size = size;
+  e->view = data;
+  e->view_valid = 0;
+  return e;
+}
+
+static void distributed_engine_step(void *state, long n) {
+  DistributedEngine_t *e = (DistributedEngine_t *)state;
+  if (e->failed) {
+    return;
+  }
+  if (e->view_valid) {
+    // give back the pages filled by data()
+    madvise(e->view->grid, e->view->map_size, MADV_DONTNEED);
+    e->view_valid = 0;
+  }
+  Command_t command = {COMMAND_STEP, n};
+  for (int k = 0; k < e->count && !e->failed; k++) {
+    if (send_all(e->workers[k].control, &command, sizeof(command)) != 0) {
+      worker_failed(e);
+    }
+  }
+  for (int k = 0; k < e->count && !e->failed; k++) {
+    int status;
+    if (recv_all(e->workers[k].control, &status, sizeof(status)) != 0 ||
+        status != 0) {
+      worker_failed(e);
+    }
+  }
+}
+
+static GameOfLifeData_t *distributed_engine_data(void *state) {
+  DistributedEngine_t *e = (DistributedEngine_t *)state;
+  if (!e->view_valid && !e->failed) {
+    Command_t command = {COMMAND_GET, 0};
+    for (int k = 0; k < e->count; k++) {
+      Worker_t *worker = &e->workers[k];
+      int h = worker->end - worker->begin;
+      if (send_all(worker->control, &command, sizeof(command)) != 0 ||
+          recv_all(worker->control, e->rows,
+                   (size_t)e->nw * h * sizeof(word)) != 0) {
+        worker_failed(e);
+        break;
+      }
+      GameOfLifeData_t band = {
+          e->view->w, h, e->view->grid + (size_t)e->view->w * worker->begin,
+          NULL, 0};
+      unpack_rows(e->rows, e->nw, &band);
+    }
+    e->view_valid = 1;
+  }
+  return e->view;
+}
+
+static int distributed_engine_failed(void *state) {
+  DistributedEngine_t *e = (DistributedEngine_t *)state;
+  return e->failed;
+}
+
+static void distributed_engine_destroy(void *state) {
+  DistributedEngine_t *e = (DistributedEngine_t *)state;
+  Command_t command = {COMMAND_QUIT, 0};
+  for (int k = 0; k < e->count; k++) {
+    send_all(e->workers[k].control, &command, sizeof(command));
+    close(e->workers[k].control);
+  }
+  for (int k = 0; k < e->count; k++) {
+    waitpid(e->workers[k].pid, NULL, 0);
+  }
+  free(e->workers);
+  free(e->rows);
+  free_data(e->view);
+  free(e);
+}
+
+const EngineOps_t distributed_engine_ops = {
+    .name = "distributed",
+    .torus = 1,
+    .birth0 = 1,
+    .bounded = 1,
+    .create = distributed_engine_create,
+    .step = distributed_engine_step,
+    .failed = distributed_engine_failed,
+    .data = distributed_engine_data,
+    .destroy = distributed_engine_destroy,
+};
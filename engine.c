@@ -0,0 +1,499 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "engine.h"
+#include "packed.h"
+#include "padded.h"
+#include "trace.h"
+
+static const EngineOps_t *engines[] = {&byte_engine_ops, &packed_engine_ops,
+                                       &simd_engine_ops, &hashlife_engine_ops,
+                                       &tiled_engine_ops, &block_engine_ops,
+                                       &sparse_engine_ops,
+                                       &distributed_engine_ops,
+                                       &temporal_engine_ops, NULL};
+
+/**
+ * @brief Row kernel: compute next state of row r (w cells) into out, a and b
+ * being the rows above and below (padded rows), lut being the rule table
+ * (see rule_table, unused by kernels specialized for a rule)
+ */
+typedef void (*ByteRowKernel)(const byte *a, const byte *r, const byte *b,
+                              byte *out, int w, const byte *lut);
+
+/**
+ * @brief Reference engine state: two padded byte grids of the same size that
+ * swap roles every generation
+ */
+struct ByteEngine {
+  PaddedGrid_t *cur;      // current generation
+  PaddedGrid_t *next;     // preallocated grid receiving next generation
+  int torus;              // whether grid wraps around
+  byte lut[18];           // rule table
+  ByteRowKernel kernel;   // row kernel for rule
+  GameOfLifeData_t *view; // byte grid returned by data()
+  int view_valid;         // whether view is up to date with cur
+  int count;              // whether step_rows collects counters
+  GenerationStats_t stats; // counters since last stats() call
+  int hashing;            // whether step_rows hashes rows
+  uint64_t hash;          // hash of current generation (sum of rows hashes)
+  uint64_t next_hash;     // hash of rows of next generation computed so far
+};
+typedef struct ByteEngine ByteEngine_t;
+
+// cells per block of row kernels
+#define BYTE_BLOCK 32
+
+/*
+ * Row kernels compute next state of each cell according to the rule (see
+ * https://en.wikipedia.org/wiki/Conway's_Game_of_Life#Rules), the halo
+ * providing neighbours of edge cells so that loops have no branch. Kernels of
+ * SPECIALIZED_RULES see constant masks folded into the cell update, other
+ * rules go through the rule table.
+ */
+#define BYTE_ROW_KERNEL(name, birth, survive)                                  \
+  static void byte_row_##name(const byte *restrict a, const byte *restrict r,  \
+                              const byte *restrict b, byte *restrict out,      \
+                              int w, const byte *lut) {                        \
+    (void)lut;                                                                 \
+    int j = 0;                                                                 \
+    /* fixed size blocks are fully unrolled by the compiler */                 \
+    for (; j + BYTE_BLOCK <= w; j += BYTE_BLOCK) {                             \
+      for (int k = j; k < j + BYTE_BLOCK; k++) {                               \
+        out[k] = rule_cell(padded_count(a, r, b, k), r[k], birth, survive);    \
+      }                                                                        \
+    }                                                                          \
+    for (; j < w; j++) {                                                       \
+      out[j] = rule_cell(padded_count(a, r, b, j), r[j], birth, survive);      \
+    }                                                                          \
+  }
+SPECIALIZED_RULES(BYTE_ROW_KERNEL)
+
+static void byte_row_generic(const byte *a, const byte *r, const byte *b,
+                             byte *out, int w, const byte *lut) {
+  for (int j = 0; j < w; j++) {
+    out[j] = lut[9 * r[j] + padded_count(a, r, b, j)];
+  }
+}
+
+#define BYTE_ROW_KERNEL_ENTRY(name, birth, survive)                            \
+  {{birth, survive}, byte_row_##name},
+static const struct {
+  Rule_t rule;
+  ByteRowKernel kernel;
+} byte_row_kernels[] = {SPECIALIZED_RULES(BYTE_ROW_KERNEL_ENTRY)};
+
+static void *byte_engine_create(GameOfLifeData_t *data,
+                                const EngineConfig_t *config) {
+  ByteEngine_t *e = (ByteEngine_t *)malloc(sizeof(ByteEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->cur = padded_alloc(data->w, data->h);
+  e->next = padded_alloc(data->w, data->h);
+  if (e->cur == NULL || e->next == NULL) {
+    free_padded(e->cur);
+    free_padded(e->next);
+    free(e);
+    return NULL;
+  }
+  e->torus = config->torus;
+  rule_table(&config->rule, e->lut);
+  e->kernel = byte_row_generic;
+  for (size_t k = 0; k < sizeof(byte_row_kernels) / sizeof(byte_row_kernels[0]);
+       k++) {
+    if (byte_row_kernels[k].rule.birth == config->rule.birth &&
+        byte_row_kernels[k].rule.survive == config->rule.survive) {
+      e->kernel = byte_row_kernels[k].kernel;
+    }
+  }
+  pad_grid(data, e->cur);
+  refresh_halo(e->cur, e->torus);
+  e->view = data;
+  e->view_valid = 1;
+  e->count = config->stats;
+  stats_clear(&e->stats);
+  e->hashing = config->hash;
+  e->hash = 0;
+  e->next_hash = 0;
+  for (int i = 0; e->hashing && i < data->h; i++) {
+    e->hash += hash_cells(padded_row(e->cur, i), data->w, i);
+  }
+  return e;
+}
+
+static void byte_engine_step_rows(void *state, int begin, int end) {
+  ByteEngine_t *e = (ByteEngine_t *)state;
+  GenerationStats_t band;
+  stats_clear(&band);
+  uint64_t hash = 0;
+  for (int i = begin; i < end; i++) {
+    e->kernel(padded_row(e->cur, i - 1), padded_row(e->cur, i),
+              padded_row(e->cur, i + 1), padded_row(e->next, i), e->cur->w,
+              e->lut);
+    // row is still in cache
+    if (e->count) {
+      stats_count_bytes(padded_row(e->cur, i), padded_row(e->next, i),
+                        e->cur->w, i, &band);
+    }
+    if (e->hashing) {
+      hash += hash_cells(padded_row(e->next, i), e->cur->w, i);
+    }
+  }
+  if (e->count) {
+    stats_merge(&e->stats, &band);
+  }
+  if (e->hashing) {
+    __atomic_fetch_add(&e->next_hash, hash, __ATOMIC_RELAXED);
+  }
+}
+
+static void byte_engine_swap(void *state) {
+  ByteEngine_t *e = (ByteEngine_t *)state;
+  PaddedGrid_t *tmp = e->cur;
+  e->cur = e->next;
+  e->next = tmp;
+  refresh_halo(e->cur, e->torus);
+  e->view_valid = 0;
+  e->hash = e->next_hash;
+  e->next_hash = 0;
+}
+
+static void byte_engine_stats(void *state, GenerationStats_t *stats) {
+  ByteEngine_t *e = (ByteEngine_t *)state;
+  *stats = e->stats;
+  stats_clear(&e->stats);
+}
+
+static uint64_t byte_engine_hash(void *state) {
+  ByteEngine_t *e = (ByteEngine_t *)state;
+  return e->hash;
+}
+
+static void byte_engine_pack(void *state, uint64_t *rows) {
+  ByteEngine_t *e = (ByteEngine_t *)state;
+  int nw = (e->cur->w + WORD_BITS - 1) / WORD_BITS;
+  for (int i = 0; i < e->cur->h; i++) {
+    pack_cells(padded_row(e->cur, i), e->cur->w, rows + (size_t)nw * i);
+  }
+}
+
+static GameOfLifeData_t *byte_engine_data(void *state) {
+  ByteEngine_t *e = (ByteEngine_t *)state;
+  if (!e->view_valid) {
+    unpad_grid(e->cur, e->view);
+    e->view_valid = 1;
+  }
+  return e->view;
+}
+
+static void byte_engine_destroy(void *state) {
+  ByteEngine_t *e = (ByteEngine_t *)state;
+  free_padded(e->cur);
+  free_padded(e->next);
+  free_data(e->view);
+  free(e);
+}
+
+const EngineOps_t byte_engine_ops = {
+    .name = "byte",
+    .torus = 1,
+    .birth0 = 1,
+    .bounded = 1,
+    .create = byte_engine_create,
+    .step_rows = byte_engine_step_rows,
+    .swap = byte_engine_swap,
+    .stats = byte_engine_stats,
+    .hash = byte_engine_hash,
+    .pack = byte_engine_pack,
+    .data = byte_engine_data,
+    .destroy = byte_engine_destroy,
+};
+
+GameOfLifeEngine_t *engine_init(const char *name, GameOfLifeData_t *data,
+                                const EngineConfig_t *config) {
+  const EngineOps_t *ops = NULL;
+  for (int k = 0; engines[k] != NULL; k++) {
+    if (strcmp(engines[k]->name, name) == 0) {
+      ops = engines[k];
+    }
+  }
+  if (ops == NULL) {
+    printf("Unknown engine: %s\n", name);
+    return NULL;
+  }
+  if (config->torus && !ops->torus) {
+    printf("Unsupported boundary for engine %s: torus\n", name);
+    return NULL;
+  }
+  if ((config->rule.birth & 1) && !ops->birth0) {
+    char rule_str[RULE_MAX_LENGTH];
+    format_rule(&config->rule, rule_str);
+    printf("Unsupported rule for engine %s: %s (B0 rules are not supported)\n",
+           name, rule_str);
+    return NULL;
+  }
+  if (config->threads < 1) {
+    printf("Invalid threads count: %d (expected: at least 1)\n",
+           config->threads);
+    return NULL;
+  }
+  if (config->processes < 1) {
+    printf("Invalid processes count: %d (expected: at least 1)\n",
+           config->processes);
+    return NULL;
+  }
+  if (config->temporal_depth < 1 || config->temporal_depth > WORD_BITS) {
+    printf("Invalid temporal depth: %d (expected: 1 to %d)\n",
+           config->temporal_depth, WORD_BITS);
+    return NULL;
+  }
+  // threads are started before data is handed over to the engine, so that
+  // caller still owns it on failure
+  ThreadPool_t *pool = NULL;
+  if (ops->step_rows != NULL) {
+    pool = threadpool_init(config->threads);
+    if (pool == NULL) {
+      printf("Failed to start %d threads\n", config->threads);
+      return NULL;
+    }
+  }
+  GameOfLifeEngine_t *engine =
+      (GameOfLifeEngine_t *)malloc(sizeof(GameOfLifeEngine_t));
+  int w = data->w, h = data->h;
+  void *state = engine != NULL ? ops->create(data, config) : NULL;
+  if (state == NULL) {
+    printf("Failed to allocate %dx%d grid\n", w, h);
+    if (pool != NULL) {
+      free_threadpool(pool);
+    }
+    free(engine);
+    return NULL;
+  }
+  engine->ops = ops;
+  engine->state = state;
+  engine->rows = h;
+  engine->pool = pool;
+  engine->generation = 0;
+  engine->checkpoint = NULL;
+  engine->recorder = NULL;
+  engine->cycle = NULL;
+  engine->stats = NULL;
+  return engine;
+}
+
+/**
+ * @brief Thread task computing one band of rows of next generation
+ *
+ * @param arg engine
+ * @param id band index
+ * @param count number of bands
+ */
+static void step_band(void *arg, int id, int count) {
+  GameOfLifeEngine_t *engine = (GameOfLifeEngine_t *)arg;
+  int begin = (int)((long)engine->rows * id / count);
+  int end = (int)((long)engine->rows * (id + 1) / count);
+  engine->ops->step_rows(engine->state, begin, end);
+}
+
+/**
+ * @brief Write checkpoint if a multiple of checkpoint period was reached
+ * since generation from
+ *
+ * @param engine engine
+ * @param from generation before last step
+ */
+static void checkpoint_if_due(GameOfLifeEngine_t *engine, long from) {
+  const Checkpointer_t *checkpoint = engine->checkpoint;
+  if (checkpoint == NULL || checkpoint->every <= 0 ||
+      engine->generation / checkpoint->every == from / checkpoint->every) {
+    return;
+  }
+  write_checkpoint(checkpoint->path, engine_data(engine), engine->generation,
+                   &checkpoint->rule, checkpoint->torus, engine->pool);
+}
+
+/**
+ * @brief Queue current generation for recording
+ *
+ * @param engine engine
+ */
+static void record_generation(GameOfLifeEngine_t *engine) {
+  if (engine->recorder == NULL) {
+    return;
+  }
+  if (engine->ops->packed != NULL) {
+    recorder_add(engine->recorder, NULL, engine->ops->packed(engine->state),
+                 engine->generation);
+  } else if (engine->ops->pack_next != NULL) {
+    // rows were packed while stepping into the slot reserved by engine_step
+    recorder_publish(engine->recorder, engine->generation);
+  } else if (engine->ops->pack != NULL) {
+    uint64_t *rows = recorder_reserve(engine->recorder);
+    double start = trace_begin();
+    engine->ops->pack(engine->state, rows);
+    trace_end("record", start);
+    recorder_publish(engine->recorder, engine->generation);
+  } else {
+    recorder_add(engine->recorder, engine_data(engine), NULL,
+                 engine->generation);
+  }
+}
+
+/**
+ * @brief Record current generation in cycle detector
+ *
+ * @param engine engine
+ * @return int whether a cycle was found
+ */
+static int detect_cycle(GameOfLifeEngine_t *engine) {
+  CycleDetector_t *cycle = engine->cycle;
+  if (cycle == NULL) {
+    return 0;
+  }
+  uint64_t hash;
+  if (engine->ops->hash != NULL) {
+    hash = engine->ops->hash(engine->state);
+  } else {
+    hash = checkpoint_checksum(engine_data(engine), engine->pool);
+  }
+  if (!cycle_detector_add(cycle, hash, engine->generation)) {
+    return 0;
+  }
+  // an empty grid repeats with period 1, checked whatever the period found in
+  // case generations were skipped
+  if (engine->ops->extinct != NULL) {
+    cycle->extinct = engine->ops->extinct(engine->state);
+  } else {
+    GameOfLifeData_t *data = engine_data(engine);
+    cycle->extinct =
+        memchr(data->grid, ALIVE, (size_t)data->w * data->h) == NULL;
+  }
+  return 1;
+}
+
+/**
+ * @brief Monotonic time in seconds
+ */
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Log counters of current generation
+ *
+ * @param engine engine
+ * @param generations number of generations computed by last step
+ * @param seconds wall time of last step
+ */
+static void log_stats(GameOfLifeEngine_t *engine, long generations,
+                      double seconds) {
+  GenerationStats_t stats;
+  if (engine->ops->stats != NULL) {
+    engine->ops->stats(engine->state, &stats);
+  } else {
+    stats_log_scan(engine->stats, engine_data(engine), &stats);
+  }
+  stats_log_add(engine->stats, engine->generation, generations, &stats,
+                seconds);
+}
+
+void engine_step(GameOfLifeEngine_t *engine, long n) {
+  // nothing is computed, so nothing is recorded, checkpointed nor hashed
+  if (n <= 0 || engine_cycle_found(engine) || engine_failed(engine)) {
+    return;
+  }
+  if (engine->cycle != NULL && engine->cycle->count == 0) {
+    // initial grid may already be part of the cycle
+    if (detect_cycle(engine)) {
+      return;
+    }
+  }
+  double span = trace_begin();
+  if (engine->ops->step_rows == NULL) {
+    // cycle detection hashes every generation: generations n apart would
+    // only give a multiple of the period
+    long jump = engine->cycle != NULL ? 1 : n;
+    for (long g = 0; g < n; g += jump) {
+      long from = engine->generation;
+      double start = engine->stats != NULL ? now() : 0;
+      engine->ops->step(engine->state, jump);
+      if (engine_failed(engine)) {
+        break;
+      }
+      engine->generation += jump;
+      if (engine->stats != NULL) {
+        log_stats(engine, jump, now() - start);
+      }
+      checkpoint_if_due(engine, from);
+      record_generation(engine);
+      if (detect_cycle(engine)) {
+        break;
+      }
+    }
+  } else {
+    for (long g = 0; g < n; g++) {
+      if (engine->recorder != NULL && engine->ops->pack_next != NULL) {
+        engine->ops->pack_next(engine->state,
+                               recorder_reserve(engine->recorder));
+      }
+      double start = engine->stats != NULL ? now() : 0;
+      threadpool_run(engine->pool, step_band, engine);
+      engine->ops->swap(engine->state);
+      if (engine_failed(engine)) {
+        break;
+      }
+      engine->generation++;
+      if (engine->stats != NULL) {
+        log_stats(engine, 1, now() - start);
+      }
+      checkpoint_if_due(engine, engine->generation - 1);
+      record_generation(engine);
+      if (detect_cycle(engine)) {
+        break;
+      }
+    }
+  }
+  trace_end("step", span);
+}
+
+int engine_cycle_found(GameOfLifeEngine_t *engine) {
+  return engine->cycle != NULL && engine->cycle->period > 0;
+}
+
+int engine_failed(GameOfLifeEngine_t *engine) {
+  return engine->ops->failed != NULL && engine->ops->failed(engine->state);
+}
+
+GameOfLifeData_t *engine_data(GameOfLifeEngine_t *engine) {
+  return engine->ops->data(engine->state);
+}
+
+long engine_active_tiles(GameOfLifeEngine_t *engine, long *total) {
+  if (engine->ops->active_tiles == NULL) {
+    *total = 0;
+    return -1;
+  }
+  return engine->ops->active_tiles(engine->state, total);
+}
+
+double engine_traffic(GameOfLifeEngine_t *engine, double *naive) {
+  if (engine->ops->traffic == NULL) {
+    *naive = 0;
+    return -1;
+  }
+  return engine->ops->traffic(engine->state, naive);
+}
+
+void free_engine(GameOfLifeEngine_t *engine) {
+  if (engine->pool != NULL) {
+    free_threadpool(engine->pool);
+  }
+  free_cycle_detector(engine->cycle);
+  engine->ops->destroy(engine->state);
+  free(engine);
+}
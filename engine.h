@@ -0,0 +1,199 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "checkpoint.h"
+#include "cycle.h"
+#include "gameoflife.h"
+#include "recorder.h"
+#include "rule.h"
+#include "stats.h"
+#include "threadpool.h"
+
+/**
+ * @brief Engine tuning options (from command line)
+ */
+struct EngineConfig {
+  const char *isa; // instruction set of simd kernel ("auto" to detect)
+  int threads;     // number of threads computing each generation
+  int hashlife_memory; // memory budget of hashlife node cache in MiB
+  int torus;       // grid wraps around (cells outside grid are dead otherwise)
+  Rule_t rule;     // rule computing next generation
+  int processes;   // number of worker processes (distributed engine)
+  int temporal_depth; // generations per memory pass (temporal engine)
+  int stats;       // count population, births, deaths and bounding box while
+                   // stepping (engines with a stats operation)
+  int hash;        // hash generations while stepping (engines with a hash
+                   // operation, see engine->cycle)
+};
+typedef struct EngineConfig EngineConfig_t;
+
+/**
+ * @brief Operations implemented by a simulation engine. Each engine keeps the
+ * grid in its own representation and converts from/to GameOfLifeData_t.
+ */
+struct EngineOps {
+  const char *name; // name used to select engine from command line
+  int torus;        // whether engine supports torus boundary
+  int birth0;       // whether engine supports rules with B0 (dead cells
+                    // without alive neighbour come to life)
+  int bounded;      // whether grid holds every cell (unbounded engines only
+                    // expose a window of the plane, which cannot be
+                    // checkpointed)
+  // create engine state from data (ownership of data is transferred), returns
+  // NULL if allocation failed
+  void *(*create)(GameOfLifeData_t *data, const EngineConfig_t *config);
+  // compute n generations (engines without step_rows)
+  void (*step)(void *state, long n);
+  // compute next state of rows [begin, end) (row based engines, called
+  // concurrently on disjoint bands of rows)
+  void (*step_rows)(void *state, int begin, int end);
+  // make the computed next state the current generation (row based engines)
+  void (*swap)(void *state);
+  // number of tiles computed during last generation, total number of tiles
+  // stored in total (optional, engines skipping inactive regions)
+  long (*active_tiles)(void *state, long *total);
+  // bytes moved between the grid and cache resident tiles so far, naive
+  // receiving the bytes a pass over the grid per generation would have moved
+  // (optional, engines blocking generations in cache)
+  double (*traffic)(void *state, double *naive);
+  // counters of the generations computed since last call, collected while
+  // stepping when config->stats is set, then reset (optional, byte grid is
+  // scanned otherwise)
+  void (*stats)(void *state, GenerationStats_t *stats);
+  // hash of current generation, summed from the hashes of the parts computed
+  // since last generation when config->hash is set (optional, byte grid is
+  // hashed otherwise)
+  uint64_t (*hash)(void *state);
+  // whether no cell of current generation is alive (optional, byte grid is
+  // scanned otherwise)
+  int (*extinct)(void *state);
+  // current generation as h rows of (w + 63) / 64 words, column j in bit
+  // j % 64 of word j / 64, bits beyond w being 0 (optional, engines storing
+  // such rows, recorded without converting them to a byte grid)
+  const uint64_t *(*packed)(void *state);
+  // pack current generation into rows laid out like packed ones (optional,
+  // engines storing other rows, recorded without building the byte grid)
+  void (*pack)(void *state, uint64_t *rows);
+  // rows laid out like packed ones receiving the next generation, packed by
+  // step_rows while computing it (optional, row based engines, recorded
+  // without copying)
+  void (*pack_next)(void *state, uint64_t *rows);
+  // whether the grid was lost (a worker process exited, memory ran out), the
+  // engine not stepping anymore (optional, engines that cannot fail once
+  // created)
+  int (*failed)(void *state);
+  // current generation as byte grid (owned by engine, valid until next step)
+  GameOfLifeData_t *(*data)(void *state);
+  // free engine state
+  void (*destroy)(void *state);
+};
+typedef struct EngineOps EngineOps_t;
+
+struct GameOfLifeEngine {
+  const EngineOps_t *ops; // engine implementation
+  void *state;            // engine private state
+  int rows;               // number of rows split in bands among threads
+  ThreadPool_t *pool;     // threads computing bands of rows
+  long generation;        // number of generations computed so far
+  const Checkpointer_t *checkpoint; // periodic checkpoints (NULL if none)
+  Recorder_t *recorder;   // records computed generations (NULL if none)
+  CycleDetector_t *cycle; // stops stepping on cycles (NULL if none, freed
+                          // with engine, engine must be created with
+                          // config->hash set)
+  StatsLog_t *stats;      // logs counters and wall time of each step (NULL
+                          // if none)
+};
+typedef struct GameOfLifeEngine GameOfLifeEngine_t;
+
+extern const EngineOps_t byte_engine_ops;
+extern const EngineOps_t packed_engine_ops;
+extern const EngineOps_t simd_engine_ops;
+extern const EngineOps_t hashlife_engine_ops;
+extern const EngineOps_t tiled_engine_ops;
+extern const EngineOps_t block_engine_ops;
+extern const EngineOps_t sparse_engine_ops;
+extern const EngineOps_t distributed_engine_ops;
+extern const EngineOps_t temporal_engine_ops;
+
+/**
+ * @brief Create engine state for data
+ *
+ * @param name engine name (see EngineOps_t::name)
+ * @param data initial game of life state (ownership is transferred to engine)
+ * @param config engine options
+ * @return GameOfLifeEngine_t* engine (must be free'd by caller with
+ * free_engine, NULL if name is unknown or allocation failed)
+ */
+GameOfLifeEngine_t *engine_init(const char *name, GameOfLifeData_t *data,
+                                const EngineConfig_t *config);
+
+/**
+ * @brief Step engine n generations forward, rows based engines split each
+ * generation in config->threads bands computed in parallel. A checkpoint is
+ * written each time a multiple of engine->checkpoint->every generations is
+ * reached. With engine->recorder set, every computed generation is
+ * recorded (engines without step_rows only record the generation they jump
+ * to). With engine->cycle set, every generation is hashed and stepping stops
+ * early once a generation repeats an earlier one (engines without step_rows
+ * then step one generation at a time). With engine->stats set, counters and
+ * wall time of every step are logged (one line per generation for row based
+ * engines and while detecting cycles).
+ *
+ * @param engine engine to step
+ * @param n number of generations to compute
+ */
+void engine_step(GameOfLifeEngine_t *engine, long n);
+
+/**
+ * @brief Whether engine stopped on a cycle (see engine_step)
+ *
+ * @param engine engine
+ * @return int 1 if a cycle was found, 0 otherwise
+ */
+int engine_cycle_found(GameOfLifeEngine_t *engine);
+
+/**
+ * @brief Whether engine lost its grid and stopped stepping (see
+ * EngineOps_t::failed)
+ *
+ * @param engine engine
+ * @return int 1 if engine failed, 0 otherwise
+ */
+int engine_failed(GameOfLifeEngine_t *engine);
+
+/**
+ * @brief Get current generation of engine as byte grid
+ *
+ * @param engine engine to read
+ * @return GameOfLifeData_t* data (owned by engine, valid until next step)
+ */
+GameOfLifeData_t *engine_data(GameOfLifeEngine_t *engine);
+
+/**
+ * @brief Get number of tiles computed during last generation by engines
+ * skipping inactive regions
+ *
+ * @param engine engine to read
+ * @param total receives total number of tiles
+ * @return long number of tiles computed (-1 if engine has no tiles)
+ */
+long engine_active_tiles(GameOfLifeEngine_t *engine, long *total);
+
+/**
+ * @brief Get memory traffic of engines blocking several generations in cache
+ *
+ * @param engine engine to read
+ * @param naive receives bytes a pass over the grid per generation would have
+ * moved
+ * @return double bytes loaded and stored so far (-1 if engine does not count)
+ */
+double engine_traffic(GameOfLifeEngine_t *engine, double *naive);
+
+/**
+ * @brief Convenient method to free GameOfLifeEngine_t (and its grids)
+ *
+ * @param engine engine to free
+ */
+void free_engine(GameOfLifeEngine_t *engine);
+
+#endif /* ENGINE_H */
@@ -0,0 +1,352 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ensemble.h"
+#include "packed.h"
+
+/**
+ * @brief Statistics of one board
+ */
+struct BoardStats {
+  long initial;     // initial population
+  long population;  // final population
+  long extinct;     // first generation without alive cell (-1 if none)
+  long last_change; // last generation differing from the one before
+  long last_change2; // last generation differing from the one 2 before
+};
+typedef struct BoardStats BoardStats_t;
+
+struct Ensemble;
+/**
+ * @brief Band kernel: compute rows [begin, end) of next generation, or'ing
+ * into masks[0], masks[1] and masks[2] (one word per slice) the boards that
+ * changed since last generation, since the generation before it and that have
+ * alive cells
+ */
+typedef void (*EnsembleBandKernel)(struct Ensemble *e, int begin, int end,
+                                   word **masks);
+
+/**
+ * @brief Bit-sliced boards: each cell is slices words, bit b of word s holding
+ * board 64 * s + b. Grids are surrounded by a one cell halo (dead, or the
+ * opposite edge on a torus) like padded grids.
+ */
+struct Ensemble {
+  int w;                     // board width
+  int h;                     // board height
+  int boards;                // number of boards
+  int slices;                // words per cell
+  size_t stride;             // words per row ((w + 2) * slices)
+  word *cur;                 // current generation ((h + 2) rows)
+  word *next;                // generation before current one, receives next
+  int torus;                 // whether boards wrap around
+  Rule_t rule;               // rule (used by generic kernel)
+  EnsembleBandKernel kernel; // band kernel for rule
+  ThreadPool_t *pool;        // threads computing bands of rows
+  word *masks;               // 3 masks of slices words per thread
+  long generation;           // number of generations computed so far
+  BoardStats_t *stats;       // boards statistics
+};
+typedef struct Ensemble Ensemble_t;
+
+#define ensemble_cell(e, g, i, j)                                              \
+  ((g) + (e)->stride * ((i) + 1) + (size_t)(e)->slices * ((j) + 1))
+
+/*
+ * Band kernels of SPECIALIZED_RULES are compiled with constant rule masks,
+ * the generic kernel reads them from ensemble. Neighbours of a word are the
+ * words of the same slice in the 8 neighbour cells.
+ */
+#define ENSEMBLE_BAND_KERNEL(name, birth, survive)                             \
+  static void ensemble_band_##name(Ensemble_t *e, int begin, int end,          \
+                                   word **masks) {                             \
+    size_t n = (size_t)e->slices, st = e->stride;                              \
+    for (int i = begin; i < end; i++) {                                        \
+      for (int j = 0; j < e->w; j++) {                                         \
+        const word *c = ensemble_cell(e, e->cur, i, j);                        \
+        word *out = ensemble_cell(e, e->next, i, j);                           \
+        for (size_t s = 0; s < n; s++) {                                       \
+          word v = life_word(c[s - st - n], c[s - st], c[s - st + n],          \
+                             c[s - n], c[s], c[s + n], c[s + st - n],          \
+                             c[s + st], c[s + st + n], birth, survive);        \
+          masks[0][s] |= v ^ c[s];                                             \
+          masks[1][s] |= v ^ out[s];                                           \
+          masks[2][s] |= v;                                                    \
+          out[s] = v;                                                          \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+  }
+SPECIALIZED_RULES(ENSEMBLE_BAND_KERNEL)
+ENSEMBLE_BAND_KERNEL(generic, e->rule.birth, e->rule.survive)
+
+#define ENSEMBLE_BAND_KERNEL_ENTRY(name, birth, survive)                       \
+  {{birth, survive}, ensemble_band_##name},
+static const struct {
+  Rule_t rule;
+  EnsembleBandKernel kernel;
+} ensemble_band_kernels[] = {SPECIALIZED_RULES(ENSEMBLE_BAND_KERNEL_ENTRY)};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Copy opposite edges into halo (torus only, halo stays dead otherwise)
+ *
+ * @param e ensemble
+ * @param g grid
+ */
+static void refresh_ensemble_halo(Ensemble_t *e, word *g) {
+  if (!e->torus) {
+    return;
+  }
+  size_t cell = (size_t)e->slices * sizeof(word);
+  for (int i = 0; i < e->h; i++) {
+    memcpy(ensemble_cell(e, g, i, -1), ensemble_cell(e, g, i, e->w - 1), cell);
+    memcpy(ensemble_cell(e, g, i, e->w), ensemble_cell(e, g, i, 0), cell);
+  }
+  // whole rows including halo columns, which fills corners
+  size_t row = e->stride * sizeof(word);
+  memcpy(ensemble_cell(e, g, -1, -1), ensemble_cell(e, g, e->h - 1, -1), row);
+  memcpy(ensemble_cell(e, g, e->h, -1), ensemble_cell(e, g, 0, -1), row);
+}
+
+/**
+ * @brief Free ensemble (NULL is ignored)
+ *
+ * @param e ensemble to free
+ */
+static void free_ensemble(Ensemble_t *e) {
+  if (e == NULL) {
+    return;
+  }
+  if (e->pool != NULL) {
+    free_threadpool(e->pool);
+  }
+  free(e->cur);
+  free(e->next);
+  free(e->masks);
+  free(e->stats);
+  free(e);
+}
+
+/**
+ * @brief Draw boards and pack them into bit-sliced grids
+ *
+ * @return Ensemble_t* ensemble (NULL if allocation failed)
+ */
+static Ensemble_t *ensemble_init(int boards, int w, int h, double density,
+                                 uint64_t seed, const EngineConfig_t *config) {
+  Ensemble_t *e = (Ensemble_t *)calloc(1, sizeof(Ensemble_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->w = w;
+  e->h = h;
+  e->boards = boards;
+  e->slices = (boards + WORD_BITS - 1) / WORD_BITS;
+  e->stride = (size_t)e->slices * (w + 2);
+  size_t words = e->stride * (h + 2);
+  e->cur = (word *)calloc(words, sizeof(word));
+  e->next = (word *)calloc(words, sizeof(word));
+  e->masks =
+      (word *)malloc((size_t)3 * e->slices * config->threads * sizeof(word));
+  e->stats = (BoardStats_t *)calloc(boards, sizeof(BoardStats_t));
+  if (e->cur == NULL || e->next == NULL || e->masks == NULL ||
+      e->stats == NULL) {
+    free_ensemble(e);
+    return NULL;
+  }
+  for (int b = 0; b < boards; b++) {
+    byte *grid = generate_random_grid(w, h, density, seed + b, 1);
+    if (grid == NULL) {
+      free_ensemble(e);
+      return NULL;
+    }
+    word bit = (word)1 << (b % WORD_BITS);
+    for (int i = 0; i < h; i++) {
+      for (int j = 0; j < w; j++) {
+        if (grid[(size_t)w * i + j] == ALIVE) {
+          ensemble_cell(e, e->cur, i, j)[b / WORD_BITS] |= bit;
+          e->stats[b].initial++;
+        }
+      }
+    }
+    free(grid);
+    e->stats[b].extinct = e->stats[b].initial == 0 ? 0 : -1;
+  }
+  e->torus = config->torus;
+  refresh_ensemble_halo(e, e->cur);
+  // next holds the generation before the current one, so that the first
+  // generation differs from the one 2 before whenever it changed
+  memcpy(e->next, e->cur, words * sizeof(word));
+  e->rule = config->rule;
+  e->kernel = ensemble_band_generic;
+  for (size_t k = 0;
+       k < sizeof(ensemble_band_kernels) / sizeof(ensemble_band_kernels[0]);
+       k++) {
+    if (ensemble_band_kernels[k].rule.birth == e->rule.birth &&
+        ensemble_band_kernels[k].rule.survive == e->rule.survive) {
+      e->kernel = ensemble_band_kernels[k].kernel;
+    }
+  }
+  e->pool = threadpool_init(config->threads);
+  if (e->pool == NULL) {
+    free_ensemble(e);
+    return NULL;
+  }
+  return e;
+}
+
+/**
+ * @brief Thread task computing one band of rows of next generation
+ *
+ * @param arg ensemble
+ * @param id band index
+ * @param count number of bands
+ */
+static void ensemble_band(void *arg, int id, int count) {
+  Ensemble_t *e = (Ensemble_t *)arg;
+  word *masks[3];
+  for (int k = 0; k < 3; k++) {
+    masks[k] = e->masks + (size_t)e->slices * (3 * id + k);
+    memset(masks[k], 0, (size_t)e->slices * sizeof(word));
+  }
+  e->kernel(e, (int)((long)e->h * id / count),
+            (int)((long)e->h * (id + 1) / count), masks);
+}
+
+/**
+ * @brief Step boards n generations forward, updating boards statistics
+ *
+ * @param e ensemble
+ * @param n number of generations to compute
+ */
+static void ensemble_step(Ensemble_t *e, long n) {
+  for (long g = 0; g < n; g++) {
+    threadpool_run(e->pool, ensemble_band, e);
+    word *tmp = e->cur;
+    e->cur = e->next;
+    e->next = tmp;
+    refresh_ensemble_halo(e, e->cur);
+    e->generation++;
+    int settled = 1;
+    for (int s = 0; s < e->slices; s++) {
+      word changed = 0, changed2 = 0, alive = 0;
+      for (int t = 0; t < e->pool->count; t++) {
+        word *masks = e->masks + (size_t)e->slices * 3 * t;
+        changed |= masks[s];
+        changed2 |= masks[e->slices + s];
+        alive |= masks[2 * e->slices + s];
+      }
+      for (int b = 0; b < WORD_BITS && WORD_BITS * s + b < e->boards; b++) {
+        BoardStats_t *stats = &e->stats[WORD_BITS * s + b];
+        if ((changed >> b) & 1) {
+          stats->last_change = e->generation;
+        }
+        if ((changed2 >> b) & 1) {
+          stats->last_change2 = e->generation;
+          settled = 0;
+        }
+        if ((alive >> b) & 1) {
+          stats->extinct = -1; // B0 rules revive empty boards
+        } else if (stats->extinct < 0) {
+          stats->extinct = e->generation;
+        }
+      }
+    }
+    if (settled) {
+      // every board repeats the generation 2 before, nothing changes anymore
+      break;
+    }
+  }
+}
+
+/**
+ * @brief Count final population of every board
+ *
+ * @param e ensemble
+ */
+static void count_populations(Ensemble_t *e) {
+  for (int i = 0; i < e->h; i++) {
+    for (int j = 0; j < e->w; j++) {
+      const word *c = ensemble_cell(e, e->cur, i, j);
+      for (int s = 0; s < e->slices; s++) {
+        for (word v = c[s]; v != 0; v &= v - 1) {
+          int b = WORD_BITS * s + __builtin_ctzll(v);
+          if (b < e->boards) {
+            e->stats[b].population++;
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Print boards statistics as CSV
+ *
+ * @param e ensemble
+ */
+static void print_ensemble_stats(Ensemble_t *e) {
+  printf("board,initial_population,population,status,since\n");
+  for (int b = 0; b < e->boards; b++) {
+    BoardStats_t *stats = &e->stats[b];
+    const char *status = "active";
+    long since = stats->last_change2;
+    if (stats->extinct >= 0) {
+      status = "extinct";
+      since = stats->extinct;
+    } else if (stats->last_change < e->generation) {
+      status = "still";
+      since = stats->last_change;
+    } else if (stats->last_change2 < e->generation) {
+      // generation last_change2 - 1 is repeated by last_change2 + 1
+      status = "period2";
+      since = stats->last_change2 - 1;
+    }
+    printf("%d,%ld,%ld,%s,%ld\n", b, stats->initial, stats->population, status,
+           since);
+  }
+}
+
+int run_ensemble(int boards, int w, int h, double density, uint64_t seed,
+                 long generations, const EngineConfig_t *config) {
+  if (boards < 1) {
+    printf("Invalid ensemble: %d (expected: at least 1 board)\n", boards);
+    return -1;
+  }
+  if (w < 1 || h < 1) {
+    printf("Invalid board size: %dx%d (expected: at least 1x1)\n", w, h);
+    return -1;
+  }
+  if (config->threads < 1) {
+    printf("Invalid threads count: %d (expected: at least 1)\n",
+           config->threads);
+    return -1;
+  }
+  double start = now();
+  Ensemble_t *e = ensemble_init(boards, w, h, density, seed, config);
+  if (e == NULL) {
+    printf("Failed to allocate %d boards of %dx%d\n", boards, w, h);
+    return -1;
+  }
+  double init_seconds = now() - start;
+  ensemble_step(e, generations);
+  double seconds = now() - start;
+  count_populations(e);
+  print_ensemble_stats(e);
+  fprintf(stderr,
+          "ensemble: %d boards of %dx%d, %ld generations in %.6f s "
+          "(%.6f s drawing boards), %.1f boards/sec, %.4g "
+          "board-generations/sec\n",
+          boards, w, h, e->generation, seconds, init_seconds,
+          boards / seconds, (double)boards * e->generation / seconds);
+  free_ensemble(e);
+  return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include "engine.h"
+
+/**
+ * @brief Run boards independent random boards of size w * h together and
+ * print one CSV row of statistics per board on stdout (board, initial and
+ * final population, status: extinct, still, period2 or active, and the
+ * generation the status holds since), throughput being reported on stderr.
+ * Boards are bit-sliced: cell (i, j) of 64 boards is one word, bit b holding
+ * board b, so that one bitwise update steps 64 boards. Board b is drawn by
+ * generate_random_grid with seed + b, board 0 being the board of a single run
+ * with the same seed. The run stops early once every board is
+ * extinct, still or oscillating with period 2.
+ *
+ * @param boards number of boards
+ * @param w board width
+ * @param h board height
+ * @param density probability of a cell to be alive
+ * @param seed seed of board 0
+ * @param generations number of generations to compute
+ * @param config engine options (threads, boundary and rule are used)
+ * @return int 0 on success, -1 on error
+ */
+int run_ensemble(int boards, int w, int h, double density, uint64_t seed,
+                 long generations, const EngineConfig_t *config);
+
+#endif /* ENSEMBLE_H */
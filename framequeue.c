@@ -0,0 +1,152 @@
+#include <stdlib.h>
+
+#include "framequeue.h"
+
+FrameQueue_t *frame_queue_init(int w, int h) {
+  FrameQueue_t *queue = aligned_alloc(64, sizeof(FrameQueue_t));
+  if (queue == NULL) {
+    return NULL;
+  }
+  queue->head = 0;
+  queue->writing = NULL;
+  queue->reading = NULL;
+  for (int i = 0; i < FRAME_QUEUE_SIZE; i++) {
+    queue->frames[i].data.w = w;
+    queue->frames[i].data.h = h;
+    queue->frames[i].data.grid = grid_alloc(w, h);
+    queue->frames[i].data.map = NULL;
+    queue->frames[i].seq = 0;
+    queue->frames[i].state = FRAME_FREE;
+    if (queue->frames[i].data.grid == NULL) {
+      for (int j = 0; j < i; j++) {
+        free(queue->frames[j].data.grid);
+      }
+      free(queue);
+      return NULL;
+    }
+  }
+  return queue;
+}
+
+/**
+ * @brief Find oldest published frame
+ *
+ * @param queue frame queue
+ * @param seq receives sequence number of frame
+ * @return Frame_t* oldest ready frame (NULL if none)
+ */
+static Frame_t *oldest_ready(FrameQueue_t *queue, unsigned long *seq) {
+  Frame_t *oldest = NULL;
+  for (int i = 0; i < FRAME_QUEUE_SIZE; i++) {
+    Frame_t *frame = &queue->frames[i];
+    // acquire: frame content is visible once it is ready
+    if (__atomic_load_n(&frame->state, __ATOMIC_ACQUIRE) != FRAME_READY) {
+      continue;
+    }
+    unsigned long s = __atomic_load_n(&frame->seq, __ATOMIC_RELAXED);
+    if (oldest == NULL || s < *seq) {
+      oldest = frame;
+      *seq = s;
+    }
+  }
+  return oldest;
+}
+
+/**
+ * @brief Switch frame from ready to state if it still holds sequence seq
+ *
+ * @return int whether frame was claimed
+ */
+static int claim(Frame_t *frame, unsigned long seq, int state) {
+  int ready = FRAME_READY;
+  if (!__atomic_compare_exchange_n(&frame->state, &ready, state, 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    return 0;
+  }
+  if (__atomic_load_n(&frame->seq, __ATOMIC_RELAXED) != seq) {
+    // frame was dropped and published again in between, it is not the
+    // oldest one anymore
+    __atomic_store_n(&frame->state, FRAME_READY, __ATOMIC_RELEASE);
+    return 0;
+  }
+  return 1;
+}
+
+Frame_t *frame_queue_reserve(FrameQueue_t *queue) {
+  if (queue->writing != NULL) {
+    return queue->writing;
+  }
+  for (int i = 0; i < FRAME_QUEUE_SIZE; i++) {
+    Frame_t *frame = &queue->frames[i];
+    // acquire: consumer is done reading released slots
+    if (__atomic_load_n(&frame->state, __ATOMIC_ACQUIRE) == FRAME_FREE) {
+      // only producer takes free slots
+      __atomic_store_n(&frame->state, FRAME_WRITING, __ATOMIC_RELAXED);
+      queue->writing = frame;
+      return frame;
+    }
+  }
+  return NULL;
+}
+
+Frame_t *frame_queue_drop(FrameQueue_t *queue) {
+  Frame_t *frame;
+  unsigned long seq = 0;
+  // consumer may peek the oldest frame concurrently, retry with next one
+  while ((frame = oldest_ready(queue, &seq)) != NULL && seq > 0) {
+    if (claim(frame, seq, FRAME_WRITING)) {
+      queue->writing = frame;
+      return frame;
+    }
+  }
+  return NULL;
+}
+
+void frame_queue_publish(FrameQueue_t *queue) {
+  Frame_t *frame = queue->writing;
+  __atomic_store_n(&frame->seq, queue->head++, __ATOMIC_RELAXED);
+  // release: slot content is written before it becomes visible
+  __atomic_store_n(&frame->state, FRAME_READY, __ATOMIC_RELEASE);
+  queue->writing = NULL;
+}
+
+int frame_queue_ready(FrameQueue_t *queue) {
+  int ready = 0;
+  for (int i = 0; i < FRAME_QUEUE_SIZE; i++) {
+    ready += __atomic_load_n(&queue->frames[i].state, __ATOMIC_RELAXED) ==
+             FRAME_READY;
+  }
+  return ready;
+}
+
+Frame_t *frame_queue_peek(FrameQueue_t *queue) {
+  if (queue->reading != NULL) {
+    return queue->reading;
+  }
+  Frame_t *frame;
+  unsigned long seq = 0;
+  // producer may drop the oldest frame concurrently, retry with next one
+  while ((frame = oldest_ready(queue, &seq)) != NULL) {
+    if (claim(frame, seq, FRAME_READING)) {
+      queue->reading = frame;
+      return frame;
+    }
+  }
+  return NULL;
+}
+
+void frame_queue_release(FrameQueue_t *queue) {
+  // release: consumer is done reading before slot is reused
+  __atomic_store_n(&queue->reading->state, FRAME_FREE, __ATOMIC_RELEASE);
+  queue->reading = NULL;
+}
+
+void free_frame_queue(FrameQueue_t *queue) {
+  if (queue == NULL) {
+    return;
+  }
+  for (int i = 0; i < FRAME_QUEUE_SIZE; i++) {
+    free(queue->frames[i].data.grid);
+  }
+  free(queue);
+}
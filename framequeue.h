@@ -0,0 +1,115 @@
+#ifndef FRAMEQUEUE_H
+#define FRAMEQUEUE_H
+
+#include "gameoflife.h"
+
+// number of frame slots, including the one being filled and the one being
+// read
+#define FRAME_QUEUE_SIZE 4
+
+// frame slot states
+#define FRAME_FREE 0
+#define FRAME_WRITING 1 // reserved by producer
+#define FRAME_READY 2   // published, waiting for consumer
+#define FRAME_READING 3 // peeked by consumer
+
+/**
+ * @brief Computed generation waiting to be displayed
+ */
+struct Frame {
+  long generation;   // generation of grid
+  long active_tiles; // tiles computed for this generation (-1 if unknown)
+  long total_tiles;  // total number of tiles
+  int last;          // set on last frame of the run
+  GameOfLifeData_t data; // grid copy (owned by queue)
+  unsigned long seq; // number of frames published before this one
+  int state;         // FRAME_FREE, FRAME_WRITING, FRAME_READY or FRAME_READING
+};
+typedef struct Frame Frame_t;
+
+/**
+ * @brief Lock-free single producer / single consumer queue of frames. Frames
+ * are written in place: producer fills the slot returned by
+ * frame_queue_reserve then publishes it, consumer reads the slot returned by
+ * frame_queue_peek then releases it. Each side claims slots by switching
+ * their state atomically, so producer may also take back the oldest frame
+ * consumer did not peek yet (see frame_queue_drop).
+ */
+struct FrameQueue {
+  Frame_t frames[FRAME_QUEUE_SIZE];
+  // each side only touches its own fields, kept on separate cache lines
+  unsigned long head __attribute__((aligned(64))); // published frames
+  Frame_t *writing; // slot reserved by producer (NULL if none)
+  Frame_t *reading __attribute__((aligned(64))); // slot peeked by consumer
+                                                 // (NULL if none)
+};
+typedef struct FrameQueue FrameQueue_t;
+
+/**
+ * @brief Allocate frame queue for w x h grids
+ *
+ * @param w grid width
+ * @param h grid height
+ * @return FrameQueue_t* queue (must be free'd by caller with
+ * free_frame_queue, NULL on allocation failure)
+ */
+FrameQueue_t *frame_queue_init(int w, int h);
+
+/**
+ * @brief Get free slot to fill (producer side), the same slot is returned
+ * until it is published
+ *
+ * @param queue frame queue
+ * @return Frame_t* free slot (NULL if queue is full)
+ */
+Frame_t *frame_queue_reserve(FrameQueue_t *queue);
+
+/**
+ * @brief Take back oldest published frame not peeked by consumer yet as slot
+ * to fill (producer side), the first frame published is never dropped
+ *
+ * @param queue full frame queue
+ * @return Frame_t* dropped slot (NULL if consumer peeked every frame)
+ */
+Frame_t *frame_queue_drop(FrameQueue_t *queue);
+
+/**
+ * @brief Make slot returned by frame_queue_reserve or frame_queue_drop
+ * visible to consumer
+ *
+ * @param queue frame queue
+ */
+void frame_queue_publish(FrameQueue_t *queue);
+
+/**
+ * @brief Get number of published frames not peeked yet (consumer side)
+ *
+ * @param queue frame queue
+ * @return int number of frames ready
+ */
+int frame_queue_ready(FrameQueue_t *queue);
+
+/**
+ * @brief Get oldest published frame (consumer side), the same frame is
+ * returned until it is released
+ *
+ * @param queue frame queue
+ * @return Frame_t* oldest frame (NULL if queue is empty)
+ */
+Frame_t *frame_queue_peek(FrameQueue_t *queue);
+
+/**
+ * @brief Give slot returned by frame_queue_peek back to producer
+ *
+ * @param queue frame queue
+ */
+void frame_queue_release(FrameQueue_t *queue);
+
+/**
+ * @brief Free frame queue
+ *
+ * @param queue frame queue to free
+ */
+void free_frame_queue(FrameQueue_t *queue);
+
+#endif /* FRAMEQUEUE_H */
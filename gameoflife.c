@@ -1,65 +1,97 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
+#include <sys/mman.h>
 
+#include "benchmark.h"
 #include "cmdline.h"
+#include "engine.h"
+#include "ensemble.h"
+#include "gameoflife.h"
+#include "plaintext.h"
+#include "player.h"
+#include "rle.h"
+#include "rule.h"
+#include "threadpool.h"
+#include "trace.h"
 
-#define ALIVE 1
-#define DEAD 0
-#define MAX_LINE_LENGTH 1024
+#define SPLITMIX_GAMMA 0x9e3779b97f4a7c15ULL
 
-#define get_cell_state(i, j, data) data->grid[j + data->w * (i)]
-#define set_cell_state(i, j, data, v) data->grid[j + data->w * (i)] = v
-#define grid_alloc(w, h) (byte *)malloc(h *w * sizeof(byte))
-
-typedef unsigned char byte;
-
-struct GameOfLifeData {
-  int w;      // grid width
-  int h;      // grid height
-  byte *grid; // keeps cells state (DEAD or ALIVE)
+/**
+ * @brief Random grid fill task shared by generating threads
+ */
+struct RandomFill {
+  byte *grid;         // grid to fill
+  size_t cells;       // number of cells of grid
+  uint64_t seed;      // seed of the random stream
+  uint64_t threshold; // 32-bit random values below it give ALIVE cells
 };
-typedef struct GameOfLifeData GameOfLifeData_t;
+typedef struct RandomFill RandomFill_t;
 
 /**
- * @brief Generate random game of life grid of size w * h
- * (i.e. each cell has a random ALIVE or DEAD state)
- * @param w grid width
- * @param h grid height
- * @return byte* grid (must be free'd by caller)
+ * @brief Random word k of the stream of seed (SplitMix64 output function of
+ * the counter, so that any word is computed without the ones before)
  */
-byte *generate_random_grid(int w, int h) {
+static inline uint64_t random_word(uint64_t seed, uint64_t k) {
+  uint64_t z = seed + (k + 1) * SPLITMIX_GAMMA;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void fill_band(void *arg, int id, int count) {
+  RandomFill_t *fill = (RandomFill_t *)arg;
+  // random word k gives cells 2k and 2k + 1, whatever the number of threads
+  size_t pairs = (fill->cells + 1) / 2;
+  size_t begin = pairs * id / count, end = pairs * (id + 1) / count;
+  byte *grid = fill->grid;
+  uint64_t threshold = fill->threshold;
+  for (size_t k = begin; k < end; k++) {
+    uint64_t r = random_word(fill->seed, k);
+    grid[2 * k] = (byte)((r & 0xffffffff) < threshold);
+    if (2 * k + 1 < fill->cells) {
+      grid[2 * k + 1] = (byte)((r >> 32) < threshold);
+    }
+  }
+}
+
+byte *generate_random_grid(int w, int h, double density, uint64_t seed,
+                           int threads) {
   byte *grid = grid_alloc(w, h);
-  for (int i = 0; i < h * w; i++) {
-    grid[i] = (byte)(rand() & ALIVE);
+  if (grid == NULL) {
+    return NULL;
+  }
+  double start = trace_begin();
+  uint64_t threshold = density <= 0   ? 0
+                       : density >= 1 ? (uint64_t)1 << 32
+                                      : (uint64_t)(density * 4294967296.0);
+  RandomFill_t fill = {grid, (size_t)h * w, seed, threshold};
+  ThreadPool_t *pool = threadpool_init(threads < 1 ? 1 : threads);
+  if (pool != NULL) {
+    threadpool_run(pool, fill_band, &fill);
+    free_threadpool(pool);
+  } else {
+    // threads could not be started, grid is filled by calling thread
+    fill_band(&fill, 0, 1);
   }
+  trace_end("generate", start);
   return grid;
 }
 
-/**
- * @brief Convenient method to create GameOfLifeData_t
- *
- * @param w grid width
- * @param h grid height
- * @param grid grid containing cells state
- * @return GameOfLifeData_t* data (must be free'd by caller)
- */
 GameOfLifeData_t *init(int w, int h, byte *grid) {
   GameOfLifeData_t *data = (GameOfLifeData_t *)malloc(sizeof(GameOfLifeData_t));
   data->h = h;
   data->w = w;
   data->grid = grid;
+  data->map = NULL;
+  data->map_size = 0;
   return data;
 }
 
-/**
- * @brief Convenient method to free GameOfLifeData_t
- *
- * @param d data to free
- */
 void free_data(GameOfLifeData_t *d) {
-  if (d->grid != NULL) {
+  if (d->map != NULL) {
+    munmap(d->map, d->map_size);
+  } else if (d->grid != NULL) {
     free(d->grid);
   }
   free(d);
@@ -78,22 +110,43 @@ void free_data(GameOfLifeData_t *d) {
  *        @@@
  *
  *        """
- * 
+ * Files starting with '#' or 'x' are read as RLE files (see from_rle_file).
+ * Rows are read whatever their length.
+ * Valid plaintext files are mmap'ed and converted in parallel (see
+ * from_plaintext_mmap).
+ *
  * @param file_path path of file to parse
+ * @param rule receives rule of the file (B3/S23 for plaintext files)
+ * @param threads number of threads converting plaintext rows
  * @return GameOfLifeData_t* data (must be free'd by caller)
  */
-GameOfLifeData_t *from_file(char *file_path) {
+GameOfLifeData_t *from_file(char *file_path, Rule_t *rule, int threads) {
   GameOfLifeData_t *data = NULL;
+  char *line = NULL;
+  size_t line_cap = 0;
   FILE *file = fopen(file_path, "r");
   if (file == NULL) {
     printf("Failed to open file: %s\n", file_path);
     goto fail;
   }
+  int first = fgetc(file);
+  if (first == '#' || first == 'x') {
+    fclose(file);
+    return from_rle_file(file_path, rule);
+  }
+  rule->birth = CONWAY_BIRTH;
+  rule->survive = CONWAY_SURVIVE;
+  data = from_plaintext_mmap(file_path, threads);
+  if (data != NULL) {
+    fclose(file);
+    return data;
+  }
+  // invalid or unmappable file: sequential reader reports the first error
+  ungetc(first, file);
 
-  char line[MAX_LINE_LENGTH];
-  fgets(line, MAX_LINE_LENGTH, file);
   int w, h;
-  if (sscanf(line, "%d %d", &w, &h) != 2) {
+  if (getline(&line, &line_cap, file) == -1 ||
+      sscanf(line, "%d %d", &w, &h) != 2) {
     printf("Invalid file structure: first line must be 'width height' (eg. '50 "
            "100' for a grid of width 50 and height 100)\n");
     goto fail;
@@ -101,16 +154,17 @@ GameOfLifeData_t *from_file(char *file_path) {
 
   data = init(w, h, grid_alloc(w, h));
   for (int i = 0; i < h; i++) {
-    if (fgets(line, MAX_LINE_LENGTH, file) == NULL) {
+    ssize_t len = getline(&line, &line_cap, file);
+    if (len == -1) {
       printf("Invalid file structure: missing grid rows (expected: %d, found: "
              "%d)\n",
              h, i);
       goto fail;
     }
-    if (strlen(line) - 1 != (size_t)w) {
+    if ((size_t)len - 1 != (size_t)w) {
       printf("Invalid file structure: too much or not enough element on row %d "
-             "(expected: %d, found: %lu)\n",
-             i, w, strlen(line));
+             "(expected: %d, found: %zd)\n",
+             i, w, len);
       goto fail;
     }
     for (int j = 0; j < w; j++) {
@@ -129,9 +183,11 @@ GameOfLifeData_t *from_file(char *file_path) {
       }
     }
   }
+  free(line);
   fclose(file);
   return data;
 fail:
+  free(line);
   if (file != NULL) {
     fclose(file);
   }
@@ -142,136 +198,215 @@ fail:
 }
 
 /**
- * @brief Get number of alive neighbours for cell at position (i, j) in grid,
- * checks up to 8 neighbours.
+ * @brief Write GameOfLifeData_t to file, in RLE format if file name ends with
+ * ".rle" and in from_file() plaintext format otherwise
  *
- * @param data
- * @param i line index
- * @param j column index
- * @return int
+ * @param file_path path of file to write
+ * @param data game of life state to write
+ * @param rule rule of the game (written to RLE files only)
+ * @return int 0 on success, -1 on error
  */
-int get_alive_neighbours_count(GameOfLifeData_t *data, int i, int j) {
-  int count = 0;
-  if (i > 0) {
-    if (j > 0) {
-      count += (int)get_cell_state(i - 1, j - 1, data); // top left
-    }
-    count += (int)get_cell_state(i - 1, j, data); // top
-    if (j < data->w - 1) {
-      count += (int)get_cell_state(i - 1, j + 1, data); // top right
-    }
-  }
-  if (j > 0)
-    count += (int)get_cell_state(i, j - 1, data); // left
-  if (j < data->w - 1) {
-    count += (int)get_cell_state(i, j + 1, data); // right
-  }
-  if (i < data->h - 1) {
-    if (j > 0) {
-      count += (int)get_cell_state(i + 1, j - 1, data); // bottom left
-    }
-    count += (int)get_cell_state(i + 1, j, data); // bottom
-    if (j < data->w - 1) {
-      count += (int)get_cell_state(i + 1, j + 1, data); // bottom right
-    }
+int to_file(char *file_path, GameOfLifeData_t *data, Rule_t *rule) {
+  size_t len = strlen(file_path);
+  if (len >= 4 && strcmp(file_path + len - 4, ".rle") == 0) {
+    return to_rle_file(file_path, data, rule);
   }
-  return count;
-}
-
-/**
- * @brief Update state according to game of life rules (see
- * https://en.wikipedia.org/wiki/Conway's_Game_of_Life#Rules)
- *
- * @param old game of life data to update
- */
-void update(GameOfLifeData_t **old) {
-  GameOfLifeData_t *upd =
-      init((*old)->w, (*old)->h, grid_alloc((*old)->w, (*old)->h));
-  for (int i = 0; i < (*old)->h; i++) {
-    for (int j = 0; j < (*old)->w; j++) {
-      int nghbrs_cnt = get_alive_neighbours_count(*old, i, j);
-      byte old_state = get_cell_state(i, j, (*old));
-      byte upd_state = DEAD;
-      if (old_state == ALIVE && (nghbrs_cnt == 2 || nghbrs_cnt == 3)) {
-        // Cells alive with 2 or 3 alive neighbours stays alive
-        upd_state = ALIVE;
-      } else if (old_state == DEAD && nghbrs_cnt == 3) {
-        // Dead cells with 3 alive neighbours comes back to life
-        upd_state = ALIVE;
-      }
-      set_cell_state(i, j, upd, upd_state);
-    }
+  FILE *file = fopen(file_path, "w");
+  if (file == NULL) {
+    printf("Failed to open file for writing: %s\n", file_path);
+    return -1;
   }
-  free_data(*old);
-  *old = upd;
-}
-
-/**
- * @brief Display current game of life state to terminal, 20x10 display example
- * ('@' = alive cell):
- *
- *  --------------------
- * |           @ @@     |
- * |    @ @    @ @      |
- * |    @    @ @        |
- * |              @     |
- * |     @   @   @    @ |
- * |   @   @       @    |
- * |                    |
- * |      @   @         |
- * | @    @     @       |
- * | @@ @@ @            |
- *  --------------------
- *
- * @param data current game of life state to display
- */
-void display(GameOfLifeData_t *data) {
-  // clear terminal
-  printf("\e[1;1H\e[2J");
-  printf(" ");
-  for (int j = 0; j < data->w; j++) {
-    printf("-");
-  }
-  printf("\n");
+  fprintf(file, "%d %d\n", data->w, data->h);
+  char *line = (char *)malloc((size_t)data->w + 1);
+  line[data->w] = '\n';
   for (int i = 0; i < data->h; i++) {
-    printf("|");
     for (int j = 0; j < data->w; j++) {
-      if (get_cell_state(i, j, data) == ALIVE) {
-        printf("@");
-      } else {
-        printf(" ");
-      }
+      line[j] = get_cell_state(i, j, data) == ALIVE ? '@' : ' ';
     }
-    printf("|");
-    printf("\n");
+    fwrite(line, 1, (size_t)data->w + 1, file);
   }
-  printf(" ");
-  for (int j = 0; j < data->w; j++) {
-    printf("-");
+  free(line);
+  if (fclose(file) != 0) {
+    printf("Failed to write file: %s\n", file_path);
+    return -1;
   }
-  printf("\n");
+  return 0;
 }
 
 int main(int argc, char **argv) {
   struct gengetopt_args_info args;
   cmdline_parser(argc, argv, &args);
+  if (args.trace_arg != NULL && trace_init(args.trace_arg) != 0) {
+    goto fail;
+  }
+  trace_thread_name("main", -1);
   GameOfLifeData_t *data = NULL;
-  if (args.file_arg != NULL) {
-    data = from_file(args.file_arg);
+  Rule_t rule = {CONWAY_BIRTH, CONWAY_SURVIVE};
+  int torus = 0;
+  long generation = 0;
+  if (args.ensemble_given) {
+    if (args.rule_arg != NULL && parse_rule(args.rule_arg, &rule) != 0) {
+      printf("Invalid rule: %s (expected: B/S notation, eg. B36/S23)\n",
+             args.rule_arg);
+      goto fail;
+    }
+    EngineConfig_t config = {args.isa_arg, args.threads_arg,
+                             args.hashlife_memory_arg,
+                             strcmp(args.boundary_arg, "torus") == 0, rule,
+                             args.processes_arg, args.temporal_depth_arg, 0,
+                             0};
+    int ret = run_ensemble(args.ensemble_arg, args.width_arg, args.height_arg,
+                           args.density_arg, (uint64_t)args.seed_arg,
+                           args.iter_arg, &config) != 0;
+    if (free_trace() != 0) {
+      ret = 1;
+    }
+    cmdline_parser_free(&args);
+    return ret;
+  }
+  if (args.restore_arg != NULL || args.replay_arg != NULL ||
+      args.file_arg != NULL) {
+    double start = trace_begin();
+    if (args.restore_arg != NULL) {
+      data = read_checkpoint(args.restore_arg, &rule, &torus, &generation,
+                             args.threads_arg);
+    } else if (args.replay_arg != NULL) {
+      data = read_recording(args.replay_arg, args.seek_arg, &rule, &torus,
+                            &generation);
+    } else {
+      data = from_file(args.file_arg, &rule, args.threads_arg);
+    }
+    trace_end("load", start);
     if (data == NULL) {
-      return 1;
+      goto fail;
     }
   } else {
     data = init(args.width_arg, args.height_arg,
-                generate_random_grid(args.width_arg, args.height_arg));
+                generate_random_grid(args.width_arg, args.height_arg,
+                                     args.density_arg,
+                                     (uint64_t)args.seed_arg,
+                                     args.threads_arg));
+    if (data->grid == NULL) {
+      printf("Failed to allocate %dx%d grid\n", args.width_arg,
+             args.height_arg);
+      free_data(data);
+      goto fail;
+    }
+  }
+  if (args.rule_arg != NULL && parse_rule(args.rule_arg, &rule) != 0) {
+    printf("Invalid rule: %s (expected: B/S notation, eg. B36/S23)\n",
+           args.rule_arg);
+    free_data(data);
+    goto fail;
   }
-  for (int i = 0; i < args.iter_arg; i++) {
-    display(data);
-    sleep(args.display_time_arg);
-    if (i < args.iter_arg - 1) {
-      update(&data);
+  if (args.boundary_given) {
+    torus = strcmp(args.boundary_arg, "torus") == 0;
+  }
+  if (args.fps_given && args.fps_arg <= 0) {
+    printf("Invalid fps: %g (expected: greater than 0)\n", args.fps_arg);
+    free_data(data);
+    goto fail;
+  }
+  if (args.step_arg < 1) {
+    printf("Invalid step: %ld (expected: at least 1)\n", args.step_arg);
+    free_data(data);
+    goto fail;
+  }
+  if (args.hashlife_memory_arg < 1) {
+    printf("Invalid hashlife memory: %d MiB (expected: at least 1)\n",
+           args.hashlife_memory_arg);
+    free_data(data);
+    goto fail;
+  }
+  EngineConfig_t config = {args.isa_arg, args.threads_arg,
+                           args.hashlife_memory_arg, torus, rule,
+                           args.processes_arg, args.temporal_depth_arg,
+                           args.stats_arg != NULL, args.cycle_window_arg > 0};
+  GameOfLifeEngine_t *engine = engine_init(args.engine_arg, data, &config);
+  if (engine == NULL) {
+    free_data(data);
+    goto fail;
+  }
+  engine->generation = generation;
+  if (args.checkpoint_every_arg > 0 && !engine->ops->bounded) {
+    printf("Unsupported checkpoints for engine %s: unbounded plane (only the "
+           "grid window would be saved)\n",
+           engine->ops->name);
+    free_engine(engine);
+    goto fail;
+  }
+  Checkpointer_t checkpoint = {args.checkpoint_arg, args.checkpoint_every_arg,
+                               rule, torus};
+  engine->checkpoint = &checkpoint;
+  if (args.cycle_window_arg > 0) {
+    engine->cycle = cycle_detector_init(args.cycle_window_arg);
+    if (engine->cycle == NULL) {
+      printf("Failed to allocate cycle detector of %d generations\n",
+             args.cycle_window_arg);
+      free_engine(engine);
+      goto fail;
     }
   }
-  free_data(data);
-  return 0;
+  if (args.record_arg != NULL) {
+    engine->recorder =
+        recorder_init(args.record_arg, engine_data(engine), engine->generation,
+                      &rule, torus, args.keyframe_every_arg);
+    if (engine->recorder == NULL) {
+      free_engine(engine);
+      goto fail;
+    }
+  }
+  if (args.stats_arg != NULL) {
+    engine->stats = stats_log_init(args.stats_arg, engine_data(engine),
+                                   engine->ops->stats == NULL);
+    if (engine->stats == NULL) {
+      free_recorder(engine->recorder);
+      free_engine(engine);
+      goto fail;
+    }
+  }
+  int status;
+  if (args.benchmark_flag) {
+    status = run_benchmark(engine, args.threads_arg, args.warmup_arg,
+                           args.iter_arg, args.bench_format_arg);
+  } else {
+    double period = args.fps_given ? 1 / args.fps_arg : args.display_time_arg;
+    status = play(engine, args.iter_arg, args.step_arg, period);
+  }
+  if (status != 0) {
+    free_recorder(engine->recorder);
+    free_stats_log(engine->stats);
+    free_engine(engine);
+    goto fail;
+  }
+  if (!args.benchmark_flag || strcmp(args.bench_format_arg, "text") == 0) {
+    // keep json and csv reports parsable
+    if (engine->cycle != NULL) {
+      print_cycle(engine->cycle);
+    }
+    if (engine->stats != NULL) {
+      print_stats_summary(engine->stats);
+    }
+  }
+  int ret = free_recorder(engine->recorder) != 0;
+  if (free_stats_log(engine->stats) != 0) {
+    ret = 1;
+  }
+  if (args.output_arg != NULL) {
+    double start = trace_begin();
+    if (to_file(args.output_arg, engine_data(engine), &rule) != 0) {
+      ret = 1;
+    }
+    trace_end("save", start);
+  }
+  free_engine(engine);
+  if (free_trace() != 0) {
+    ret = 1;
+  }
+  cmdline_parser_free(&args);
+  return ret;
+fail:
+  free_trace();
+  cmdline_parser_free(&args);
+  return 1;
 }
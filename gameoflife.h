@@ -0,0 +1,57 @@
+#ifndef GAMEOFLIFE_H
+#define GAMEOFLIFE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ALIVE 1
+#define DEAD 0
+
+#define get_cell_state(i, j, data) data->grid[(j) + (size_t)data->w * (i)]
+#define set_cell_state(i, j, data, v) data->grid[(j) + (size_t)data->w * (i)] = v
+#define grid_alloc(w, h) (byte *)malloc((size_t)(h) * (w) * sizeof(byte))
+
+typedef unsigned char byte;
+
+struct GameOfLifeData {
+  int w;      // grid width
+  int h;      // grid height
+  byte *grid; // keeps cells state (DEAD or ALIVE)
+  void *map;  // file mapping holding grid (NULL if grid is malloc'ed)
+  size_t map_size; // size of file mapping
+};
+typedef struct GameOfLifeData GameOfLifeData_t;
+
+/**
+ * @brief Generate random game of life grid of size w * h
+ * (i.e. each cell has a random ALIVE or DEAD state). Cells are drawn from a
+ * counter-based generator (SplitMix64 of the cell index), so that threads
+ * fill bands of the grid independently and the grid only depends on seed.
+ * @param w grid width
+ * @param h grid height
+ * @param density probability of a cell to be ALIVE
+ * @param seed seed of the random stream
+ * @param threads number of threads filling the grid
+ * @return byte* grid (must be free'd by caller, NULL if allocation failed)
+ */
+byte *generate_random_grid(int w, int h, double density, uint64_t seed,
+                           int threads);
+
+/**
+ * @brief Convenient method to create GameOfLifeData_t
+ *
+ * @param w grid width
+ * @param h grid height
+ * @param grid grid containing cells state
+ * @return GameOfLifeData_t* data (must be free'd by caller)
+ */
+GameOfLifeData_t *init(int w, int h, byte *grid);
+
+/**
+ * @brief Convenient method to free GameOfLifeData_t
+ *
+ * @param d data to free
+ */
+void free_data(GameOfLifeData_t *d);
+
+#endif /* GAMEOFLIFE_H */
@@ -0,0 +1,665 @@
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+
+#define MAX_LEVEL 64
+#define MAX_JUMP_LOG2 48 // larger jumps are split (keeps coordinates in range)
+#define NODES_PER_BLOCK 4096
+
+/**
+ * @brief Quadtree node: a square of 2^level x 2^level cells. Nodes are
+ * hash-consed (two nodes with the same children are the same node) so that
+ * identical regions of the universe share both storage and results.
+ */
+typedef struct Node Node_t;
+struct Node {
+  Node_t *nw, *ne, *sw, *se; // quadrants (NULL for leaves, i.e. single cells)
+  Node_t *result; // centered 2^(level-1) square stepped 2^(level-2)
+                  // generations forward (memoized)
+  Node_t *hnext;  // next node of hash table bucket (or of free list)
+  uint64_t population; // number of alive cells
+  uint64_t hash;       // hash of cells (see content_hash), unlike the node
+                       // address it stays valid once node is collected
+  int level;           // node covers 2^level x 2^level cells
+  int marked;          // reachable flag used by garbage collection
+};
+
+/**
+ * @brief Memoized result of a node stepped fewer than 2^(level-2) generations,
+ * keyed by node and step size so that jumps of different sizes (steps that
+ * are not a power of 2) keep each other's results
+ */
+typedef struct Result Result_t;
+struct Result {
+  Node_t *node;    // stepped node
+  int step_log2;   // node stepped 2^step_log2 generations forward
+  Node_t *result;  // centered 2^(level-1) square of node stepped forward
+  Result_t *hnext; // next result of hash table bucket (or of free list)
+};
+
+/**
+ * @brief Hashlife engine state. The universe is unbounded: unlike the other
+ * engines, cells outside of the w x h board are simulated too, the board is
+ * only the window returned by data().
+ */
+struct Hashlife {
+  Node_t leaves[2];         // dead and alive cells
+  Node_t *empty[MAX_LEVEL]; // canonical empty node of each level
+  Node_t **table;           // hash table of all nodes
+  size_t buckets;           // number of buckets of table (power of 2)
+  size_t count;             // number of nodes in table
+  size_t budget;            // max number of nodes and results before
+                            // collecting garbage
+  Node_t **blocks;          // node storage blocks
+  size_t nblocks;           // number of blocks
+  Node_t *free_list;        // free nodes
+  Result_t **results;       // hash table of results of smaller steps
+  size_t result_buckets;    // number of buckets of results (power of 2)
+  size_t result_count;      // number of results in table
+  Result_t **result_blocks; // result storage blocks
+  size_t result_nblocks;    // number of result blocks
+  Result_t *result_free;    // free results
+  Node_t **stack;           // nodes in use by ongoing computation (GC roots)
+  size_t stack_len;         // number of nodes on stack
+  size_t stack_cap;         // capacity of stack
+  int step_log2;            // results step 2^step_log2 generations
+  Rule_t rule;              // rule of leaf generations (without B0: empty
+                            // nodes stay empty)
+  Node_t *root;             // universe
+  int64_t x, y;             // coordinates of root top-left cell
+  GameOfLifeData_t *view;   // board window returned by data()
+  int view_valid;           // whether view is up to date with root
+  jmp_buf out_of_memory;    // where create and step resume when an
+                            // allocation fails in the middle of a computation
+  int failed;               // whether an allocation failed while stepping
+                            // (root holds last generation fully computed)
+};
+typedef struct Hashlife Hashlife_t;
+
+static void collect_garbage(Hashlife_t *hl);
+
+/**
+ * @brief Abort ongoing computation if allocation failed: nodes are allocated
+ * deep in the recursion of next(), so that it resumes in create or step
+ */
+static void check_alloc(Hashlife_t *hl, const void *p) {
+  if (p == NULL) {
+    longjmp(hl->out_of_memory, 1);
+  }
+}
+
+static Node_t *push(Hashlife_t *hl, Node_t *n) {
+  if (hl->stack_len == hl->stack_cap) {
+    Node_t **stack =
+        (Node_t **)realloc(hl->stack, 2 * hl->stack_cap * sizeof(Node_t *));
+    check_alloc(hl, stack);
+    hl->stack = stack;
+    hl->stack_cap *= 2;
+  }
+  hl->stack[hl->stack_len++] = n;
+  return n;
+}
+
+static size_t node_hash(Node_t *nw, Node_t *ne, Node_t *sw, Node_t *se) {
+  uint64_t h = (uint64_t)(uintptr_t)nw;
+  h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)ne;
+  h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)sw;
+  h = h * 0x9E3779B97F4A7C15ULL + (uint64_t)(uintptr_t)se;
+  return (size_t)(h ^ (h >> 29));
+}
+
+/**
+ * @brief Hash of the cells of a node of the given level made of nodes of
+ * hashes nw, ne, sw and se
+ */
+static uint64_t content_hash(uint64_t nw, uint64_t ne, uint64_t sw,
+                             uint64_t se, int level) {
+  uint64_t h = nw * 0x9E3779B97F4A7C15ULL + ne;
+  h = (h ^ (h >> 29)) * 0xBF58476D1CE4E5B9ULL + sw;
+  h = (h ^ (h >> 32)) * 0x94D049BB133111EBULL + se;
+  return hash_part(h, (uint64_t)level);
+}
+
+static void grow_table(Hashlife_t *hl) {
+  size_t buckets = hl->buckets * 2;
+  Node_t **table = (Node_t **)calloc(buckets, sizeof(Node_t *));
+  check_alloc(hl, table);
+  for (size_t b = 0; b < hl->buckets; b++) {
+    Node_t *n = hl->table[b];
+    while (n != NULL) {
+      Node_t *nxt = n->hnext;
+      size_t k = node_hash(n->nw, n->ne, n->sw, n->se) & (buckets - 1);
+      n->hnext = table[k];
+      table[k] = n;
+      n = nxt;
+    }
+  }
+  free(hl->table);
+  hl->table = table;
+  hl->buckets = buckets;
+}
+
+static Node_t *alloc_node(Hashlife_t *hl) {
+  if (hl->free_list == NULL) {
+    Node_t **blocks =
+        (Node_t **)realloc(hl->blocks, (hl->nblocks + 1) * sizeof(Node_t *));
+    check_alloc(hl, blocks);
+    hl->blocks = blocks;
+    Node_t *block = (Node_t *)malloc(NODES_PER_BLOCK * sizeof(Node_t));
+    check_alloc(hl, block);
+    hl->blocks[hl->nblocks++] = block;
+    for (int k = 0; k < NODES_PER_BLOCK; k++) {
+      block[k].hnext = hl->free_list;
+      hl->free_list = &block[k];
+    }
+  }
+  Node_t *n = hl->free_list;
+  hl->free_list = n->hnext;
+  return n;
+}
+
+/**
+ * @brief Get the unique node made of the given quadrants
+ */
+static Node_t *join(Hashlife_t *hl, Node_t *nw, Node_t *ne, Node_t *sw,
+                    Node_t *se) {
+  size_t k = node_hash(nw, ne, sw, se) & (hl->buckets - 1);
+  for (Node_t *n = hl->table[k]; n != NULL; n = n->hnext) {
+    if (n->nw == nw && n->ne == ne && n->sw == sw && n->se == se) {
+      return n;
+    }
+  }
+  if (hl->count + hl->result_count >= hl->budget) {
+    size_t mark = hl->stack_len;
+    push(hl, nw), push(hl, ne), push(hl, sw), push(hl, se);
+    collect_garbage(hl);
+    hl->stack_len = mark;
+  }
+  if (hl->count >= hl->buckets) {
+    grow_table(hl);
+    k = node_hash(nw, ne, sw, se) & (hl->buckets - 1);
+  }
+  Node_t *n = alloc_node(hl);
+  n->nw = nw, n->ne = ne, n->sw = sw, n->se = se;
+  n->result = NULL;
+  n->population =
+      nw->population + ne->population + sw->population + se->population;
+  n->level = nw->level + 1;
+  n->hash = content_hash(nw->hash, ne->hash, sw->hash, se->hash, n->level);
+  n->marked = 0;
+  n->hnext = hl->table[k];
+  hl->table[k] = n;
+  hl->count++;
+  return n;
+}
+
+static Node_t *empty(Hashlife_t *hl, int level) {
+  if (hl->empty[level] == NULL) {
+    Node_t *e = empty(hl, level - 1);
+    hl->empty[level] = join(hl, e, e, e, e);
+  }
+  return hl->empty[level];
+}
+
+static size_t result_hash(Node_t *n, int step_log2) {
+  uint64_t h = (uint64_t)(uintptr_t)n * 0x9E3779B97F4A7C15ULL + step_log2;
+  return (size_t)(h ^ (h >> 29));
+}
+
+static void grow_results(Hashlife_t *hl) {
+  size_t buckets = hl->result_buckets * 2;
+  Result_t **table = (Result_t **)calloc(buckets, sizeof(Result_t *));
+  check_alloc(hl, table);
+  for (size_t b = 0; b < hl->result_buckets; b++) {
+    Result_t *r = hl->results[b];
+    while (r != NULL) {
+      Result_t *nxt = r->hnext;
+      size_t k = result_hash(r->node, r->step_log2) & (buckets - 1);
+      r->hnext = table[k];
+      table[k] = r;
+      r = nxt;
+    }
+  }
+  free(hl->results);
+  hl->results = table;
+  hl->result_buckets = buckets;
+}
+
+/**
+ * @brief Memoized result of n stepped 2^step_log2 generations (NULL if none)
+ */
+static Node_t *find_result(Hashlife_t *hl, Node_t *n, int step_log2) {
+  size_t k = result_hash(n, step_log2) & (hl->result_buckets - 1);
+  for (Result_t *r = hl->results[k]; r != NULL; r = r->hnext) {
+    if (r->node == n && r->step_log2 == step_log2) {
+      return r->result;
+    }
+  }
+  return NULL;
+}
+
+static void add_result(Hashlife_t *hl, Node_t *n, int step_log2,
+                       Node_t *result) {
+  if (hl->result_count >= hl->result_buckets) {
+    grow_results(hl);
+  }
+  if (hl->result_free == NULL) {
+    Result_t **blocks = (Result_t **)realloc(
+        hl->result_blocks, (hl->result_nblocks + 1) * sizeof(Result_t *));
+    check_alloc(hl, blocks);
+    hl->result_blocks = blocks;
+    Result_t *block = (Result_t *)malloc(NODES_PER_BLOCK * sizeof(Result_t));
+    check_alloc(hl, block);
+    hl->result_blocks[hl->result_nblocks++] = block;
+    for (int k = 0; k < NODES_PER_BLOCK; k++) {
+      block[k].hnext = hl->result_free;
+      hl->result_free = &block[k];
+    }
+  }
+  Result_t *r = hl->result_free;
+  hl->result_free = r->hnext;
+  r->node = n;
+  r->step_log2 = step_log2;
+  r->result = result;
+  size_t k = result_hash(n, step_log2) & (hl->result_buckets - 1);
+  r->hnext = hl->results[k];
+  hl->results[k] = r;
+  hl->result_count++;
+}
+
+static void mark(Node_t *n, int follow_results) {
+  if (n == NULL || n->marked || n->level == 0) {
+    return;
+  }
+  n->marked = 1;
+  mark(n->nw, follow_results);
+  mark(n->ne, follow_results);
+  mark(n->sw, follow_results);
+  mark(n->se, follow_results);
+  if (follow_results) {
+    mark(n->result, follow_results);
+  }
+}
+
+/**
+ * @brief Free nodes unreachable from root, empty nodes and stack. Memoized
+ * results are kept first, and dropped too when keeping them leaves less than
+ * half of budget free.
+ */
+static void collect_garbage(Hashlife_t *hl) {
+  for (int pass = 0; pass < 2; pass++) {
+    int follow_results = pass == 0;
+    mark(hl->root, follow_results);
+    for (int l = 0; l < MAX_LEVEL; l++) {
+      mark(hl->empty[l], follow_results);
+    }
+    for (size_t s = 0; s < hl->stack_len; s++) {
+      mark(hl->stack[s], follow_results);
+    }
+    if (follow_results) {
+      for (size_t b = 0; b < hl->result_buckets; b++) {
+        for (Result_t *r = hl->results[b]; r != NULL; r = r->hnext) {
+          if (r->node->marked) {
+            mark(r->result, follow_results);
+          }
+        }
+      }
+    }
+    // results of smaller steps are dropped with their node or result
+    for (size_t b = 0; b < hl->result_buckets; b++) {
+      Result_t **link = &hl->results[b];
+      while (*link != NULL) {
+        Result_t *r = *link;
+        if (r->node->marked && r->result->marked) {
+          link = &r->hnext;
+        } else {
+          *link = r->hnext;
+          r->hnext = hl->result_free;
+          hl->result_free = r;
+          hl->result_count--;
+        }
+      }
+    }
+    for (size_t b = 0; b < hl->buckets; b++) {
+      Node_t **link = &hl->table[b];
+      while (*link != NULL) {
+        Node_t *n = *link;
+        if (n->marked) {
+          if (n->result != NULL && n->result->level > 0 &&
+              !n->result->marked) {
+            n->result = NULL;
+          }
+          link = &n->hnext;
+        } else {
+          *link = n->hnext;
+          n->hnext = hl->free_list;
+          hl->free_list = n;
+          hl->count--;
+        }
+      }
+    }
+    // clear marks of surviving nodes (result check above needs all of them
+    // marked until the sweep is over)
+    for (size_t b = 0; b < hl->buckets; b++) {
+      for (Node_t *n = hl->table[b]; n != NULL; n = n->hnext) {
+        n->marked = 0;
+      }
+    }
+    if (hl->count + hl->result_count < hl->budget / 2) {
+      return;
+    }
+  }
+  if (hl->count + hl->result_count >= hl->budget) {
+    // everything left is in use, let the cache grow past budget
+    size_t used = hl->count + hl->result_count;
+    hl->budget = used + used / 2;
+    fprintf(stderr, "hashlife: memory budget too small, raised to %zu MiB\n",
+            (hl->budget * sizeof(Node_t)) >> 20);
+  }
+}
+
+/**
+ * @brief Base case: compute next generation of the 2x2 center of a 4x4 node
+ */
+static Node_t *next_level2(Hashlife_t *hl, Node_t *n) {
+  int c[4][4];
+  Node_t *q[2][2] = {{n->nw, n->ne}, {n->sw, n->se}};
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      Node_t *m = q[i / 2][j / 2];
+      Node_t *leaf = i % 2 == 0 ? (j % 2 == 0 ? m->nw : m->ne)
+                                : (j % 2 == 0 ? m->sw : m->se);
+      c[i][j] = (int)leaf->population;
+    }
+  }
+  Node_t *r[4];
+  for (int k = 0; k < 4; k++) {
+    int i = 1 + k / 2, j = 1 + k % 2;
+    int cnt = c[i - 1][j - 1] + c[i - 1][j] + c[i - 1][j + 1] + c[i][j - 1] +
+              c[i][j + 1] + c[i + 1][j - 1] + c[i + 1][j] + c[i + 1][j + 1];
+    r[k] = &hl->leaves[rule_cell(cnt, (unsigned char)c[i][j], hl->rule.birth,
+                                 hl->rule.survive)];
+  }
+  return join(hl, r[0], r[1], r[2], r[3]);
+}
+
+/**
+ * @brief Compute the centered 2^(level-1) square of n stepped
+ * 2^min(step_log2, level-2) generations forward (memoized in n->result for
+ * 2^(level-2) generations, in results table for smaller steps)
+ */
+static Node_t *next(Hashlife_t *hl, Node_t *n) {
+  int slow = hl->step_log2 < n->level - 2;
+  if (!slow && n->result != NULL) {
+    return n->result;
+  }
+  if (n->population == 0) {
+    return n->nw;
+  }
+  if (slow) {
+    Node_t *result = find_result(hl, n, hl->step_log2);
+    if (result != NULL) {
+      return result;
+    }
+  }
+  if (n->level == 2) {
+    n->result = next_level2(hl, n);
+    return n->result;
+  }
+  size_t mark = hl->stack_len;
+  push(hl, n);
+  // 9 overlapping sub-squares of half size
+  Node_t *n01 = push(hl, join(hl, n->nw->ne, n->ne->nw, n->nw->se, n->ne->sw));
+  Node_t *n10 = push(hl, join(hl, n->nw->sw, n->nw->se, n->sw->nw, n->sw->ne));
+  Node_t *n11 = push(hl, join(hl, n->nw->se, n->ne->sw, n->sw->ne, n->se->nw));
+  Node_t *n12 = push(hl, join(hl, n->ne->sw, n->ne->se, n->se->nw, n->se->ne));
+  Node_t *n21 = push(hl, join(hl, n->sw->ne, n->se->nw, n->sw->se, n->se->sw));
+  Node_t *r00 = push(hl, next(hl, n->nw));
+  Node_t *r01 = push(hl, next(hl, n01));
+  Node_t *r02 = push(hl, next(hl, n->ne));
+  Node_t *r10 = push(hl, next(hl, n10));
+  Node_t *r11 = push(hl, next(hl, n11));
+  Node_t *r12 = push(hl, next(hl, n12));
+  Node_t *r20 = push(hl, next(hl, n->sw));
+  Node_t *r21 = push(hl, next(hl, n21));
+  Node_t *r22 = push(hl, next(hl, n->se));
+  Node_t *nw, *ne, *sw, *se;
+  if (!slow) {
+    // sub-squares are 2^(level-3) generations ahead, step them again
+    nw = push(hl, next(hl, push(hl, join(hl, r00, r01, r10, r11))));
+    ne = push(hl, next(hl, push(hl, join(hl, r01, r02, r11, r12))));
+    sw = push(hl, next(hl, push(hl, join(hl, r10, r11, r20, r21))));
+    se = push(hl, next(hl, push(hl, join(hl, r11, r12, r21, r22))));
+  } else {
+    // sub-squares are already 2^step_log2 generations ahead, keep centers
+    nw = push(hl, join(hl, r00->se, r01->sw, r10->ne, r11->nw));
+    ne = push(hl, join(hl, r01->se, r02->sw, r11->ne, r12->nw));
+    sw = push(hl, join(hl, r10->se, r11->sw, r20->ne, r21->nw));
+    se = push(hl, join(hl, r11->se, r12->sw, r21->ne, r22->nw));
+  }
+  Node_t *result = join(hl, nw, ne, sw, se);
+  if (slow) {
+    add_result(hl, n, hl->step_log2, result);
+  } else {
+    n->result = result;
+  }
+  hl->stack_len = mark;
+  return result;
+}
+
+/**
+ * @brief Double root size, keeping current universe centered
+ */
+static void expand(Hashlife_t *hl) {
+  Node_t *r = push(hl, hl->root);
+  Node_t *e = empty(hl, r->level - 1);
+  Node_t *nw = push(hl, join(hl, e, e, e, r->nw));
+  Node_t *ne = push(hl, join(hl, e, e, r->ne, e));
+  Node_t *sw = push(hl, join(hl, e, r->sw, e, e));
+  Node_t *se = push(hl, join(hl, r->se, e, e, e));
+  hl->root = join(hl, nw, ne, sw, se);
+  hl->stack_len -= 5;
+  int64_t half = (int64_t)1 << (r->level - 1);
+  hl->x -= half;
+  hl->y -= half;
+}
+
+/**
+ * @brief Whether all alive cells of root are in its centered quarter
+ */
+static int centered(Hashlife_t *hl) {
+  Node_t *r = hl->root;
+  return r->nw->se->se->population + r->ne->sw->sw->population +
+             r->sw->ne->ne->population + r->se->nw->nw->population ==
+         r->population;
+}
+
+/**
+ * @brief Step universe 2^j generations forward with a single next() call
+ */
+static void jump(Hashlife_t *hl, int j) {
+  hl->step_log2 = j;
+  // pattern grows at most 2^j cells in each direction, it must not reach the
+  // border of the centered square returned by next()
+  while (hl->root->level < j + 3 || !centered(hl)) {
+    expand(hl);
+  }
+  int64_t quarter = (int64_t)1 << (hl->root->level - 2);
+  hl->root = next(hl, hl->root);
+  hl->x += quarter;
+  hl->y += quarter;
+}
+
+static Node_t *build(Hashlife_t *hl, GameOfLifeData_t *data, int level,
+                     int64_t x, int64_t y) {
+  if (x >= data->w || y >= data->h) {
+    return empty(hl, level);
+  }
+  if (level == 0) {
+    return &hl->leaves[get_cell_state(y, x, data) == ALIVE];
+  }
+  int64_t half = (int64_t)1 << (level - 1);
+  size_t mark = hl->stack_len;
+  Node_t *nw = push(hl, build(hl, data, level - 1, x, y));
+  Node_t *ne = push(hl, build(hl, data, level - 1, x + half, y));
+  Node_t *sw = push(hl, build(hl, data, level - 1, x, y + half));
+  Node_t *se = push(hl, build(hl, data, level - 1, x + half, y + half));
+  Node_t *n = join(hl, nw, ne, sw, se);
+  hl->stack_len = mark;
+  return n;
+}
+
+static void fill(GameOfLifeData_t *view, Node_t *n, int64_t x, int64_t y) {
+  int64_t size = (int64_t)1 << n->level;
+  if (n->population == 0 || x >= view->w || y >= view->h || x + size <= 0 ||
+      y + size <= 0) {
+    return;
+  }
+  if (n->level == 0) {
+    set_cell_state(y, x, view, ALIVE);
+    return;
+  }
+  int64_t half = size / 2;
+  fill(view, n->nw, x, y);
+  fill(view, n->ne, x + half, y);
+  fill(view, n->sw, x, y + half);
+  fill(view, n->se, x + half, y + half);
+}
+
+/**
+ * @brief Free nodes, results, tables and stack of engine, and engine itself
+ * (not the view, owned by caller until create succeeds)
+ */
+static void free_hashlife(Hashlife_t *hl) {
+  for (size_t b = 0; b < hl->nblocks; b++) {
+    free(hl->blocks[b]);
+  }
+  free(hl->blocks);
+  free(hl->table);
+  for (size_t b = 0; b < hl->result_nblocks; b++) {
+    free(hl->result_blocks[b]);
+  }
+  free(hl->result_blocks);
+  free(hl->results);
+  free(hl->stack);
+  free(hl);
+}
+
+static void *hashlife_engine_create(GameOfLifeData_t *data,
+                                    const EngineConfig_t *config) {
+  Hashlife_t *hl = (Hashlife_t *)calloc(1, sizeof(Hashlife_t));
+  if (hl == NULL) {
+    return NULL;
+  }
+  for (int k = 0; k < 2; k++) {
+    hl->leaves[k].population = k;
+    hl->leaves[k].hash = k;
+    hl->leaves[k].level = 0;
+  }
+  hl->empty[0] = &hl->leaves[DEAD];
+  hl->rule = config->rule;
+  hl->budget = ((size_t)config->hashlife_memory << 20) / sizeof(Node_t);
+  hl->buckets = 1 << 16;
+  hl->table = (Node_t **)calloc(hl->buckets, sizeof(Node_t *));
+  hl->result_buckets = 1 << 12;
+  hl->results = (Result_t **)calloc(hl->result_buckets, sizeof(Result_t *));
+  hl->stack_cap = 1024;
+  hl->stack = (Node_t **)malloc(hl->stack_cap * sizeof(Node_t *));
+  if (hl->table == NULL || hl->results == NULL || hl->stack == NULL ||
+      setjmp(hl->out_of_memory) != 0) {
+    free_hashlife(hl);
+    return NULL;
+  }
+  int level = 3;
+  while (((int64_t)1 << level) < data->w || ((int64_t)1 << level) < data->h) {
+    level++;
+  }
+  hl->root = build(hl, data, level, 0, 0);
+  hl->view = data;
+  hl->view_valid = 1;
+  return hl;
+}
+
+static void hashlife_engine_step(void *state, long n) {
+  Hashlife_t *hl = (Hashlife_t *)state;
+  if (hl->failed) {
+    return;
+  }
+  if (setjmp(hl->out_of_memory) != 0) {
+    printf("Failed to allocate nodes of hashlife engine\n");
+    hl->failed = 1;
+    return;
+  }
+  for (int j = 0; j < (int)(8 * sizeof(long)) - 1; j++) {
+    if ((n >> j) & 1) {
+      if (j <= MAX_JUMP_LOG2) {
+        jump(hl, j);
+      } else {
+        for (long k = 0; k < (1L << (j - MAX_JUMP_LOG2)); k++) {
+          jump(hl, MAX_JUMP_LOG2);
+        }
+      }
+    }
+  }
+  if (n > 0) {
+    hl->view_valid = 0;
+  }
+}
+
+static GameOfLifeData_t *hashlife_engine_data(void *state) {
+  Hashlife_t *hl = (Hashlife_t *)state;
+  if (!hl->view_valid) {
+    memset(hl->view->grid, DEAD, (size_t)hl->view->w * hl->view->h);
+    fill(hl->view, hl->root, hl->x, hl->y);
+    hl->view_valid = 1;
+  }
+  return hl->view;
+}
+
+static uint64_t hashlife_engine_hash(void *state) {
+  Hashlife_t *hl = (Hashlife_t *)state;
+  // root only grows and shrinks around its center (see expand and jump), so
+  // that the smallest centered square holding every alive cell identifies the
+  // universe whatever the root level: its quadrants are the corners of the
+  // root quadrants closest to the center
+  Node_t *nw = hl->root->nw, *ne = hl->root->ne, *sw = hl->root->sw,
+         *se = hl->root->se;
+  while (nw->level > 2 &&
+         nw->se->population + ne->sw->population + sw->ne->population +
+                 se->nw->population ==
+             hl->root->population) {
+    nw = nw->se, ne = ne->sw, sw = sw->ne, se = se->nw;
+  }
+  return content_hash(nw->hash, ne->hash, sw->hash, se->hash, nw->level + 1);
+}
+
+static int hashlife_engine_extinct(void *state) {
+  Hashlife_t *hl = (Hashlife_t *)state;
+  return hl->root->population == 0;
+}
+
+static int hashlife_engine_failed(void *state) {
+  Hashlife_t *hl = (Hashlife_t *)state;
+  return hl->failed;
+}
+
+static void hashlife_engine_destroy(void *state) {
+  Hashlife_t *hl = (Hashlife_t *)state;
+  free_data(hl->view);
+  free_hashlife(hl);
+}
+
+const EngineOps_t hashlife_engine_ops = {
+    .name = "hashlife",
+    .create = hashlife_engine_create,
+    .step = hashlife_engine_step,
+    .hash = hashlife_engine_hash,
+    .extinct = hashlife_engine_extinct,
+    .failed = hashlife_engine_failed,
+    .data = hashlife_engine_data,
+    .destroy = hashlife_engine_destroy,
+};
@@ -0,0 +1,315 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "packed.h"
+
+/**
+ * @brief Bit-packed engine state: each row is stored as ceil(w / 64) words,
+ * column j of a row being bit (j % 64) of word (j / 64). Both grids have one
+ * extra dead row above and below the board so that first and last rows need
+ * no special case.
+ */
+struct PackedEngine {
+  int w;                  // grid width
+  int h;                  // grid height
+  int nw;                 // number of words per row
+  word last_mask;         // valid bits of the last word of a row
+  word *cur;              // current generation ((h + 2) * nw words)
+  word *next;             // preallocated grid receiving next generation
+  int torus;              // whether grid wraps around
+  Rule_t rule;            // rule (used by generic kernel)
+  PackedRowKernel kernel; // row kernel for rule
+  GameOfLifeData_t *view; // byte grid returned by data()
+  int view_valid;         // whether view is up to date with cur
+  int count;              // whether step_rows collects counters
+  GenerationStats_t stats; // counters since last stats() call
+  int hashing;            // whether step_rows hashes rows
+  uint64_t hash;          // hash of current generation (sum of rows hashes)
+  uint64_t next_hash;     // hash of rows of next generation computed so far
+};
+typedef struct PackedEngine PackedEngine_t;
+
+#define packed_row(e, g, i) ((g) + (size_t)(e)->nw * ((i) + 1))
+
+/**
+ * @brief Compute next state of a row
+ *
+ * @param above row above (dead row above first row, unless on a torus)
+ * @param row row to compute
+ * @param below row below (dead row below last row, unless on a torus)
+ * @param out row receiving next state
+ * @param nw number of words per row
+ * @param last_mask valid bits of the last word
+ * @param w number of cells per row
+ * @param torus whether row ends wrap around
+ * @param birth rule birth mask
+ * @param survive rule survive mask
+ */
+static inline __attribute__((always_inline)) void
+packed_step_row(const word *above, const word *row, const word *below,
+                word *out, int nw, word last_mask, int w, int torus,
+                unsigned birth, unsigned survive) {
+  word a_prev = 0, r_prev = 0, b_prev = 0;
+  if (torus) {
+    a_prev = west_wrap(above, w);
+    r_prev = west_wrap(row, w);
+    b_prev = west_wrap(below, w);
+  }
+  word a = above[0], r = row[0], b = below[0];
+  for (int k = 0; k < nw; k++) {
+    word a_next = 0, r_next = 0, b_next = 0;
+    word ae, re, be;
+    if (k + 1 < nw) {
+      a_next = above[k + 1];
+      r_next = row[k + 1];
+      b_next = below[k + 1];
+    }
+    if (torus && k == nw - 1) {
+      ae = east_wrap(a, above, w);
+      re = east_wrap(r, row, w);
+      be = east_wrap(b, below, w);
+    } else {
+      ae = east_of(a, a_next);
+      re = east_of(r, r_next);
+      be = east_of(b, b_next);
+    }
+    out[k] = life_word(west_of(a, a_prev), a, ae, west_of(r, r_prev), r, re,
+                       west_of(b, b_prev), b, be, birth, survive);
+    a_prev = a, r_prev = r, b_prev = b;
+    a = a_next, r = r_next, b = b_next;
+  }
+  out[nw - 1] &= last_mask;
+}
+
+/*
+ * Row kernels of SPECIALIZED_RULES are compiled with constant rule masks, the
+ * generic kernel reads them from rule.
+ */
+#define PACKED_ROW_KERNEL(name, birth, survive)                                \
+  static void packed_row_##name(const word *above, const word *row,            \
+                                const word *below, word *out, int nw,          \
+                                word last_mask, int w, int torus,              \
+                                const Rule_t *rule) {                          \
+    (void)rule;                                                                \
+    packed_step_row(above, row, below, out, nw, last_mask, w, torus, birth,    \
+                    survive);                                                  \
+  }
+SPECIALIZED_RULES(PACKED_ROW_KERNEL)
+PACKED_ROW_KERNEL(generic, rule->birth, rule->survive)
+
+#define PACKED_ROW_KERNEL_ENTRY(name, birth, survive)                          \
+  {{birth, survive}, packed_row_##name},
+static const struct {
+  Rule_t rule;
+  PackedRowKernel kernel;
+} packed_row_kernels[] = {SPECIALIZED_RULES(PACKED_ROW_KERNEL_ENTRY)};
+
+PackedRowKernel packed_row_kernel(const Rule_t *rule) {
+  for (size_t k = 0;
+       k < sizeof(packed_row_kernels) / sizeof(packed_row_kernels[0]); k++) {
+    if (packed_row_kernels[k].rule.birth == rule->birth &&
+        packed_row_kernels[k].rule.survive == rule->survive) {
+      return packed_row_kernels[k].kernel;
+    }
+  }
+  return packed_row_generic;
+}
+
+void wrap_rows(word *rows, int nw, int h) {
+  memcpy(rows - nw, rows + (size_t)nw * (h - 1), nw * sizeof(word));
+  memcpy(rows + (size_t)nw * h, rows, nw * sizeof(word));
+}
+
+void pack_rows(GameOfLifeData_t *data, word *rows, int nw) {
+  for (int i = 0; i < data->h; i++) {
+    pack_cells(&get_cell_state(i, 0, data), data->w, rows + (size_t)nw * i);
+  }
+}
+
+void pack_cells(const byte *cells, int w, word *out) {
+  int k = 0;
+  for (; WORD_BITS * (k + 1) <= w; k++) {
+    word bits = 0;
+#ifdef __SSE2__
+    // cells are 0 or 1: shifted to the top bit of their byte, 16 cells are
+    // gathered by one movemask
+    for (int b = 0; b < 4; b++) {
+      __m128i x = _mm_loadu_si128(
+          (const __m128i *)(cells + WORD_BITS * k + 16 * b));
+      bits |= (word)(uint16_t)_mm_movemask_epi8(_mm_slli_epi64(x, 7))
+              << (16 * b);
+    }
+#else
+    // cells are 0 or 1: the multiply gathers the low bits of 8 bytes (first
+    // byte lowest) in the top byte
+    for (int b = 0; b < 8; b++) {
+      word x;
+      memcpy(&x, cells + WORD_BITS * k + 8 * b, sizeof(x));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      x = __builtin_bswap64(x);
+#endif
+      bits |= (x * 0x0102040810204080ULL) >> 56 << (8 * b);
+    }
+#endif
+    out[k] = bits;
+  }
+  if (WORD_BITS * k < w) {
+    word bits = 0;
+    for (int b = 0; WORD_BITS * k + b < w; b++) {
+      bits |= (word)cells[WORD_BITS * k + b] << b;
+    }
+    out[k] = bits;
+  }
+}
+
+void unpack_rows(const word *rows, int nw, GameOfLifeData_t *data) {
+  for (int i = 0; i < data->h; i++) {
+    const word *row = rows + (size_t)nw * i;
+    byte *cells = &get_cell_state(i, 0, data);
+    int j = 0;
+    for (; j + 8 <= data->w; j += 8) {
+      // spread 8 bits to the low bit of 8 bytes: each byte keeps its own bit
+      // of the broadcast, which adding 0x7f carries to the top bit
+      uint64_t bits = (row[j / WORD_BITS] >> (j % WORD_BITS)) & 0xff;
+      uint64_t x = (bits * 0x0101010101010101ULL) & 0x8040201008040201ULL;
+      x = ((x + 0x7f7f7f7f7f7f7f7fULL) >> 7) & 0x0101010101010101ULL;
+      memcpy(cells + j, &x, sizeof(x));
+    }
+    for (; j < data->w; j++) {
+      set_cell_state(i, j, data,
+                     (byte)((row[j / WORD_BITS] >> (j % WORD_BITS)) & 1));
+    }
+  }
+}
+
+static void *packed_engine_create(GameOfLifeData_t *data,
+                                  const EngineConfig_t *config) {
+  PackedEngine_t *e = (PackedEngine_t *)malloc(sizeof(PackedEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->w = data->w;
+  e->h = data->h;
+  e->nw = (data->w + WORD_BITS - 1) / WORD_BITS;
+  e->last_mask = data->w % WORD_BITS == 0
+                     ? ~(word)0
+                     : ((word)1 << (data->w % WORD_BITS)) - 1;
+  size_t words = (size_t)e->nw * (e->h + 2);
+  e->cur = (word *)calloc(words, sizeof(word));
+  e->next = (word *)calloc(words, sizeof(word));
+  if (e->cur == NULL || e->next == NULL) {
+    free(e->cur);
+    free(e->next);
+    free(e);
+    return NULL;
+  }
+  pack_rows(data, packed_row(e, e->cur, 0), e->nw);
+  e->torus = config->torus;
+  if (e->torus) {
+    wrap_rows(packed_row(e, e->cur, 0), e->nw, e->h);
+  }
+  e->rule = config->rule;
+  e->kernel = packed_row_kernel(&e->rule);
+  e->view = data;
+  e->view_valid = 1;
+  e->count = config->stats;
+  stats_clear(&e->stats);
+  e->hashing = config->hash;
+  e->hash = 0;
+  e->next_hash = 0;
+  for (int i = 0; e->hashing && i < e->h; i++) {
+    e->hash += hash_words(packed_row(e, e->cur, i), e->nw, i);
+  }
+  return e;
+}
+
+static void packed_engine_step_rows(void *state, int begin, int end) {
+  PackedEngine_t *e = (PackedEngine_t *)state;
+  GenerationStats_t band;
+  stats_clear(&band);
+  uint64_t hash = 0;
+  for (int i = begin; i < end; i++) {
+    e->kernel(packed_row(e, e->cur, i - 1), packed_row(e, e->cur, i),
+              packed_row(e, e->cur, i + 1), packed_row(e, e->next, i), e->nw,
+              e->last_mask, e->w, e->torus, &e->rule);
+    // row is still in cache
+    if (e->count) {
+      stats_count_words(packed_row(e, e->cur, i), packed_row(e, e->next, i),
+                        e->nw, i, &band);
+    }
+    if (e->hashing) {
+      hash += hash_words(packed_row(e, e->next, i), e->nw, i);
+    }
+  }
+  if (e->count) {
+    stats_merge(&e->stats, &band);
+  }
+  if (e->hashing) {
+    __atomic_fetch_add(&e->next_hash, hash, __ATOMIC_RELAXED);
+  }
+}
+
+static void packed_engine_swap(void *state) {
+  PackedEngine_t *e = (PackedEngine_t *)state;
+  word *tmp = e->cur;
+  e->cur = e->next;
+  e->next = tmp;
+  if (e->torus) {
+    wrap_rows(packed_row(e, e->cur, 0), e->nw, e->h);
+  }
+  e->view_valid = 0;
+  e->hash = e->next_hash;
+  e->next_hash = 0;
+}
+
+static void packed_engine_stats(void *state, GenerationStats_t *stats) {
+  PackedEngine_t *e = (PackedEngine_t *)state;
+  *stats = e->stats;
+  stats_clear(&e->stats);
+}
+
+static uint64_t packed_engine_hash(void *state) {
+  PackedEngine_t *e = (PackedEngine_t *)state;
+  return e->hash;
+}
+
+static const uint64_t *packed_engine_packed(void *state) {
+  PackedEngine_t *e = (PackedEngine_t *)state;
+  return packed_row(e, e->cur, 0);
+}
+
+static GameOfLifeData_t *packed_engine_data(void *state) {
+  PackedEngine_t *e = (PackedEngine_t *)state;
+  if (!e->view_valid) {
+    unpack_rows(packed_row(e, e->cur, 0), e->nw, e->view);
+    e->view_valid = 1;
+  }
+  return e->view;
+}
+
+static void packed_engine_destroy(void *state) {
+  PackedEngine_t *e = (PackedEngine_t *)state;
+  free(e->cur);
+  free(e->next);
+  free_data(e->view);
+  free(e);
+}
+
+const EngineOps_t packed_engine_ops = {
+    .name = "packed",
+    .torus = 1,
+    .birth0 = 1,
+    .bounded = 1,
+    .create = packed_engine_create,
+    .step_rows = packed_engine_step_rows,
+    .swap = packed_engine_swap,
+    .stats = packed_engine_stats,
+    .hash = packed_engine_hash,
+    .packed = packed_engine_packed,
+    .data = packed_engine_data,
+    .destroy = packed_engine_destroy,
+};
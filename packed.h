@@ -0,0 +1,188 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stdint.h>
+
+#include "gameoflife.h"
+#include "rule.h"
+
+typedef uint64_t word;
+
+#define WORD_BITS 64
+
+/**
+ * @brief Next state of 64 cells from their 4 bits neighbour counts (s3 s2 s1
+ * s0) and current state c. Each count of the rule masks is matched with
+ * bitwise operations, constant masks reducing to the few counts used by the
+ * rule (Conway's rule has a dedicated shortcut).
+ */
+static inline __attribute__((always_inline)) word
+rule_word(word s0, word s1, word s2, word s3, word c, unsigned birth,
+          unsigned survive) {
+  if (birth == CONWAY_BIRTH && survive == CONWAY_SURVIVE) {
+    // alive with 2 or 3 neighbours, or dead with 3 neighbours
+    return s1 & ~s2 & ~s3 & (s0 | c);
+  }
+  word b = 0, s = 0;
+  // fully unrolled so that constant masks fold
+#pragma GCC unroll 9
+  for (int k = 0; k <= 8; k++) {
+    if (((birth | survive) >> k) & 1) {
+      word eq = (k & 1 ? s0 : ~s0) & (k & 2 ? s1 : ~s1) &
+                (k & 4 ? s2 : ~s2) & (k & 8 ? s3 : ~s3);
+      if ((birth >> k) & 1) {
+        b |= eq;
+      }
+      if ((survive >> k) & 1) {
+        s |= eq;
+      }
+    }
+  }
+  return (b & ~c) | (s & c);
+}
+
+/**
+ * @brief Compute next state of 64 cells at once. Each argument holds one
+ * neighbour (or the cell itself for c) of every cell of the word, the 8
+ * neighbours are summed into a 4 bits count (s3 s2 s1 s0) with bitwise full
+ * adders.
+ *
+ * @return word next state of the 64 cells
+ */
+static inline __attribute__((always_inline)) word
+life_word(word nw, word n, word ne, word w, word c, word e, word sw, word s,
+          word se, unsigned birth, unsigned survive) {
+  // row above and row below: 3 cells each, summed to 2 bits
+  word t = nw ^ n;
+  word a0 = t ^ ne;
+  word a1 = (nw & n) | (t & ne);
+  t = sw ^ s;
+  word b0 = t ^ se;
+  word b1 = (sw & s) | (t & se);
+  // current row: 2 cells summed to 2 bits
+  word c0 = w ^ e;
+  word c1 = w & e;
+  // a + b + c
+  word s0 = a0 ^ b0 ^ c0;
+  word k0 = (a0 & b0) | (a0 & c0) | (b0 & c0);
+  word x = a1 ^ b1;
+  word y = a1 & b1;
+  word z = c1 ^ k0;
+  word v = c1 & k0;
+  word s1 = x ^ z;
+  word k1 = x & z;
+  word s2 = y ^ v ^ k1;
+  word s3 = (y & v) | (y & k1) | (v & k1);
+  return rule_word(s0, s1, s2, s3, c, birth, survive);
+}
+
+/**
+ * @brief Shift row words so that each bit holds its west neighbour
+ *
+ * @param x word
+ * @param prev word on the west of x (0 if none)
+ */
+#define west_of(x, prev) (((x) << 1) | ((prev) >> (WORD_BITS - 1)))
+
+/**
+ * @brief Shift row words so that each bit holds its east neighbour
+ *
+ * @param x word
+ * @param next word on the east of x (0 if none)
+ */
+#define east_of(x, next) (((x) >> 1) | ((next) << (WORD_BITS - 1)))
+
+/**
+ * @brief West neighbour word of the first word of a row on a torus: only its
+ * top bit matters to west_of, it holds the last cell of the row
+ *
+ * @param row row words
+ * @param w number of cells per row
+ */
+#define west_wrap(row, w)                                                      \
+  (((row)[((w) - 1) / WORD_BITS] >> (((w) - 1) % WORD_BITS))                  \
+   << (WORD_BITS - 1))
+
+/**
+ * @brief Shift last word x of a row on a torus so that each bit holds its
+ * east neighbour, the first cell of the row being the east neighbour of the
+ * last cell (stored past it when the last word is not full)
+ *
+ * @param x last word of the row
+ * @param row row words
+ * @param w number of cells per row
+ */
+static inline word east_wrap(word x, const word *row, int w) {
+  word first = row[0] & 1;
+  int used = w % WORD_BITS;
+  return used == 0 ? east_of(x, first) : east_of(x | first << used, (word)0);
+}
+
+/**
+ * @brief Row kernel: compute next state of row into out, above and below being
+ * the rows around it (dead rows past the grid edges, unless on a torus)
+ *
+ * @param above row above
+ * @param row row to compute
+ * @param below row below
+ * @param out row receiving next state
+ * @param nw number of words per row
+ * @param last_mask valid bits of the last word
+ * @param w number of cells per row
+ * @param torus whether row ends wrap around
+ * @param rule rule (read by kernels not specialized for it)
+ */
+typedef void (*PackedRowKernel)(const word *above, const word *row,
+                                const word *below, word *out, int nw,
+                                word last_mask, int w, int torus,
+                                const Rule_t *rule);
+
+/**
+ * @brief Get row kernel of rule, specialized at compile time for
+ * SPECIALIZED_RULES and generic otherwise
+ *
+ * @param rule rule
+ * @return PackedRowKernel kernel
+ */
+PackedRowKernel packed_row_kernel(const Rule_t *rule);
+
+/**
+ * @brief Copy last row into the halo row above the first one and first row
+ * into the halo row below the last one (torus boundary)
+ *
+ * @param rows first row, preceded and followed by a halo row
+ * @param nw number of words per row
+ * @param h number of rows
+ */
+void wrap_rows(word *rows, int nw, int h);
+
+/**
+ * @brief Pack byte grid into rows of words (column j of a row being bit
+ * (j % 64) of word (j / 64))
+ *
+ * @param data byte grid to pack
+ * @param rows data->h rows of nw words each
+ * @param nw number of words per row
+ */
+void pack_rows(GameOfLifeData_t *data, word *rows, int nw);
+
+/**
+ * @brief Pack a row of w byte cells into words (same layout as pack_rows,
+ * bits beyond w being 0)
+ *
+ * @param cells row of cells (DEAD or ALIVE)
+ * @param w number of cells
+ * @param out (w + 63) / 64 words
+ */
+void pack_cells(const byte *cells, int w, word *out);
+
+/**
+ * @brief Unpack rows of words into byte grid (reverse of pack_rows)
+ *
+ * @param rows data->h rows of nw words each
+ * @param nw number of words per row
+ * @param data byte grid to fill
+ */
+void unpack_rows(const word *rows, int nw, GameOfLifeData_t *data);
+
+#endif /* PACKED_H */
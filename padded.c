@@ -0,0 +1,54 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "padded.h"
+
+PaddedGrid_t *padded_alloc(int w, int h) {
+  PaddedGrid_t *g = (PaddedGrid_t *)malloc(sizeof(PaddedGrid_t));
+  if (g == NULL) {
+    return NULL;
+  }
+  g->w = w;
+  g->h = h;
+  g->stride = (size_t)w + 2;
+  g->cells = (byte *)calloc(g->stride * ((size_t)h + 2), sizeof(byte));
+  if (g->cells == NULL) {
+    free(g);
+    return NULL;
+  }
+  return g;
+}
+
+void pad_grid(GameOfLifeData_t *data, PaddedGrid_t *g) {
+  for (int i = 0; i < data->h; i++) {
+    memcpy(padded_row(g, i), &get_cell_state(i, 0, data), data->w);
+  }
+}
+
+void unpad_grid(PaddedGrid_t *g, GameOfLifeData_t *data) {
+  for (int i = 0; i < data->h; i++) {
+    memcpy(&get_cell_state(i, 0, data), padded_row(g, i), data->w);
+  }
+}
+
+void refresh_halo(PaddedGrid_t *g, int torus) {
+  if (!torus) {
+    return;
+  }
+  for (int i = 0; i < g->h; i++) {
+    byte *row = padded_row(g, i);
+    row[-1] = row[g->w - 1];
+    row[g->w] = row[0];
+  }
+  // whole rows including halo columns, which fills corners
+  memcpy(padded_row(g, -1) - 1, padded_row(g, g->h - 1) - 1, g->stride);
+  memcpy(padded_row(g, g->h) - 1, padded_row(g, 0) - 1, g->stride);
+}
+
+void free_padded(PaddedGrid_t *g) {
+  if (g == NULL) {
+    return;
+  }
+  free(g->cells);
+  free(g);
+}
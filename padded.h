@@ -0,0 +1,79 @@
+#ifndef PADDED_H
+#define PADDED_H
+
+#include "gameoflife.h"
+
+/**
+ * @brief Byte grid surrounded by a one cell halo: row -1 and row h, column -1
+ * and column w exist, so that kernels read the 8 neighbours of any cell
+ * without bounds checks. Halo holds dead cells, or the opposite edge of the
+ * grid on a torus (see refresh_halo).
+ */
+struct PaddedGrid {
+  int w;        // grid width
+  int h;        // grid height
+  size_t stride; // bytes per row (w + 2)
+  byte *cells;  // (h + 2) rows of stride bytes
+};
+typedef struct PaddedGrid PaddedGrid_t;
+
+/**
+ * @brief Pointer to cell 0 of row i (i in [-1, h])
+ */
+#define padded_row(g, i) ((g)->cells + (g)->stride * ((i) + 1) + 1)
+
+/**
+ * @brief Number of alive neighbours of cell j of row r, a and b being the
+ * rows above and below (padded rows, j - 1 and j + 1 are always readable)
+ */
+static inline byte padded_count(const byte *a, const byte *r, const byte *b,
+                                int j) {
+  // byte sum so that kernels vectorize on byte lanes
+  return (byte)(a[j - 1] + a[j] + a[j + 1] + r[j - 1] + r[j + 1] + b[j - 1] +
+                b[j] + b[j + 1]);
+}
+
+/**
+ * @brief Allocate padded grid with dead halo
+ *
+ * @param w grid width
+ * @param h grid height
+ * @return PaddedGrid_t* grid (must be free'd by caller with free_padded,
+ * NULL on allocation failure)
+ */
+PaddedGrid_t *padded_alloc(int w, int h);
+
+/**
+ * @brief Copy byte grid into padded grid interior
+ *
+ * @param data byte grid
+ * @param g padded grid of the same size
+ */
+void pad_grid(GameOfLifeData_t *data, PaddedGrid_t *g);
+
+/**
+ * @brief Copy padded grid interior into byte grid
+ *
+ * @param g padded grid
+ * @param data byte grid of the same size
+ */
+void unpad_grid(PaddedGrid_t *g, GameOfLifeData_t *data);
+
+/**
+ * @brief Refresh halo after interior changed: on a torus halo receives the
+ * opposite rows, columns and corners, otherwise it stays dead (it is never
+ * written)
+ *
+ * @param g padded grid
+ * @param torus whether grid wraps around
+ */
+void refresh_halo(PaddedGrid_t *g, int torus);
+
+/**
+ * @brief Free padded grid
+ *
+ * @param g padded grid to free
+ */
+void free_padded(PaddedGrid_t *g);
+
+#endif /* PADDED_H */
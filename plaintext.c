@@ -0,0 +1,108 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "plaintext.h"
+#include "threadpool.h"
+
+/**
+ * @brief Rows conversion task shared by loading threads
+ */
+struct PlaintextLoad {
+  const char *rows;       // first row in mapped file
+  size_t available;       // number of mapped bytes from first row
+  GameOfLifeData_t *data; // grid to fill
+  int invalid;            // set if any row is invalid
+};
+typedef struct PlaintextLoad PlaintextLoad_t;
+
+static void convert_band(void *arg, int id, int count) {
+  PlaintextLoad_t *load = (PlaintextLoad_t *)arg;
+  GameOfLifeData_t *data = load->data;
+  size_t row_len = (size_t)data->w + 1;
+  int begin = (int)((long)data->h * id / count);
+  int end = (int)((long)data->h * (id + 1) / count);
+  // other bands may flag the file invalid concurrently
+  for (int i = begin;
+       i < end && !__atomic_load_n(&load->invalid, __ATOMIC_RELAXED); i++) {
+    size_t pos = row_len * i;
+    if (pos + row_len > load->available || load->rows[pos + data->w] != '\n') {
+      __atomic_store_n(&load->invalid, 1, __ATOMIC_RELAXED);
+      return;
+    }
+    const char *src = load->rows + pos;
+    byte *dst = &get_cell_state(i, 0, data);
+    byte bad = 0;
+    for (int j = 0; j < data->w; j++) {
+      char c = src[j];
+      dst[j] = (byte)(c == '@');
+      bad |= (byte)((c != '@') & (c != ' '));
+    }
+    if (bad) {
+      __atomic_store_n(&load->invalid, 1, __ATOMIC_RELAXED);
+      return;
+    }
+  }
+}
+
+GameOfLifeData_t *from_plaintext_mmap(const char *file_path, int threads) {
+  int fd = open(file_path, O_RDONLY);
+  if (fd == -1) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = (size_t)st.st_size;
+  char *map = (char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  // header is copied since mapping is not NUL terminated, long headers are
+  // left to the sequential reader
+  GameOfLifeData_t *data = NULL;
+  char header[64];
+  const char *eol =
+      memchr(map, '\n', size < sizeof(header) ? size : sizeof(header));
+  if (eol == NULL) {
+    goto done;
+  }
+  size_t header_len = (size_t)(eol - map) + 1;
+  memcpy(header, map, header_len - 1);
+  header[header_len - 1] = '\0';
+  int w, h;
+  if (sscanf(header, "%d %d", &w, &h) != 2 || w <= 0 || h <= 0) {
+    goto done;
+  }
+  data = init(w, h, grid_alloc(w, h));
+  if (data->grid == NULL) {
+    free_data(data);
+    data = NULL;
+    goto done;
+  }
+  PlaintextLoad_t load = {map + header_len, size - header_len, data, 0};
+  ThreadPool_t *pool = threadpool_init(threads < 1 ? 1 : threads);
+  if (pool != NULL) {
+    threadpool_run(pool, convert_band, &load);
+    free_threadpool(pool);
+  } else {
+    // threads could not be started, grid is converted by calling thread
+    convert_band(&load, 0, 1);
+  }
+  if (load.invalid) {
+    free_data(data);
+    data = NULL;
+  }
+done:
+  munmap(map, size);
+  return data;
+}
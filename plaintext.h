@@ -0,0 +1,21 @@
+#ifndef PLAINTEXT_H
+#define PLAINTEXT_H
+
+#include "gameoflife.h"
+
+/**
+ * @brief Fast path of from_file() for plaintext files: the file is mmap'ed,
+ * rows are located from their fixed length (width + '\n') and converted to
+ * cells by threads threads working on bands of rows.
+ *
+ * Nothing is printed on error: caller is expected to fall back to the
+ * sequential reader, which reports the first error of the file.
+ *
+ * @param file_path path of file to parse
+ * @param threads number of threads converting rows
+ * @return GameOfLifeData_t* data (must be free'd by caller, NULL if file
+ * could not be mapped or is invalid)
+ */
+GameOfLifeData_t *from_plaintext_mmap(const char *file_path, int threads);
+
+#endif /* PLAINTEXT_H */
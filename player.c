@@ -0,0 +1,158 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "framequeue.h"
+#include "player.h"
+#include "render.h"
+#include "trace.h"
+
+// back-off of a side waiting for the other one
+#define POLL_INTERVAL_NS 200000L
+
+/**
+ * @brief Simulation thread state
+ */
+struct Simulation {
+  GameOfLifeEngine_t *engine;
+  FrameQueue_t *queue;
+  int iter;
+  long step;
+  double start;  // display time of first frame
+  double period; // display period in seconds
+};
+typedef struct Simulation Simulation_t;
+
+static void wait_a_bit(void) {
+  struct timespec ts = {0, POLL_INTERVAL_NS};
+  nanosleep(&ts, NULL);
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleep_until(double deadline) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)deadline;
+  ts.tv_nsec = (long)((deadline - ts.tv_sec) * 1e9);
+  // restart when interrupted by a signal
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}
+
+static void *simulate(void *arg) {
+  Simulation_t *sim = (Simulation_t *)arg;
+  trace_thread_name("simulation", -1);
+  for (int i = 0; i < sim->iter; i++) {
+    Frame_t *frame;
+    double due = sim->start + i * sim->period;
+    double start = trace_begin();
+    // queue is full when simulation is ahead of display schedule or display
+    // falls behind: oldest frame waiting for display is overwritten in the
+    // latter case
+    while ((frame = frame_queue_reserve(sim->queue)) == NULL) {
+      if (sim->period > 0 && now() >= due &&
+          (frame = frame_queue_drop(sim->queue)) != NULL) {
+        break;
+      }
+      wait_a_bit();
+    }
+    trace_end("wait display", start);
+    start = trace_begin();
+    GameOfLifeData_t *data = engine_data(sim->engine);
+    memcpy(frame->data.grid, data->grid, (size_t)data->w * data->h);
+    frame->generation = sim->engine->generation;
+    frame->active_tiles =
+        engine_active_tiles(sim->engine, &frame->total_tiles);
+    // engine does not step anymore once a cycle is found or it failed
+    int last = i == sim->iter - 1 || engine_cycle_found(sim->engine) ||
+               engine_failed(sim->engine);
+    frame->last = last;
+    frame_queue_publish(sim->queue);
+    trace_end("frame", start);
+    if (last) {
+      break;
+    }
+    engine_step(sim->engine, sim->step);
+  }
+  return NULL;
+}
+
+int play(GameOfLifeEngine_t *engine, int iter, long step, double period) {
+  if (iter <= 0) {
+    return 0;
+  }
+  GameOfLifeData_t *data = engine_data(engine);
+  FrameQueue_t *queue = frame_queue_init(data->w, data->h);
+  Renderer_t *renderer = renderer_init(data->w, data->h);
+  if (queue == NULL || renderer == NULL) {
+    printf("Failed to allocate %dx%d frame buffers\n", data->w, data->h);
+    free_frame_queue(queue);
+    free_renderer(renderer);
+    return -1;
+  }
+  double start = now();
+  Simulation_t sim = {engine, queue, iter, step, start, period};
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, simulate, &sim) != 0) {
+    printf("Failed to start simulation thread\n");
+    free_frame_queue(queue);
+    free_renderer(renderer);
+    return -1;
+  }
+
+  long last_seq = -1; // sequence number of last displayed frame
+  int last = 0;
+  while (!last) {
+    Frame_t *frame;
+    double span = trace_begin();
+    while ((frame = frame_queue_peek(queue)) == NULL) {
+      wait_a_bit();
+    }
+    trace_end("wait simulation", span);
+    if (period > 0 && frame->seq > 0) {
+      // frames whose display time already passed are skipped, newest ready
+      // frame is kept
+      long due = (long)((now() - start) / period);
+      while (due > (long)frame->seq && frame_queue_ready(queue) > 0 &&
+             !frame->last) {
+        frame_queue_release(queue);
+        // a frame dropped meanwhile by simulation thread is published again
+        while ((frame = frame_queue_peek(queue)) == NULL) {
+          wait_a_bit();
+        }
+      }
+    }
+    // frames dropped by simulation thread or skipped above since last
+    // displayed frame
+    long skipped = (long)frame->seq - last_seq - 1;
+    span = trace_begin();
+    display(renderer, &frame->data);
+    if (frame->active_tiles >= 0 && frame->generation > 0) {
+      printf("generation %ld: %ld/%ld active tiles\n", frame->generation,
+             frame->active_tiles, frame->total_tiles);
+    }
+    if (skipped > 0) {
+      printf("skipped frames: %ld\n", skipped);
+    }
+    fflush(stdout);
+    trace_end("display", span);
+    last = frame->last;
+    last_seq = (long)frame->seq;
+    frame_queue_release(queue);
+    if (period > 0) {
+      span = trace_begin();
+      sleep_until(start + (last_seq + 1) * period);
+      trace_end("sleep", span);
+    }
+  }
+  pthread_join(thread, NULL);
+  free_renderer(renderer);
+  free_frame_queue(queue);
+  return engine_failed(engine) ? -1 : 0;
+}
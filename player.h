@@ -0,0 +1,25 @@
+#ifndef PLAYER_H
+#define PLAYER_H
+
+#include "engine.h"
+
+/**
+ * @brief Play game of life in terminal: a simulation thread computes
+ * generations ahead into a frame queue while calling thread displays them
+ * every period seconds. Simulation only waits to stay a few frames ahead of
+ * display schedule: when display falls behind it, simulation overwrites the
+ * oldest frame not displayed yet and display skips to the newest frame, so
+ * that simulation is not slowed down by rendering. First and last frames are
+ * always displayed, the run ends early on the frame where engine found a
+ * cycle.
+ *
+ * @param engine engine computing generations
+ * @param iter number of displayed iterations
+ * @param step number of generations between two iterations
+ * @param period display period in seconds (0 displays frames as soon as they
+ * are computed)
+ * @return int 0 if OK, -1 on allocation failure or if engine failed
+ */
+int play(GameOfLifeEngine_t *engine, int iter, long step, double period);
+
+#endif /* PLAYER_H */
@@ -0,0 +1,632 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "packed.h"
+#include "recorder.h"
+#include "trace.h"
+
+// back-off of a side waiting for the other one
+#define POLL_INTERVAL_NS 200000L
+// maximum size of a LEB128 varint of 64 bits
+#define VARINT_MAX 10
+// maximum number of records written as keyframes without trying a delta
+// after deltas turned out larger than keyframes
+#define DELTA_BACKOFF_MAX 64
+
+// shuffle moving the bytes of a word selected by a dense delta mask to its
+// low end (0x80 clearing the others), and number of bytes selected by mask
+static byte dense_shuffle[256][8];
+static byte dense_count[256];
+
+static void wait_a_bit(void) {
+  struct timespec ts = {0, POLL_INTERVAL_NS};
+  nanosleep(&ts, NULL);
+}
+
+/**
+ * @brief Encode words of bits differing from previous generation
+ *
+ * @param r recorder
+ * @param bits bit-packed generation to encode
+ * @param limit maximum payload size (a keyframe being smaller beyond it)
+ * @return size_t payload size (larger than limit if encoding was abandoned)
+ */
+static size_t encode_delta(Recorder_t *r, const uint64_t *bits, size_t limit) {
+  byte *out = r->buffer;
+  size_t n = 0;
+  size_t next = 0; // word following the last written one
+  for (size_t k = 0; k < r->words; k++) {
+    uint64_t x = bits[k] ^ r->prev[k];
+    if (x == 0) {
+      continue;
+    }
+    uint64_t gap = k - next;
+    next = k + 1;
+    do {
+      out[n++] = (byte)((gap & 0x7f) | (gap > 0x7f ? 0x80 : 0));
+      gap >>= 7;
+    } while (gap != 0);
+    memcpy(out + n, &x, sizeof(x));
+    n += sizeof(x);
+    if (n > limit) {
+      return n;
+    }
+  }
+  return n;
+}
+
+/**
+ * @brief Append word x of a dense delta to out at n
+ *
+ * @return size_t size of out
+ */
+static inline size_t dense_word(byte *out, size_t n, uint64_t x) {
+  size_t at = n++;
+  byte mask = 0;
+  // every byte is stored, only the ones that are not 0 are kept
+  for (int b = 0; b < 8; b++) {
+    byte v = (byte)(x >> (8 * b));
+    out[n] = v;
+    mask |= (byte)((v != 0) << b);
+    n += v != 0;
+  }
+  out[at] = mask;
+  return n;
+}
+
+static size_t dense_delta(const uint64_t *bits, const uint64_t *prev,
+                          size_t words, byte *out, size_t limit) {
+  size_t n = 0;
+  for (size_t k = 0; k < words && n <= limit; k++) {
+    n = dense_word(out, n, bits[k] ^ prev[k]);
+  }
+  return n;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// two words per iteration, their bytes being moved by a shuffle each (5 to 8
+// times faster than the byte loop)
+__attribute__((target("ssse3"))) static size_t
+dense_delta_ssse3(const uint64_t *bits, const uint64_t *prev, size_t words,
+                  byte *out, size_t limit) {
+  const __m128i zero = _mm_setzero_si128();
+  // second word takes bytes 8 to 15 of the register (0x88 still clears)
+  const __m128i high = _mm_set1_epi8(8);
+  size_t n = 0, k = 0;
+  for (; k + 1 < words && n <= limit; k += 2) {
+    __m128i x =
+        _mm_xor_si128(_mm_loadu_si128((const __m128i *)(bits + k)),
+                      _mm_loadu_si128((const __m128i *)(prev + k)));
+    unsigned kept = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero));
+    byte lo = (byte)kept, hi = (byte)(kept >> 8);
+    __m128i lo_bytes = _mm_shuffle_epi8(
+        x, _mm_loadl_epi64((const __m128i *)dense_shuffle[lo]));
+    __m128i hi_bytes = _mm_shuffle_epi8(
+        x, _mm_add_epi8(_mm_loadl_epi64((const __m128i *)dense_shuffle[hi]),
+                        high));
+    out[n] = lo;
+    _mm_storel_epi64((__m128i *)(out + n + 1), lo_bytes);
+    n += 1 + dense_count[lo];
+    out[n] = hi;
+    _mm_storel_epi64((__m128i *)(out + n + 1), hi_bytes);
+    n += 1 + dense_count[hi];
+  }
+  if (k < words && n <= limit) {
+    n = dense_word(out, n, bits[k] ^ prev[k]);
+  }
+  return n;
+}
+#endif
+
+/**
+ * @brief Encode every word of bits XOR previous generation as a mask of its
+ * bytes that are not 0 followed by these bytes. Smaller than words differing
+ * from previous generation once most of them do (soups).
+ *
+ * @param r recorder
+ * @param bits bit-packed generation to encode
+ * @param limit maximum payload size (a keyframe being smaller beyond it)
+ * @return size_t payload size (larger than limit if encoding was abandoned)
+ */
+static size_t encode_dense_delta(Recorder_t *r, const uint64_t *bits,
+                                 size_t limit) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("ssse3")) {
+    return dense_delta_ssse3(bits, r->prev, r->words, r->buffer, limit);
+  }
+#endif
+  return dense_delta(bits, r->prev, r->words, r->buffer, limit);
+}
+
+/**
+ * @brief Apply payload of a RECORD_DELTA record to bit-packed grid
+ *
+ * @return int 0 if OK, -1 if payload is invalid
+ */
+static int apply_delta(const byte *payload, size_t size, uint64_t *bits,
+                       size_t words) {
+  size_t next = 0;
+  for (size_t n = 0; n < size;) {
+    uint64_t gap = 0;
+    int shift = 0;
+    byte b;
+    do {
+      if (n == size || shift >= 64) {
+        return -1;
+      }
+      b = payload[n++];
+      gap |= (uint64_t)(b & 0x7f) << shift;
+      shift += 7;
+    } while (b & 0x80);
+    if (gap >= words - next || size - n < sizeof(uint64_t)) {
+      return -1;
+    }
+    next += gap;
+    uint64_t x;
+    memcpy(&x, payload + n, sizeof(x));
+    n += sizeof(x);
+    bits[next++] ^= x;
+  }
+  return 0;
+}
+
+/**
+ * @brief Apply payload of a RECORD_DENSE_DELTA record to bit-packed grid
+ *
+ * @return int 0 if OK, -1 if payload is invalid
+ */
+static int apply_dense_delta(const byte *payload, size_t size, uint64_t *bits,
+                             size_t words) {
+  size_t n = 0;
+  for (size_t k = 0; k < words; k++) {
+    if (n == size) {
+      return -1;
+    }
+    byte mask = payload[n++];
+    if (size - n < (size_t)__builtin_popcount(mask)) {
+      return -1;
+    }
+    uint64_t x = 0;
+    for (int b = 0; b < 8; b++) {
+      if ((mask >> b) & 1) {
+        x |= (uint64_t)payload[n++] << (8 * b);
+      }
+    }
+    bits[k] ^= x;
+  }
+  return n == size ? 0 : -1;
+}
+
+/**
+ * @brief Append generation to recording, as a keyframe when one is due or
+ * when it is smaller than the delta. A delta of changed words is tried
+ * first, and dropped for a dense delta once larger than its byte masks alone:
+ * following deltas are then encoded dense until few bytes change. After
+ * deltas turned out larger than keyframes (young random soups), the next
+ * records are written as keyframes without trying a delta, twice as many
+ * after each failed try.
+ *
+ * @return int 0 if OK, -1 if write failed
+ */
+static int write_record(Recorder_t *r, const uint64_t *bits, long generation) {
+  size_t keyframe_size = r->words * sizeof(uint64_t);
+  RecordHeader_t record = {generation, 0, RECORD_DELTA, 0};
+  const void *payload = r->buffer;
+  int keyframe = r->header.keyframes == 0 ||
+                 generation - r->last_keyframe >= r->keyframe_every ||
+                 r->delta_skip > 0;
+  if (r->delta_skip > 0) {
+    r->delta_skip--;
+  } else if (!keyframe) {
+    if (!r->dense) {
+      // dense deltas take at least a byte per word
+      record.size = encode_delta(r, bits, r->words);
+      r->dense = record.size > r->words;
+    }
+    if (r->dense) {
+      record.type = RECORD_DENSE_DELTA;
+      record.size = encode_dense_delta(r, bits, keyframe_size);
+      // a delta of words may be smaller again once most bytes are 0
+      r->dense = record.size >= 2 * r->words;
+    }
+    keyframe = record.size > keyframe_size;
+    if (keyframe) {
+      r->delta_backoff = r->delta_backoff == 0 ? 1 : 2 * r->delta_backoff;
+      if (r->delta_backoff > DELTA_BACKOFF_MAX) {
+        r->delta_backoff = DELTA_BACKOFF_MAX;
+      }
+      r->delta_skip = r->delta_backoff;
+    } else {
+      r->delta_backoff = 0;
+    }
+  }
+  if (keyframe) {
+    if (r->header.keyframes == r->capacity) {
+      size_t capacity = r->capacity == 0 ? 64 : 2 * r->capacity;
+      KeyframeEntry_t *index = (KeyframeEntry_t *)realloc(
+          r->index, capacity * sizeof(KeyframeEntry_t));
+      if (index == NULL) {
+        return -1;
+      }
+      r->index = index;
+      r->capacity = capacity;
+    }
+    KeyframeEntry_t entry = {generation, r->offset};
+    r->index[r->header.keyframes++] = entry;
+    r->last_keyframe = generation;
+    record.type = RECORD_KEYFRAME;
+    record.size = keyframe_size;
+    payload = bits;
+  }
+  if (fwrite(&record, sizeof(record), 1, r->file) != 1 ||
+      fwrite(payload, 1, record.size, r->file) != record.size) {
+    return -1;
+  }
+  r->offset += sizeof(record) + record.size;
+  r->header.last_generation = generation;
+  return 0;
+}
+
+/**
+ * @brief Writer thread: encodes and writes queued generations until the
+ * last frame
+ *
+ * @param arg recorder
+ */
+static void *write_records(void *arg) {
+  Recorder_t *r = (Recorder_t *)arg;
+  trace_thread_name("recorder", -1);
+  for (;;) {
+    Frame_t *frame;
+    while ((frame = frame_queue_peek(r->queue)) == NULL) {
+      wait_a_bit();
+    }
+    if (frame->last) {
+      frame_queue_release(r->queue);
+      return NULL;
+    }
+    double start = trace_begin();
+    if (!r->failed &&
+        write_record(r, (const uint64_t *)frame->data.grid,
+                     frame->generation)) {
+      r->failed = 1;
+    }
+    // written generation is the previous one of next record: frame takes
+    // over the buffer of the one before instead of copying it
+    byte *grid = frame->data.grid;
+    frame->data.grid = (byte *)r->prev;
+    r->prev = (uint64_t *)grid;
+    frame_queue_release(r->queue);
+    trace_end("write record", start);
+  }
+}
+
+/**
+ * @brief Free recorder buffers and close file (writer thread is not running)
+ */
+static void free_recorder_buffers(Recorder_t *r) {
+  if (r->file != NULL) {
+    fclose(r->file);
+  }
+  free_frame_queue(r->queue);
+  free(r->prev);
+  free(r->buffer);
+  free(r->index);
+  free(r);
+}
+
+Recorder_t *recorder_init(const char *path, GameOfLifeData_t *data,
+                          long generation, const Rule_t *rule, int torus,
+                          long keyframe_every) {
+  Recorder_t *r = (Recorder_t *)calloc(1, sizeof(Recorder_t));
+  if (r == NULL) {
+    printf("Failed to allocate recording buffers\n");
+    return NULL;
+  }
+  r->path = path;
+  r->w = data->w;
+  r->h = data->h;
+  r->nw = (data->w + WORD_BITS - 1) / WORD_BITS;
+  r->words = (size_t)r->nw * data->h;
+  r->keyframe_every = keyframe_every < 1 ? 1 : keyframe_every;
+  // frames hold bit-packed generations (h rows of nw * 8 bytes)
+  r->queue = frame_queue_init(r->nw * (int)sizeof(uint64_t), data->h);
+  r->prev = (uint64_t *)malloc(r->words * sizeof(uint64_t));
+  // a delta is abandoned once larger than a keyframe (word deltas go past it
+  // by an entry, dense deltas by the stores of two words)
+  r->buffer = (byte *)malloc(r->words * sizeof(uint64_t) + sizeof(uint64_t) +
+                             VARINT_MAX);
+  if (r->queue == NULL || r->prev == NULL || r->buffer == NULL) {
+    printf("Failed to allocate %dx%d recording buffers\n", data->w, data->h);
+    free_recorder_buffers(r);
+    return NULL;
+  }
+  r->file = fopen(path, "w");
+  if (r->file == NULL) {
+    printf("Failed to open file: %s\n", path);
+    free_recorder_buffers(r);
+    return NULL;
+  }
+  for (int mask = 0; mask < 256; mask++) {
+    int count = 0;
+    for (int b = 0; b < 8; b++) {
+      if ((mask >> b) & 1) {
+        dense_shuffle[mask][count++] = (byte)b;
+      }
+    }
+    dense_count[mask] = (byte)count;
+    memset(dense_shuffle[mask] + count, 0x80, 8 - count);
+  }
+  memcpy(r->header.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+  r->header.version = RECORDING_VERSION;
+  r->header.w = data->w;
+  r->header.h = data->h;
+  r->header.birth = rule->birth;
+  r->header.survive = rule->survive;
+  r->header.torus = torus != 0;
+  // header is written again with the index once recording ends
+  if (fwrite(&r->header, sizeof(r->header), 1, r->file) != 1) {
+    printf("Failed to write recording: %s\n", path);
+    free_recorder_buffers(r);
+    return NULL;
+  }
+  r->offset = sizeof(r->header);
+  if (pthread_create(&r->thread, NULL, write_records, r) != 0) {
+    printf("Failed to start recording thread\n");
+    free_recorder_buffers(r);
+    return NULL;
+  }
+  recorder_add(r, data, NULL, generation);
+  return r;
+}
+
+uint64_t *recorder_reserve(Recorder_t *recorder) {
+  Frame_t *frame;
+  double start = trace_begin();
+  // queue is full when writer thread is behind simulation
+  while ((frame = frame_queue_reserve(recorder->queue)) == NULL) {
+    wait_a_bit();
+  }
+  trace_end("wait recorder", start);
+  return (uint64_t *)frame->data.grid;
+}
+
+void recorder_publish(Recorder_t *recorder, long generation) {
+  Frame_t *frame = frame_queue_reserve(recorder->queue);
+  frame->generation = generation;
+  frame->last = 0;
+  frame_queue_publish(recorder->queue);
+}
+
+void recorder_add(Recorder_t *recorder, GameOfLifeData_t *data,
+                  const uint64_t *rows, long generation) {
+  uint64_t *bits = recorder_reserve(recorder);
+  double start = trace_begin();
+  if (rows != NULL) {
+    memcpy(bits, rows, recorder->words * sizeof(uint64_t));
+  } else {
+    for (int i = 0; i < recorder->h; i++) {
+      pack_cells(&get_cell_state(i, 0, data), recorder->w,
+                 bits + (size_t)recorder->nw * i);
+    }
+  }
+  trace_end("record", start);
+  recorder_publish(recorder, generation);
+}
+
+int free_recorder(Recorder_t *recorder) {
+  if (recorder == NULL) {
+    return 0;
+  }
+  Frame_t *frame;
+  while ((frame = frame_queue_reserve(recorder->queue)) == NULL) {
+    wait_a_bit();
+  }
+  frame->last = 1;
+  frame_queue_publish(recorder->queue);
+  pthread_join(recorder->thread, NULL);
+
+  RecordingHeader_t *header = &recorder->header;
+  header->index_offset = recorder->offset;
+  int ok = !recorder->failed &&
+           fwrite(recorder->index, sizeof(KeyframeEntry_t),
+                  header->keyframes, recorder->file) == header->keyframes &&
+           fseek(recorder->file, 0, SEEK_SET) == 0 &&
+           fwrite(header, sizeof(*header), 1, recorder->file) == 1;
+  ok = fclose(recorder->file) == 0 && ok;
+  recorder->file = NULL;
+  if (!ok) {
+    printf("Failed to write recording: %s\n", recorder->path);
+  }
+  free_recorder_buffers(recorder);
+  return ok ? 0 : -1;
+}
+
+/**
+ * @brief Build keyframe index of a recording whose index is missing by
+ * scanning record headers, up to the first record cut by end of file
+ *
+ * @param file recording file
+ * @param header recording header (receives keyframes and last_generation)
+ * @return KeyframeEntry_t* index (must be free'd by caller, NULL on error)
+ */
+static KeyframeEntry_t *scan_keyframes(FILE *file, RecordingHeader_t *header) {
+  size_t capacity = 64;
+  KeyframeEntry_t *index =
+      (KeyframeEntry_t *)malloc(capacity * sizeof(KeyframeEntry_t));
+  uint64_t offset = sizeof(RecordingHeader_t);
+  RecordHeader_t record;
+  header->keyframes = 0;
+  header->last_generation = -1;
+  if (fseeko(file, 0, SEEK_END) != 0) {
+    free(index);
+    return NULL;
+  }
+  uint64_t end = (uint64_t)ftello(file);
+  while (index != NULL && fseeko(file, (off_t)offset, SEEK_SET) == 0 &&
+         fread(&record, sizeof(record), 1, file) == 1 &&
+         record.size <= end - offset - sizeof(record)) {
+    if (record.type == RECORD_KEYFRAME) {
+      if (header->keyframes == capacity) {
+        capacity *= 2;
+        KeyframeEntry_t *grown = (KeyframeEntry_t *)realloc(
+            index, capacity * sizeof(KeyframeEntry_t));
+        if (grown == NULL) {
+          free(index);
+          return NULL;
+        }
+        index = grown;
+      }
+      KeyframeEntry_t entry = {record.generation, offset};
+      index[header->keyframes++] = entry;
+    }
+    header->last_generation = record.generation;
+    offset += sizeof(record) + record.size;
+  }
+  return index;
+}
+
+/**
+ * @brief Apply record payload to bit-packed grid
+ *
+ * @return int 0 if OK, -1 if payload is invalid
+ */
+static int apply_record(const RecordHeader_t *record, const byte *payload,
+                        uint64_t *bits, size_t words) {
+  if (record->type == RECORD_KEYFRAME) {
+    if (record->size != words * sizeof(uint64_t)) {
+      return -1;
+    }
+    memcpy(bits, payload, record->size);
+    return 0;
+  }
+  if (record->type == RECORD_DELTA) {
+    return apply_delta(payload, record->size, bits, words);
+  }
+  if (record->type == RECORD_DENSE_DELTA) {
+    return apply_dense_delta(payload, record->size, bits, words);
+  }
+  return -1;
+}
+
+GameOfLifeData_t *read_recording(const char *path, long target, Rule_t *rule,
+                                 int *torus, long *generation) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    printf("Failed to open file: %s\n", path);
+    return NULL;
+  }
+  GameOfLifeData_t *data = NULL;
+  KeyframeEntry_t *index = NULL;
+  uint64_t *bits = NULL;
+  byte *payload = NULL;
+  RecordingHeader_t header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0) {
+    printf("Invalid recording: %s (bad magic)\n", path);
+    goto fail;
+  }
+  if (header.version < RECORDING_MIN_VERSION ||
+      header.version > RECORDING_VERSION) {
+    printf("Invalid recording: %s (unsupported version %u, expected: %d to "
+           "%d)\n",
+           path, header.version, RECORDING_MIN_VERSION, RECORDING_VERSION);
+    goto fail;
+  }
+  if (header.w <= 0 || header.h <= 0) {
+    printf("Invalid recording: %s (invalid size %dx%d)\n", path, header.w,
+           header.h);
+    goto fail;
+  }
+  if (header.index_offset != 0) {
+    index = (KeyframeEntry_t *)malloc(header.keyframes *
+                                      sizeof(KeyframeEntry_t));
+    if (index == NULL ||
+        fseeko(file, (off_t)header.index_offset, SEEK_SET) != 0 ||
+        fread(index, sizeof(KeyframeEntry_t), header.keyframes, file) !=
+            header.keyframes) {
+      printf("Invalid recording: %s (truncated keyframe index)\n", path);
+      goto fail;
+    }
+  } else {
+    // recording was interrupted before its index was written
+    index = scan_keyframes(file, &header);
+    if (index == NULL) {
+      printf("Failed to allocate keyframe index of %s\n", path);
+      goto fail;
+    }
+  }
+  if (target < 0) {
+    target = header.last_generation;
+  }
+  // last keyframe at or before target
+  size_t k = header.keyframes;
+  while (k > 0 && index[k - 1].generation > target) {
+    k--;
+  }
+  if (k == 0 || target > header.last_generation) {
+    printf("Generation %ld not recorded in %s\n", target, path);
+    goto fail;
+  }
+  int nw = (header.w + WORD_BITS - 1) / WORD_BITS;
+  size_t words = (size_t)nw * header.h;
+  size_t max_payload =
+      words * sizeof(uint64_t) + sizeof(uint64_t) + VARINT_MAX;
+  data = init(header.w, header.h, grid_alloc(header.w, header.h));
+  bits = (uint64_t *)malloc(words * sizeof(uint64_t));
+  payload = (byte *)malloc(max_payload);
+  if (data->grid == NULL || bits == NULL || payload == NULL) {
+    printf("Failed to allocate %dx%d grid\n", header.w, header.h);
+    goto fail;
+  }
+  if (fseeko(file, (off_t)index[k - 1].offset, SEEK_SET) != 0) {
+    printf("Invalid recording: %s (truncated)\n", path);
+    goto fail;
+  }
+  for (;;) {
+    RecordHeader_t record;
+    if (fread(&record, sizeof(record), 1, file) != 1 ||
+        record.size > max_payload ||
+        fread(payload, 1, record.size, file) != record.size) {
+      printf("Invalid recording: %s (truncated)\n", path);
+      goto fail;
+    }
+    if (apply_record(&record, payload, bits, words) != 0) {
+      printf("Invalid recording: %s (invalid record of generation %ld)\n",
+             path, (long)record.generation);
+      goto fail;
+    }
+    if (record.generation == target) {
+      break;
+    }
+    if (record.generation > target) {
+      printf("Generation %ld not recorded in %s\n", target, path);
+      goto fail;
+    }
+  }
+  unpack_rows(bits, nw, data);
+  rule->birth = header.birth;
+  rule->survive = header.survive;
+  *torus = header.torus != 0;
+  *generation = target;
+  fclose(file);
+  free(index);
+  free(bits);
+  free(payload);
+  return data;
+
+fail:
+  fclose(file);
+  free(index);
+  free(bits);
+  free(payload);
+  if (data != NULL) {
+    free_data(data);
+  }
+  return NULL;
+}
@@ -0,0 +1,170 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "framequeue.h"
+#include "gameoflife.h"
+#include "rule.h"
+
+#define RECORDING_MAGIC "GOLREC"
+#define RECORDING_VERSION 3
+#define RECORDING_MIN_VERSION 2 // oldest readable version (without dense
+                                // deltas)
+
+// record types
+#define RECORD_KEYFRAME 0 // bit-packed grid: h rows of (w + 63) / 64 words,
+                          // column j in bit j % 64 of word j / 64
+#define RECORD_DELTA 1    // words of the bit-packed grid XOR the previous
+                          // record that are not 0, each preceded by a LEB128
+                          // varint of the number of 0 words skipped
+#define RECORD_DENSE_DELTA 2 // every word of the bit-packed grid XOR the
+                             // previous record as a mask of its bytes that
+                             // are not 0 (bit b for byte b, lowest byte
+                             // first) followed by these bytes
+
+/**
+ * @brief Recording file header (host byte order), followed by records. The
+ * keyframe index is appended when recording ends, files of interrupted
+ * recordings have index_offset 0 and are scanned instead.
+ */
+struct RecordingHeader {
+  char magic[8];           // RECORDING_MAGIC
+  uint32_t version;        // RECORDING_VERSION
+  int32_t w;               // grid width
+  int32_t h;               // grid height
+  uint16_t birth;          // rule birth mask (see Rule_t)
+  uint16_t survive;        // rule survive mask (see Rule_t)
+  int64_t last_generation; // generation of last record
+  uint64_t index_offset;   // offset of keyframe index (0 if missing)
+  uint64_t keyframes;      // number of index entries
+  uint32_t torus;          // 1 if grid wraps around, 0 if cells outside are
+                           // dead (see EngineConfig_t)
+  uint32_t reserved;       // 0
+};
+typedef struct RecordingHeader RecordingHeader_t;
+
+/**
+ * @brief Record header, followed by size bytes of payload
+ */
+struct RecordHeader {
+  int64_t generation; // generation of grid after record
+  uint64_t size;      // payload size
+  uint32_t type;      // RECORD_KEYFRAME or RECORD_DELTA
+  uint32_t reserved;  // 0
+};
+typedef struct RecordHeader RecordHeader_t;
+
+/**
+ * @brief Keyframe index entry
+ */
+struct KeyframeEntry {
+  int64_t generation; // generation of keyframe
+  uint64_t offset;    // offset of keyframe record header in file
+};
+typedef struct KeyframeEntry KeyframeEntry_t;
+
+/**
+ * @brief Streaming recording of a run: generations are bit-packed into a
+ * frame queue, then encoded and written by a background writer thread.
+ */
+struct Recorder {
+  const char *path;       // recording file
+  FILE *file;             // recording file (writer side)
+  RecordingHeader_t header;
+  FrameQueue_t *queue;    // generations waiting to be written
+  pthread_t thread;       // writer thread
+  uint64_t *prev;         // bit-packed last written generation
+  byte *buffer;           // encoded delta payload (writer side)
+  int w;                  // grid width
+  int h;                  // grid height
+  int nw;                 // number of words per row of bit-packed grids
+  size_t words;           // number of words of bit-packed grids
+  long keyframe_every;    // maximum generations between two keyframes
+  long last_keyframe;     // generation of last keyframe
+  long delta_skip;        // records left to write as keyframes without
+                          // trying a delta
+  long delta_backoff;     // records skipped after last failed delta try
+  int dense;              // whether next delta is encoded dense without
+                          // trying a delta of words
+  uint64_t offset;        // bytes written so far
+  KeyframeEntry_t *index; // keyframes written so far
+  size_t capacity;        // capacity of index
+  int failed;             // set if a write failed
+};
+typedef struct Recorder Recorder_t;
+
+/**
+ * @brief Create recording file and start writer thread, data being written
+ * as the first keyframe
+ *
+ * @param path path of recording file
+ * @param data initial grid
+ * @param generation generation of initial grid
+ * @param rule rule of the run
+ * @param torus whether grid wraps around
+ * @param keyframe_every maximum number of generations between two keyframes
+ * @return Recorder_t* recorder (must be closed by caller with free_recorder,
+ * NULL on error)
+ */
+Recorder_t *recorder_init(const char *path, GameOfLifeData_t *data,
+                          long generation, const Rule_t *rule, int torus,
+                          long keyframe_every);
+
+/**
+ * @brief Reserve the frame of next generation (waits while writer thread is
+ * behind), to be filled by caller then published with recorder_publish
+ *
+ * @param recorder recorder
+ * @return uint64_t* h rows of (w + 63) / 64 words to fill, column j in bit
+ * j % 64 of word j / 64, bits beyond w being 0
+ */
+uint64_t *recorder_reserve(Recorder_t *recorder);
+
+/**
+ * @brief Queue the reserved frame for writing
+ *
+ * @param recorder recorder
+ * @param generation generation of grid
+ */
+void recorder_publish(Recorder_t *recorder, long generation);
+
+/**
+ * @brief Pack generation into frame queue for writing (waits while writer
+ * thread is behind)
+ *
+ * @param recorder recorder
+ * @param data grid (unused if rows is given)
+ * @param rows grid already bit-packed by engine (see recorder_reserve, NULL
+ * to pack data)
+ * @param generation generation of grid
+ */
+void recorder_add(Recorder_t *recorder, GameOfLifeData_t *data,
+                  const uint64_t *rows, long generation);
+
+/**
+ * @brief Write queued generations and keyframe index, close recording file
+ * and free recorder (NULL is ignored)
+ *
+ * @param recorder recorder to close
+ * @return int 0 if OK, -1 if a write failed
+ */
+int free_recorder(Recorder_t *recorder);
+
+/**
+ * @brief Load one generation of a recording: the last keyframe at or before
+ * it is decoded, then following deltas are applied up to it.
+ *
+ * @param path path of recording file
+ * @param target generation to load (last recorded generation if negative)
+ * @param rule receives rule of the run
+ * @param torus receives whether grid wraps around
+ * @param generation receives generation of grid
+ * @return GameOfLifeData_t* data (must be free'd by caller, NULL on error)
+ */
+GameOfLifeData_t *read_recording(const char *path, long target, Rule_t *rule,
+                                 int *torus, long *generation);
+
+#endif /* RECORDER_H */
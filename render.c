@@ -0,0 +1,162 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "render.h"
+
+// longest cursor move sequence: "\e[" row ';' col 'H'
+#define CURSOR_MOVE_MAX (2 + 10 + 1 + 10 + 1)
+// unchanged cells between two changes are resent when it is shorter than
+// moving the cursor over them
+#define MAX_RESENT_GAP 8
+
+static char cell_char(byte state) { return state == ALIVE ? '@' : ' '; }
+
+static char *cursor_move(char *out, int row, int col) {
+  return out + sprintf(out, "\e[%d;%dH", row, col);
+}
+
+static void write_all(const char *buf, size_t len) {
+  // buffered printf output (eg. status lines) goes first
+  fflush(stdout);
+  while (len > 0) {
+    ssize_t written = write(STDOUT_FILENO, buf, len);
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    buf += written;
+    len -= (size_t)written;
+  }
+}
+
+Renderer_t *renderer_init(int w, int h) {
+  Renderer_t *renderer = calloc(1, sizeof(Renderer_t));
+  if (renderer == NULL) {
+    return NULL;
+  }
+  renderer->w = w;
+  renderer->h = h;
+  // full frame: clear sequence, borders and rows, diff frame: at most one
+  // cursor move every MAX_RESENT_GAP + 1 cells of a row
+  size_t full = 16 + ((size_t)w + 3) * ((size_t)h + 2);
+  size_t diff = (size_t)h * ((size_t)w / (MAX_RESENT_GAP + 1) + 1) *
+                    CURSOR_MOVE_MAX +
+                (size_t)w * h + CURSOR_MOVE_MAX + 4;
+  renderer->cap = full > diff ? full : diff;
+  renderer->buf = malloc(renderer->cap);
+  if (renderer->buf == NULL) {
+    free(renderer);
+    return NULL;
+  }
+  return renderer;
+}
+
+/**
+ * @brief Compose full frame, 20x10 display example ('@' = alive cell):
+ *
+ *  --------------------
+ * |           @ @@     |
+ * |    @ @    @ @      |
+ * |    @    @ @        |
+ * |              @     |
+ * |     @   @   @    @ |
+ * |   @   @       @    |
+ * |                    |
+ * |      @   @         |
+ * | @    @     @       |
+ * | @@ @@ @            |
+ *  --------------------
+ *
+ * @return char* end of composed frame
+ */
+static char *compose_full(Renderer_t *renderer, GameOfLifeData_t *data) {
+  char *out = renderer->buf;
+  // clear terminal
+  out += sprintf(out, "\e[1;1H\e[2J");
+  *out++ = ' ';
+  memset(out, '-', data->w);
+  out += data->w;
+  *out++ = '\n';
+  for (int i = 0; i < data->h; i++) {
+    *out++ = '|';
+    const byte *row = &get_cell_state(i, 0, data);
+    for (int j = 0; j < data->w; j++) {
+      out[j] = cell_char(row[j]);
+    }
+    out += data->w;
+    *out++ = '|';
+    *out++ = '\n';
+  }
+  *out++ = ' ';
+  memset(out, '-', data->w);
+  out += data->w;
+  *out++ = '\n';
+  return out;
+}
+
+/**
+ * @brief Compose cursor-addressed updates of cells changed since previous
+ * frame (grid cell (i, j) is at terminal row i + 2, column j + 2)
+ *
+ * @return char* end of composed frame
+ */
+static char *compose_diff(Renderer_t *renderer, GameOfLifeData_t *data) {
+  char *out = renderer->buf;
+  for (int i = 0; i < data->h; i++) {
+    const byte *row = &get_cell_state(i, 0, data);
+    const byte *prev = renderer->prev + (size_t)i * data->w;
+    int j = 0;
+    while (j < data->w) {
+      if (row[j] == prev[j]) {
+        j++;
+        continue;
+      }
+      // run of changes, extended over short unchanged gaps
+      int end = j + 1, last = j;
+      while (end < data->w && end - last <= MAX_RESENT_GAP) {
+        if (row[end] != prev[end]) {
+          last = end;
+        }
+        end++;
+      }
+      out = cursor_move(out, i + 2, j + 2);
+      for (int k = j; k <= last; k++) {
+        *out++ = cell_char(row[k]);
+      }
+      j = last + 1;
+    }
+  }
+  // leave cursor below frame, where full frames leave it, and clear lines
+  // printed there after previous frame
+  out = cursor_move(out, data->h + 3, 1);
+  out += sprintf(out, "\e[J");
+  return out;
+}
+
+void display(Renderer_t *renderer, GameOfLifeData_t *data) {
+  char *end;
+  if (renderer->prev == NULL) {
+    end = compose_full(renderer, data);
+    renderer->prev = malloc((size_t)data->w * data->h);
+  } else {
+    end = compose_diff(renderer, data);
+  }
+  if (renderer->prev != NULL) {
+    memcpy(renderer->prev, data->grid, (size_t)data->w * data->h);
+  }
+  write_all(renderer->buf, (size_t)(end - renderer->buf));
+}
+
+void free_renderer(Renderer_t *renderer) {
+  if (renderer == NULL) {
+    return;
+  }
+  free(renderer->prev);
+  free(renderer->buf);
+  free(renderer);
+}
@@ -0,0 +1,46 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stddef.h>
+
+#include "gameoflife.h"
+
+/**
+ * @brief Terminal renderer: frames are composed in a single preallocated
+ * buffer and written with one write() call. Only the first frame is fully
+ * painted, next ones only send cells changed since the previous frame.
+ */
+struct Renderer {
+  int w, h;      // size of displayed grid
+  byte *prev;    // last displayed grid (NULL until first frame)
+  char *buf;     // frame buffer
+  size_t cap;    // frame buffer capacity (fits a full frame or worst diff)
+};
+typedef struct Renderer Renderer_t;
+
+/**
+ * @brief Allocate renderer for w x h grids
+ *
+ * @param w grid width
+ * @param h grid height
+ * @return Renderer_t* renderer (must be free'd by caller with free_renderer,
+ * NULL on allocation failure)
+ */
+Renderer_t *renderer_init(int w, int h);
+
+/**
+ * @brief Display current game of life state to terminal
+ *
+ * @param renderer renderer
+ * @param data current game of life state to display (same size as renderer)
+ */
+void display(Renderer_t *renderer, GameOfLifeData_t *data);
+
+/**
+ * @brief Free renderer
+ *
+ * @param renderer renderer to free
+ */
+void free_renderer(Renderer_t *renderer);
+
+#endif /* RENDER_H */
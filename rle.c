@@ -0,0 +1,240 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rle.h"
+
+#define READ_BUFFER_SIZE (1 << 20)
+#define MAX_RLE_LINE_LENGTH 70
+
+/**
+ * @brief Parse "x = m, y = n, rule = abc" header line. The rule value runs to
+ * the end of the line (Golly rules may contain commas, eg. B3/S23:T100,50),
+ * a Golly bounded grid suffix (":T100,50") is ignored.
+ *
+ * @return int 0 on success, -1 on error
+ */
+static int parse_header(char *line, int *w, int *h, Rule_t *rule) {
+  int has_x = 0, has_y = 0;
+  char *item = line;
+  while (item != NULL) {
+    char *eq = strchr(item, '=');
+    if (eq == NULL) {
+      return -1;
+    }
+    *eq = '\0';
+    char key[16];
+    if (sscanf(item, " %15s", key) != 1) {
+      return -1;
+    }
+    char *value = eq + 1;
+    if (strcmp(key, "rule") == 0) {
+      value[strcspn(value, "\r\n")] = '\0';
+      item = NULL;
+    } else {
+      item = strchr(value, ',');
+      if (item != NULL) {
+        *item++ = '\0';
+      }
+    }
+    if (strcmp(key, "x") == 0) {
+      has_x = sscanf(value, "%d", w) == 1;
+    } else if (strcmp(key, "y") == 0) {
+      has_y = sscanf(value, "%d", h) == 1;
+    } else if (strcmp(key, "rule") == 0) {
+      char *topology = strchr(value, ':');
+      if (topology != NULL) {
+        printf("Ignoring RLE grid topology '%s' (see --boundary)\n",
+               topology);
+        *topology = '\0';
+      }
+      if (parse_rule(value, rule) != 0) {
+        printf("Invalid RLE header: unsupported rule '%s'\n", value);
+        return -1;
+      }
+    }
+  }
+  return has_x && has_y && *w > 0 && *h > 0 ? 0 : -1;
+}
+
+GameOfLifeData_t *from_rle_file(const char *file_path, Rule_t *rule) {
+  GameOfLifeData_t *data = NULL;
+  char *line = NULL;
+  size_t line_cap = 0;
+  char *buf = NULL;
+  FILE *file = fopen(file_path, "r");
+  if (file == NULL) {
+    printf("Failed to open file: %s\n", file_path);
+    goto fail;
+  }
+
+  rule->birth = CONWAY_BIRTH;
+  rule->survive = CONWAY_SURVIVE;
+  int w = 0, h = 0;
+  // skip '#' comment lines until header
+  while (1) {
+    if (getline(&line, &line_cap, file) == -1) {
+      printf("Invalid RLE file: missing 'x = width, y = height' header\n");
+      goto fail;
+    }
+    if (line[0] != '#' && line[strspn(line, " \t\r\n")] != '\0') {
+      break;
+    }
+  }
+  if (parse_header(line, &w, &h, rule) != 0) {
+    printf("Invalid RLE header: expected 'x = width, y = height' (eg. 'x = "
+           "50, y = 100, rule = B3/S23')\n");
+    goto fail;
+  }
+
+  // dead cells are never written: zeroed pages come for free from calloc
+  data = init(w, h, (byte *)calloc((size_t)w * h, sizeof(byte)));
+  buf = (char *)malloc(READ_BUFFER_SIZE);
+  if (data->grid == NULL || buf == NULL) {
+    printf("Failed to allocate %dx%d grid\n", w, h);
+    goto fail;
+  }
+  // run counts are bounded by the grid size, positions saturate past it
+  size_t max_count = (size_t)(w > h ? w : h);
+  size_t count = 0;
+  size_t row = 0;
+  size_t col = 0;
+  int done = 0;
+  size_t n;
+  while (!done && (n = fread(buf, 1, READ_BUFFER_SIZE, file)) > 0) {
+    for (size_t k = 0; k < n && !done; k++) {
+      char c = buf[k];
+      if (c >= '0' && c <= '9') {
+        count = count * 10 + (size_t)(c - '0');
+        if (count > max_count) {
+          printf("Invalid RLE file: run count larger than %dx%d grid\n", w,
+                 h);
+          goto fail;
+        }
+        continue;
+      }
+      size_t run = count == 0 ? 1 : count;
+      count = 0;
+      switch (c) {
+      case 'b':
+      case '.':
+        col = col > (size_t)w ? col : col + run;
+        break;
+      case '$':
+        row = row > (size_t)h ? row : row + run;
+        col = 0;
+        break;
+      case '!':
+        done = 1;
+        break;
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+        break;
+      default:
+        if (c != 'o' && !(c >= 'A' && c <= 'X')) {
+          printf("Invalid RLE file: invalid pattern value (expected: 'b', "
+                 "'o', '$' or '!', found: '%c')\n",
+                 c);
+          goto fail;
+        }
+        if (row >= (size_t)h || col > (size_t)w || run > (size_t)w - col) {
+          printf("Invalid RLE file: pattern does not fit in %dx%d grid (live "
+                 "cells on row %zu, columns %zu to %zu)\n",
+                 w, h, row, col, col + run - 1);
+          goto fail;
+        }
+        memset(&get_cell_state(row, col, data), ALIVE, run);
+        col += run;
+      }
+    }
+  }
+  if (!done) {
+    printf("Invalid RLE file: missing '!' at end of pattern\n");
+    goto fail;
+  }
+  free(buf);
+  free(line);
+  fclose(file);
+  return data;
+fail:
+  free(buf);
+  free(line);
+  if (file != NULL) {
+    fclose(file);
+  }
+  if (data != NULL) {
+    free_data(data);
+  }
+  return NULL;
+}
+
+/**
+ * @brief RLE output stream, wraps lines at MAX_RLE_LINE_LENGTH characters
+ */
+struct RleWriter {
+  FILE *file;
+  int line_length;
+};
+typedef struct RleWriter RleWriter_t;
+
+static void write_run(RleWriter_t *out, size_t run, char tag) {
+  char item[32];
+  int len = run == 1 ? snprintf(item, sizeof(item), "%c", tag)
+                     : snprintf(item, sizeof(item), "%zu%c", run, tag);
+  if (out->line_length + len > MAX_RLE_LINE_LENGTH) {
+    fputc('\n', out->file);
+    out->line_length = 0;
+  }
+  fputs(item, out->file);
+  out->line_length += len;
+}
+
+int to_rle_file(const char *file_path, GameOfLifeData_t *data,
+                const Rule_t *rule) {
+  FILE *file = fopen(file_path, "w");
+  if (file == NULL) {
+    printf("Failed to open file for writing: %s\n", file_path);
+    return -1;
+  }
+  char rule_str[RULE_MAX_LENGTH];
+  format_rule(rule, rule_str);
+  fprintf(file, "x = %d, y = %d, rule = %s\n", data->w, data->h, rule_str);
+  RleWriter_t out = {file, 0};
+  size_t pending_rows = 0; // end of rows not written yet
+  for (int i = 0; i < data->h; i++) {
+    const byte *row = &get_cell_state(i, 0, data);
+    size_t j = 0, w = (size_t)data->w;
+    while (j < w) {
+      const byte *alive = (const byte *)memchr(row + j, ALIVE, w - j);
+      if (alive == NULL) {
+        // trailing dead cells of a row are implicit
+        break;
+      }
+      size_t start = (size_t)(alive - row);
+      size_t end = start;
+      while (end < w && row[end] == ALIVE) {
+        end++;
+      }
+      if (pending_rows > 0) {
+        write_run(&out, pending_rows, '$');
+        pending_rows = 0;
+      }
+      if (start > j) {
+        write_run(&out, start - j, 'b');
+      }
+      write_run(&out, end - start, 'o');
+      j = end;
+    }
+    pending_rows++;
+  }
+  write_run(&out, 1, '!');
+  fputc('\n', file);
+  if (fclose(file) != 0) {
+    printf("Failed to write file: %s\n", file_path);
+    return -1;
+  }
+  return 0;
+}
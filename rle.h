@@ -0,0 +1,39 @@
+#ifndef RLE_H
+#define RLE_H
+
+#include "gameoflife.h"
+#include "rule.h"
+
+/**
+ * @brief Retrieve GameOfLifeData_t from RLE file (run length encoded format
+ * used by Golly and LifeWiki, see
+ * https://conwaylife.com/wiki/Run_Length_Encoded)
+ *        eg. file for a glider on a 5x5 grid ('b' = dead cell, 'o' = live
+ *        cell, '$' = end of row, '!' = end of pattern, optional run count
+ *        before each of them):
+ *        """
+ *        #N Glider
+ *        x = 5, y = 5, rule = B3/S23
+ *        bo$2bo$3o!
+ *        """
+ * The pattern is decoded straight into the grid while the file is streamed,
+ * so there is no limit on grid width.
+ *
+ * @param file_path path of file to parse
+ * @param rule receives rule of the header (B3/S23 when the header has none)
+ * @return GameOfLifeData_t* data (must be free'd by caller, NULL on error)
+ */
+GameOfLifeData_t *from_rle_file(const char *file_path, Rule_t *rule);
+
+/**
+ * @brief Write GameOfLifeData_t to RLE file
+ *
+ * @param file_path path of file to write
+ * @param data game of life state to write
+ * @param rule rule written in header
+ * @return int 0 on success, -1 on error
+ */
+int to_rle_file(const char *file_path, GameOfLifeData_t *data,
+                const Rule_t *rule);
+
+#endif /* RLE_H */
@@ -0,0 +1,93 @@
+#include <ctype.h>
+#include <string.h>
+
+#include "rule.h"
+
+/**
+ * @brief Parse neighbour counts digits until '/' or end of string
+ *
+ * @param str string to parse, updated to point after parsed digits
+ * @param mask receives one bit per parsed count
+ * @return int 0 on success, -1 on invalid character
+ */
+static int parse_counts(const char **str, unsigned short *mask) {
+  *mask = 0;
+  while (**str != '\0' && **str != '/') {
+    if (**str < '0' || **str > '8') {
+      return -1;
+    }
+    *mask |= (unsigned short)(1 << (**str - '0'));
+    (*str)++;
+  }
+  return 0;
+}
+
+int parse_rule(const char *str, Rule_t *rule) {
+  char buf[64];
+  size_t len = 0;
+  // drop blanks (RLE headers may contain some)
+  for (; *str != '\0' && len < sizeof(buf) - 1; str++) {
+    if (!isspace((unsigned char)*str)) {
+      buf[len++] = (char)toupper((unsigned char)*str);
+    }
+  }
+  buf[len] = '\0';
+  const char *s = buf;
+  const char *slash = strchr(buf, '/');
+  if (slash == NULL) {
+    return -1;
+  }
+  if (buf[0] != 'B' && buf[0] != 'S') {
+    // S/B notation: survival counts first
+    if (parse_counts(&s, &rule->survive) != 0 || *s != '/') {
+      return -1;
+    }
+    s++;
+    return parse_counts(&s, &rule->birth) == 0 && *s == '\0' ? 0 : -1;
+  }
+  int has_birth = 0, has_survive = 0;
+  for (int part = 0; part < 2; part++) {
+    char tag = *s++;
+    if (tag == 'B' && !has_birth) {
+      has_birth = 1;
+      if (parse_counts(&s, &rule->birth) != 0) {
+        return -1;
+      }
+    } else if (tag == 'S' && !has_survive) {
+      has_survive = 1;
+      if (parse_counts(&s, &rule->survive) != 0) {
+        return -1;
+      }
+    } else {
+      return -1;
+    }
+    if (part == 0 && *s++ != '/') {
+      return -1;
+    }
+  }
+  return *s == '\0' ? 0 : -1;
+}
+
+void format_rule(const Rule_t *rule, char *buf) {
+  *buf++ = 'B';
+  for (int n = 0; n <= 8; n++) {
+    if (rule->birth & (1 << n)) {
+      *buf++ = (char)('0' + n);
+    }
+  }
+  *buf++ = '/';
+  *buf++ = 'S';
+  for (int n = 0; n <= 8; n++) {
+    if (rule->survive & (1 << n)) {
+      *buf++ = (char)('0' + n);
+    }
+  }
+  *buf = '\0';
+}
+
+void rule_table(const Rule_t *rule, unsigned char *lut) {
+  for (int cnt = 0; cnt <= 8; cnt++) {
+    lut[cnt] = (unsigned char)((rule->birth >> cnt) & 1);
+    lut[9 + cnt] = (unsigned char)((rule->survive >> cnt) & 1);
+  }
+}
@@ -0,0 +1,90 @@
+#ifndef RULE_H
+#define RULE_H
+
+#define RULE_MAX_LENGTH 24 // "B012345678/S012345678" and terminating NUL
+
+/**
+ * @brief Life-like cellular automaton rule in B/S notation (e.g. B3/S23 for
+ * Conway's Game of Life)
+ */
+struct Rule {
+  unsigned short birth;   // bit n set: dead cell with n alive neighbours
+                          // comes to life
+  unsigned short survive; // bit n set: alive cell with n alive neighbours
+                          // stays alive
+};
+typedef struct Rule Rule_t;
+
+#define CONWAY_BIRTH (1 << 3)
+#define CONWAY_SURVIVE ((1 << 2) | (1 << 3))
+
+/**
+ * @brief Rules whose kernels are specialized at compile time, as
+ * X(name, birth, survive) entries: engines instantiate one kernel per entry
+ * with constant masks and use a generic kernel for other rules
+ */
+#define SPECIALIZED_RULES(X)                                                   \
+  X(conway, CONWAY_BIRTH, CONWAY_SURVIVE)                 /* B3/S23 */         \
+  X(highlife, (1 << 3) | (1 << 6), CONWAY_SURVIVE)        /* B36/S23 */        \
+  X(day_and_night, (1 << 3) | (1 << 6) | (1 << 7) | (1 << 8),                  \
+    (1 << 3) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8)) /* B3678/S34678 */   \
+  X(seeds, 1 << 2, 0)                                     /* B2/S */
+
+/**
+ * @brief Next state of a cell with cnt alive neighbours. Written as
+ * comparisons so that constant masks reduce to a few compares which
+ * vectorize, instead of a table lookup.
+ *
+ * @param cnt number of alive neighbours (0 to 8)
+ * @param alive current state of cell (0 or 1)
+ * @param birth rule birth mask
+ * @param survive rule survive mask
+ * @return unsigned char next state of cell (0 or 1)
+ */
+static inline unsigned char rule_cell(unsigned char cnt, unsigned char alive,
+                                      unsigned birth, unsigned survive) {
+  if (birth == CONWAY_BIRTH && survive == CONWAY_SURVIVE) {
+    return (unsigned char)((cnt == 3) | ((cnt == 2) & alive));
+  }
+  unsigned char b = 0, s = 0;
+  // fully unrolled so that constant masks fold
+#pragma GCC unroll 9
+  for (int k = 0; k <= 8; k++) {
+    if ((birth >> k) & 1) {
+      b |= cnt == k;
+    }
+    if ((survive >> k) & 1) {
+      s |= cnt == k;
+    }
+  }
+  return (unsigned char)((b & (alive ^ 1)) | (s & alive));
+}
+
+/**
+ * @brief Parse rule string, either in B/S notation ("B36/S23", case
+ * insensitive, in any order) or in S/B notation ("23/36")
+ *
+ * @param str rule string
+ * @param rule parsed rule
+ * @return int 0 if str is a valid rule, -1 otherwise
+ */
+int parse_rule(const char *str, Rule_t *rule);
+
+/**
+ * @brief Format rule in B/S notation
+ *
+ * @param rule rule to format
+ * @param buf buffer of at least RULE_MAX_LENGTH characters
+ */
+void format_rule(const Rule_t *rule, char *buf);
+
+/**
+ * @brief Fill lookup table of rule: entry 9 * state + count is the next state
+ * of a cell in state with count alive neighbours
+ *
+ * @param rule rule
+ * @param lut table of 18 entries
+ */
+void rule_table(const Rule_t *rule, unsigned char *lut);
+
+#endif /* RULE_H */
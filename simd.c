@@ -0,0 +1,510 @@
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "packed.h"
+#include "padded.h"
+
+/**
+ * @brief Cells of a row packed into words (see pack_cells) from the compare
+ * masks of vector kernels and the tail cells, each full word being folded
+ * into a hash (see hash_cells) and/or stored
+ */
+struct RowBits {
+  uint64_t *hash;  // hash receiving full words (NULL if row is not hashed)
+  uint64_t *words; // next word of the packed row (NULL if not stored)
+  uint64_t word;   // word being filled
+  int n;           // number of bits of word
+};
+typedef struct RowBits RowBits_t;
+
+/**
+ * @brief Row kernel: compute next state of row r (w cells) into out, a and b
+ * being the rows above and below (padded rows, see PaddedGrid_t). With bits
+ * set, the next state is also packed into bits. With counts set, the
+ * population, births and deaths of the row are added to counts[0..2].
+ */
+typedef void (*RowKernel)(const byte *a, const byte *r, const byte *b,
+                          byte *out, int w, const Rule_t *rule,
+                          RowBits_t *bits, long *counts);
+
+/**
+ * @brief Vectorized engine state: padded byte grids like the reference
+ * engine, rows are computed by summing the 8 shifted neighbour rows with SIMD
+ * instructions
+ */
+struct SimdEngine {
+  PaddedGrid_t *cur;      // current generation
+  PaddedGrid_t *next;     // preallocated grid receiving next generation
+  int torus;              // whether grid wraps around
+  Rule_t rule;            // rule computing next generation
+  RowKernel kernel;       // row kernel for selected instruction set
+  GameOfLifeData_t *view; // byte grid returned by data()
+  int view_valid;         // whether view is up to date with cur
+  int count;              // whether step_rows collects counters
+  GenerationStats_t stats; // counters since last stats() call
+  int hashing;            // whether step_rows hashes rows
+  uint64_t hash;          // hash of current generation (sum of rows hashes)
+  uint64_t next_hash;     // hash of rows of next generation computed so far
+  int nw;                 // number of words per row of bits
+  uint64_t *bits;         // rows receiving next generation bit-packed by
+                          // step_rows (NULL if not recorded)
+};
+typedef struct SimdEngine SimdEngine_t;
+
+/**
+ * @brief Neighbour counts listed by a rule mask
+ *
+ * @param mask rule birth or survive mask
+ * @param counts receives counts (up to 9)
+ * @return int number of counts
+ */
+static int rule_counts(unsigned mask, char *counts) {
+  int n = 0;
+  for (int k = 0; k <= 8; k++) {
+    if ((mask >> k) & 1) {
+      counts[n++] = (char)k;
+    }
+  }
+  return n;
+}
+
+/**
+ * @brief Fold and/or store the word being filled, and start a new one
+ */
+static inline __attribute__((always_inline)) void
+flush_bits(RowBits_t *bits) {
+  if (bits->hash != NULL) {
+    *bits->hash = hash_fold(*bits->hash, bits->word);
+  }
+  if (bits->words != NULL) {
+    *bits->words++ = bits->word;
+  }
+  bits->word = 0;
+  bits->n = 0;
+}
+
+/**
+ * @brief Append n bits (n dividing 64, or 1 for tail cells) to row bits
+ */
+static inline __attribute__((always_inline)) void
+push_bits(RowBits_t *bits, uint64_t x, int n) {
+  bits->word |= x << bits->n;
+  bits->n += n;
+  if (bits->n == 64) {
+    flush_bits(bits);
+  }
+}
+
+/**
+ * @brief Compute tail cells [j, w) of a row, append them to row bits and add
+ * them to counts (each if not NULL)
+ */
+static inline __attribute__((always_inline)) void
+row_tail(const byte *a, const byte *r, const byte *b, byte *out, int j, int w,
+         const Rule_t *rule, RowBits_t *bits, long *counts) {
+  for (; j < w; j++) {
+    out[j] = rule_cell(padded_count(a, r, b, j), r[j], rule->birth,
+                       rule->survive);
+    if (bits != NULL) {
+      push_bits(bits, out[j], 1);
+    }
+    if (counts != NULL) {
+      counts[0] += out[j];
+      counts[1] += out[j] & (r[j] ^ 1);
+      counts[2] += r[j] & (out[j] ^ 1);
+    }
+  }
+  if (bits != NULL && bits->n > 0) {
+    // last word is zero padded
+    flush_bits(bits);
+  }
+}
+
+static void row_scalar(const byte *a, const byte *r, const byte *b, byte *out,
+                       int w, const Rule_t *rule, RowBits_t *bits,
+                       long *counts) {
+  row_tail(a, r, b, out, 0, w, rule, bits, counts);
+}
+
+#ifdef __x86_64__
+/*
+ * Vector kernels below process V cells starting at column j with unaligned
+ * loads at j - 1, j and j + 1, which the halo keeps inside the padded row.
+ * Neighbour counts are compared with the counts of the rule birth and survive
+ * masks (3 compares for Conway's rule). Remaining tail that does not fill a
+ * whole vector is computed by rule_cell(). Counts are summed in byte lanes
+ * (population, births and deaths masks subtracted from 3 accumulators), which
+ * are added to counts before they could overflow.
+ */
+
+#define MAX_LANE_SUM 255 // vectors summed in byte lanes before adding them
+
+/**
+ * @brief Add the byte lanes of 3 SSE2 accumulators to counts and clear them
+ */
+__attribute__((target("sse2"))) static inline void
+flush_sse2(__m128i acc[3], long *counts) {
+  for (int k = 0; k < 3; k++) {
+    __m128i sum = _mm_sad_epu8(acc[k], _mm_setzero_si128());
+    counts[k] += _mm_cvtsi128_si64(sum) +
+                 _mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum));
+    acc[k] = _mm_setzero_si128();
+  }
+}
+
+/**
+ * @brief Add the byte lanes of 3 AVX2 accumulators to counts and clear them
+ */
+__attribute__((target("avx2"))) static inline void
+flush_avx2(__m256i acc[3], long *counts) {
+  for (int k = 0; k < 3; k++) {
+    __m256i sum = _mm256_sad_epu8(acc[k], _mm256_setzero_si256());
+    counts[k] += _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1) +
+                 _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+    acc[k] = _mm256_setzero_si256();
+  }
+}
+
+/**
+ * @brief Add the byte lanes of 3 AVX-512 accumulators to counts and clear
+ * them
+ */
+__attribute__((target("avx512f,avx512bw"))) static inline void
+flush_avx512(__m512i acc[3], long *counts) {
+  for (int k = 0; k < 3; k++) {
+    counts[k] += _mm512_reduce_add_epi64(
+        _mm512_sad_epu8(acc[k], _mm512_setzero_si512()));
+    acc[k] = _mm512_setzero_si512();
+  }
+}
+
+__attribute__((target("sse2"))) static void
+row_sse2(const byte *a, const byte *r, const byte *b, byte *out, int w,
+         const Rule_t *rule, RowBits_t *bits, long *counts) {
+  const __m128i one = _mm_set1_epi8(1);
+  __m128i acc[3] = {_mm_setzero_si128(), _mm_setzero_si128(),
+                    _mm_setzero_si128()};
+  int summed = 0;
+  char bc[9], sc[9];
+  int nb = rule_counts(rule->birth, bc), ns = rule_counts(rule->survive, sc);
+  __m128i born[9], keep[9];
+  for (int k = 0; k < nb; k++) {
+    born[k] = _mm_set1_epi8(bc[k]);
+  }
+  for (int k = 0; k < ns; k++) {
+    keep[k] = _mm_set1_epi8(sc[k]);
+  }
+  int j = 0;
+  for (; j + 16 <= w; j += 16) {
+#define LD(p, o) _mm_loadu_si128((const __m128i *)((p) + j + (o)))
+    __m128i cnt = _mm_add_epi8(
+        _mm_add_epi8(_mm_add_epi8(LD(a, -1), LD(a, 0)),
+                     _mm_add_epi8(LD(a, 1), LD(r, -1))),
+        _mm_add_epi8(_mm_add_epi8(LD(r, 1), LD(b, -1)),
+                     _mm_add_epi8(LD(b, 0), LD(b, 1))));
+    __m128i alive = _mm_cmpeq_epi8(LD(r, 0), one);
+#undef LD
+    __m128i bm = _mm_setzero_si128(), sm = _mm_setzero_si128();
+    for (int k = 0; k < nb; k++) {
+      bm = _mm_or_si128(bm, _mm_cmpeq_epi8(cnt, born[k]));
+    }
+    for (int k = 0; k < ns; k++) {
+      sm = _mm_or_si128(sm, _mm_cmpeq_epi8(cnt, keep[k]));
+    }
+    __m128i nxt = _mm_or_si128(_mm_andnot_si128(alive, bm),
+                               _mm_and_si128(alive, sm));
+    _mm_storeu_si128((__m128i *)(out + j), _mm_and_si128(nxt, one));
+    if (bits != NULL) {
+      push_bits(bits, (uint16_t)_mm_movemask_epi8(nxt), 16);
+    }
+    if (counts != NULL) {
+      acc[0] = _mm_sub_epi8(acc[0], nxt);
+      acc[1] = _mm_sub_epi8(acc[1], _mm_andnot_si128(alive, nxt));
+      acc[2] = _mm_sub_epi8(acc[2], _mm_andnot_si128(nxt, alive));
+      if (++summed == MAX_LANE_SUM) {
+        flush_sse2(acc, counts);
+        summed = 0;
+      }
+    }
+  }
+  if (counts != NULL) {
+    flush_sse2(acc, counts);
+  }
+  row_tail(a, r, b, out, j, w, rule, bits, counts);
+}
+
+__attribute__((target("avx2"))) static void
+row_avx2(const byte *a, const byte *r, const byte *b, byte *out, int w,
+         const Rule_t *rule, RowBits_t *bits, long *counts) {
+  const __m256i one = _mm256_set1_epi8(1);
+  __m256i acc[3] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                    _mm256_setzero_si256()};
+  int summed = 0;
+  char bc[9], sc[9];
+  int nb = rule_counts(rule->birth, bc), ns = rule_counts(rule->survive, sc);
+  __m256i born[9], keep[9];
+  for (int k = 0; k < nb; k++) {
+    born[k] = _mm256_set1_epi8(bc[k]);
+  }
+  for (int k = 0; k < ns; k++) {
+    keep[k] = _mm256_set1_epi8(sc[k]);
+  }
+  int j = 0;
+  for (; j + 32 <= w; j += 32) {
+#define LD(p, o) _mm256_loadu_si256((const __m256i *)((p) + j + (o)))
+    __m256i cnt = _mm256_add_epi8(
+        _mm256_add_epi8(_mm256_add_epi8(LD(a, -1), LD(a, 0)),
+                        _mm256_add_epi8(LD(a, 1), LD(r, -1))),
+        _mm256_add_epi8(_mm256_add_epi8(LD(r, 1), LD(b, -1)),
+                        _mm256_add_epi8(LD(b, 0), LD(b, 1))));
+    __m256i alive = _mm256_cmpeq_epi8(LD(r, 0), one);
+#undef LD
+    __m256i bm = _mm256_setzero_si256(), sm = _mm256_setzero_si256();
+    for (int k = 0; k < nb; k++) {
+      bm = _mm256_or_si256(bm, _mm256_cmpeq_epi8(cnt, born[k]));
+    }
+    for (int k = 0; k < ns; k++) {
+      sm = _mm256_or_si256(sm, _mm256_cmpeq_epi8(cnt, keep[k]));
+    }
+    __m256i nxt = _mm256_or_si256(_mm256_andnot_si256(alive, bm),
+                                  _mm256_and_si256(alive, sm));
+    _mm256_storeu_si256((__m256i *)(out + j), _mm256_and_si256(nxt, one));
+    if (bits != NULL) {
+      push_bits(bits, (uint32_t)_mm256_movemask_epi8(nxt), 32);
+    }
+    if (counts != NULL) {
+      acc[0] = _mm256_sub_epi8(acc[0], nxt);
+      acc[1] = _mm256_sub_epi8(acc[1], _mm256_andnot_si256(alive, nxt));
+      acc[2] = _mm256_sub_epi8(acc[2], _mm256_andnot_si256(nxt, alive));
+      if (++summed == MAX_LANE_SUM) {
+        flush_avx2(acc, counts);
+        summed = 0;
+      }
+    }
+  }
+  if (counts != NULL) {
+    flush_avx2(acc, counts);
+  }
+  row_tail(a, r, b, out, j, w, rule, bits, counts);
+}
+
+__attribute__((target("avx512f,avx512bw"))) static void
+row_avx512(const byte *a, const byte *r, const byte *b, byte *out, int w,
+           const Rule_t *rule, RowBits_t *bits, long *counts) {
+  const __m512i one = _mm512_set1_epi8(1);
+  __m512i acc[3] = {_mm512_setzero_si512(), _mm512_setzero_si512(),
+                    _mm512_setzero_si512()};
+  int summed = 0;
+  char bc[9], sc[9];
+  int nb = rule_counts(rule->birth, bc), ns = rule_counts(rule->survive, sc);
+  __m512i born[9], keep[9];
+  for (int k = 0; k < nb; k++) {
+    born[k] = _mm512_set1_epi8(bc[k]);
+  }
+  for (int k = 0; k < ns; k++) {
+    keep[k] = _mm512_set1_epi8(sc[k]);
+  }
+  int j = 0;
+  for (; j + 64 <= w; j += 64) {
+#define LD(p, o) _mm512_loadu_si512((const void *)((p) + j + (o)))
+    __m512i cnt = _mm512_add_epi8(
+        _mm512_add_epi8(_mm512_add_epi8(LD(a, -1), LD(a, 0)),
+                        _mm512_add_epi8(LD(a, 1), LD(r, -1))),
+        _mm512_add_epi8(_mm512_add_epi8(LD(r, 1), LD(b, -1)),
+                        _mm512_add_epi8(LD(b, 0), LD(b, 1))));
+    __mmask64 alive = _mm512_cmpeq_epi8_mask(LD(r, 0), one);
+#undef LD
+    __mmask64 bm = 0, sm = 0;
+    for (int k = 0; k < nb; k++) {
+      bm |= _mm512_cmpeq_epi8_mask(cnt, born[k]);
+    }
+    for (int k = 0; k < ns; k++) {
+      sm |= _mm512_cmpeq_epi8_mask(cnt, keep[k]);
+    }
+    __mmask64 nxt = (~alive & bm) | (alive & sm);
+    _mm512_storeu_si512((void *)(out + j), _mm512_maskz_mov_epi8(nxt, one));
+    if (bits != NULL) {
+      push_bits(bits, nxt, 64);
+    }
+    if (counts != NULL) {
+      acc[0] = _mm512_mask_add_epi8(acc[0], nxt, acc[0], one);
+      acc[1] = _mm512_mask_add_epi8(acc[1], nxt & ~alive, acc[1], one);
+      acc[2] = _mm512_mask_add_epi8(acc[2], alive & ~nxt, acc[2], one);
+      if (++summed == MAX_LANE_SUM) {
+        flush_avx512(acc, counts);
+        summed = 0;
+      }
+    }
+  }
+  if (counts != NULL) {
+    flush_avx512(acc, counts);
+  }
+  row_tail(a, r, b, out, j, w, rule, bits, counts);
+}
+#endif
+
+/**
+ * @brief Select row kernel for instruction set isa, "auto" picks the widest
+ * instruction set supported by the running CPU (vector kernels are only built
+ * for x86-64, other targets run the scalar kernel)
+ *
+ * @param isa instruction set name ("auto", "scalar", "sse2", "avx2" or
+ * "avx512")
+ * @return RowKernel kernel (NULL if isa is not supported by the running CPU)
+ */
+static RowKernel select_kernel(const char *isa) {
+  int auto_isa = isa == NULL || strcmp(isa, "auto") == 0;
+#ifdef __x86_64__
+  __builtin_cpu_init();
+  if ((auto_isa || strcmp(isa, "avx512") == 0) &&
+      __builtin_cpu_supports("avx512bw")) {
+    return row_avx512;
+  }
+  if ((auto_isa || strcmp(isa, "avx2") == 0) &&
+      __builtin_cpu_supports("avx2")) {
+    return row_avx2;
+  }
+  if ((auto_isa || strcmp(isa, "sse2") == 0) &&
+      __builtin_cpu_supports("sse2")) {
+    return row_sse2;
+  }
+#endif
+  if (auto_isa || strcmp(isa, "scalar") == 0) {
+    return row_scalar;
+  }
+  printf("Instruction set not supported by this CPU: %s\n", isa);
+  return NULL;
+}
+
+static void *simd_engine_create(GameOfLifeData_t *data,
+                                const EngineConfig_t *config) {
+  RowKernel kernel = select_kernel(config->isa);
+  if (kernel == NULL) {
+    return NULL;
+  }
+  SimdEngine_t *e = (SimdEngine_t *)malloc(sizeof(SimdEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->cur = padded_alloc(data->w, data->h);
+  e->next = padded_alloc(data->w, data->h);
+  if (e->cur == NULL || e->next == NULL) {
+    free_padded(e->cur);
+    free_padded(e->next);
+    free(e);
+    return NULL;
+  }
+  e->nw = (data->w + WORD_BITS - 1) / WORD_BITS;
+  e->bits = NULL;
+  e->torus = config->torus;
+  e->rule = config->rule;
+  e->kernel = kernel;
+  pad_grid(data, e->cur);
+  refresh_halo(e->cur, e->torus);
+  e->view = data;
+  e->view_valid = 1;
+  e->count = config->stats;
+  stats_clear(&e->stats);
+  e->hashing = config->hash;
+  e->hash = 0;
+  e->next_hash = 0;
+  for (int i = 0; e->hashing && i < data->h; i++) {
+    e->hash += hash_cells(padded_row(e->cur, i), data->w, i);
+  }
+  return e;
+}
+
+static void simd_engine_step_rows(void *state, int begin, int end) {
+  SimdEngine_t *e = (SimdEngine_t *)state;
+  GenerationStats_t band;
+  stats_clear(&band);
+  uint64_t hash = 0;
+  for (int i = begin; i < end; i++) {
+    uint64_t row = FNV_OFFSET;
+    long counts[3] = {0, 0, 0};
+    RowBits_t bits = {e->hashing ? &row : NULL,
+                      e->bits != NULL ? e->bits + (size_t)e->nw * i : NULL, 0,
+                      0};
+    e->kernel(padded_row(e->cur, i - 1), padded_row(e->cur, i),
+              padded_row(e->cur, i + 1), padded_row(e->next, i), e->cur->w,
+              &e->rule, e->hashing || e->bits != NULL ? &bits : NULL,
+              e->count ? counts : NULL);
+    if (e->count) {
+      stats_add_row(padded_row(e->next, i), e->cur->w, i, counts, &band);
+    }
+    if (e->hashing) {
+      hash += hash_part(row, i);
+    }
+  }
+  if (e->count) {
+    stats_merge(&e->stats, &band);
+  }
+  if (e->hashing) {
+    __atomic_fetch_add(&e->next_hash, hash, __ATOMIC_RELAXED);
+  }
+}
+
+static void simd_engine_swap(void *state) {
+  SimdEngine_t *e = (SimdEngine_t *)state;
+  PaddedGrid_t *tmp = e->cur;
+  e->cur = e->next;
+  e->next = tmp;
+  refresh_halo(e->cur, e->torus);
+  e->view_valid = 0;
+  e->hash = e->next_hash;
+  e->next_hash = 0;
+  e->bits = NULL;
+}
+
+static void simd_engine_stats(void *state, GenerationStats_t *stats) {
+  SimdEngine_t *e = (SimdEngine_t *)state;
+  *stats = e->stats;
+  stats_clear(&e->stats);
+}
+
+static uint64_t simd_engine_hash(void *state) {
+  SimdEngine_t *e = (SimdEngine_t *)state;
+  return e->hash;
+}
+
+static void simd_engine_pack_next(void *state, uint64_t *rows) {
+  SimdEngine_t *e = (SimdEngine_t *)state;
+  e->bits = rows;
+}
+
+static GameOfLifeData_t *simd_engine_data(void *state) {
+  SimdEngine_t *e = (SimdEngine_t *)state;
+  if (!e->view_valid) {
+    unpad_grid(e->cur, e->view);
+    e->view_valid = 1;
+  }
+  return e->view;
+}
+
+static void simd_engine_destroy(void *state) {
+  SimdEngine_t *e = (SimdEngine_t *)state;
+  free_padded(e->cur);
+  free_padded(e->next);
+  free_data(e->view);
+  free(e);
+}
+
+const EngineOps_t simd_engine_ops = {
+    .name = "simd",
+    .torus = 1,
+    .birth0 = 1,
+    .bounded = 1,
+    .create = simd_engine_create,
+    .step_rows = simd_engine_step_rows,
+    .swap = simd_engine_swap,
+    .stats = simd_engine_stats,
+    .hash = simd_engine_hash,
+    .pack_next = simd_engine_pack_next,
+    .data = simd_engine_data,
+    .destroy = simd_engine_destroy,
+};
@@ -0,0 +1,457 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "packed.h"
+
+#define CHUNK_SIZE 64 // chunks are CHUNK_SIZE x CHUNK_SIZE cells (one word)
+#define MIN_TABLE_SIZE 64
+
+enum { NORTH, SOUTH, WEST, EAST, NORTH_WEST, NORTH_EAST, SOUTH_WEST,
+       SOUTH_EAST, DIRECTIONS };
+
+static const int dx[DIRECTIONS] = {0, 0, -1, 1, -1, 1, -1, 1};
+static const int dy[DIRECTIONS] = {-1, 1, 0, 0, -1, -1, 1, 1};
+
+/**
+ * @brief Chunk of the plane: row r is cells[parity][r], column c of the row
+ * being bit c, chunk (cx, cy) covering cells (64 * cx + c, 64 * cy + r)
+ */
+typedef struct Chunk Chunk_t;
+struct Chunk {
+  int cx, cy;                     // chunk coordinates
+  word cells[2][CHUNK_SIZE];      // current and next generation
+  Chunk_t *neighbours[DIRECTIONS]; // NULL if absent (dead cells)
+  int needed;                     // kept by next chunks update
+  uint64_t hash;                  // hash of last computed generation (0 if
+                                  // dead or not hashed)
+};
+
+struct SparseEngine;
+/**
+ * @brief Chunk kernel: compute next generation of chunks [begin, end)
+ */
+typedef void (*SparseKernel)(struct SparseEngine *e, size_t begin, size_t end);
+
+/**
+ * @brief Sparse engine state. Like hashlife the universe is unbounded, the
+ * w x h board being only the window returned by data(). Only chunks holding
+ * alive cells and the ones their border activity reaches exist: they are
+ * allocated when activity reaches them and freed once empty, so that memory
+ * and step time follow the population rather than the bounding box.
+ */
+struct SparseEngine {
+  int h;                  // board height (bands of rows are split in chunks)
+  int parity;             // cells[parity] of chunks is current generation
+  Chunk_t **chunks;       // existing chunks
+  size_t count;           // number of chunks
+  size_t cap;             // capacity of chunks
+  Chunk_t **table;        // open addressing hash table of chunks
+  size_t table_size;      // number of slots of table (power of 2)
+  Rule_t rule;            // rule (used by generic kernel, without B0 dead
+                          // chunks stay dead)
+  SparseKernel kernel;    // chunk kernel for rule
+  GameOfLifeData_t *view; // board window returned by data()
+  int view_valid;         // whether view is up to date with chunks
+  int hashing;            // whether chunks are hashed while stepping
+  int failed;             // whether chunks could not be allocated (grid is
+                          // lost)
+};
+typedef struct SparseEngine SparseEngine_t;
+
+static size_t chunk_hash(int cx, int cy) {
+  uint64_t key = (uint64_t)(uint32_t)cx << 32 | (uint32_t)cy;
+  return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+/**
+ * @brief Hash of rows of chunk (cx, cy), 0 if dead so that chunks allocated
+ * around live ones do not change the hash of the plane
+ */
+static uint64_t hash_chunk(const word *rows, int cx, int cy) {
+  word any = 0;
+  for (int r = 0; r < CHUNK_SIZE; r++) {
+    any |= rows[r];
+  }
+  if (any == 0) {
+    return 0;
+  }
+  return hash_words(rows, CHUNK_SIZE,
+                    (uint64_t)(uint32_t)cx << 32 | (uint32_t)cy);
+}
+
+/**
+ * @brief Find slot of chunk (cx, cy) in table (empty slot if absent)
+ */
+static size_t chunk_slot(SparseEngine_t *e, int cx, int cy) {
+  size_t mask = e->table_size - 1;
+  size_t slot = chunk_hash(cx, cy) & mask;
+  while (e->table[slot] != NULL &&
+         (e->table[slot]->cx != cx || e->table[slot]->cy != cy)) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+static Chunk_t *find_chunk(SparseEngine_t *e, int cx, int cy) {
+  return e->table[chunk_slot(e, cx, cy)];
+}
+
+/**
+ * @brief Rebuild table from chunks list, with at least 4 slots per chunk
+ *
+ * @return int 0 on success, -1 if table could not be allocated
+ */
+static int rebuild_table(SparseEngine_t *e) {
+  size_t size = MIN_TABLE_SIZE;
+  while (size < 4 * e->count) {
+    size *= 2;
+  }
+  if (size != e->table_size) {
+    Chunk_t **table = (Chunk_t **)malloc(size * sizeof(Chunk_t *));
+    if (table == NULL) {
+      return -1;
+    }
+    free(e->table);
+    e->table = table;
+    e->table_size = size;
+  }
+  memset(e->table, 0, e->table_size * sizeof(Chunk_t *));
+  for (size_t k = 0; k < e->count; k++) {
+    e->table[chunk_slot(e, e->chunks[k]->cx, e->chunks[k]->cy)] = e->chunks[k];
+  }
+  return 0;
+}
+
+/**
+ * @brief Allocate dead chunk (cx, cy) and add it to chunks and table
+ *
+ * @return Chunk_t* added chunk (NULL if it could not be allocated)
+ */
+static Chunk_t *add_chunk(SparseEngine_t *e, int cx, int cy) {
+  if (e->count == e->cap) {
+    Chunk_t **chunks =
+        (Chunk_t **)realloc(e->chunks, 2 * e->cap * sizeof(Chunk_t *));
+    if (chunks == NULL) {
+      return NULL;
+    }
+    e->chunks = chunks;
+    e->cap *= 2;
+  }
+  Chunk_t *c = (Chunk_t *)calloc(1, sizeof(Chunk_t));
+  if (c == NULL) {
+    return NULL;
+  }
+  c->cx = cx;
+  c->cy = cy;
+  e->chunks[e->count++] = c;
+  if (4 * e->count > e->table_size) {
+    if (rebuild_table(e) != 0) {
+      return NULL;
+    }
+  } else {
+    e->table[chunk_slot(e, cx, cy)] = c;
+  }
+  return c;
+}
+
+/**
+ * @brief Directions of neighbour chunks reached by alive cells of a chunk
+ * (bit d set for direction d), border cells reaching the next chunk
+ */
+static unsigned reached_directions(const word *rows) {
+  word any = 0;
+  for (int r = 0; r < CHUNK_SIZE; r++) {
+    any |= rows[r];
+  }
+  if (any == 0) {
+    return 0;
+  }
+  word top = rows[0], bottom = rows[CHUNK_SIZE - 1];
+  word west = 1, east = (word)1 << (WORD_BITS - 1);
+  return (unsigned)(top != 0) << NORTH | (unsigned)(bottom != 0) << SOUTH |
+         (unsigned)((any & west) != 0) << WEST |
+         (unsigned)((any & east) != 0) << EAST |
+         (unsigned)((top & west) != 0) << NORTH_WEST |
+         (unsigned)((top & east) != 0) << NORTH_EAST |
+         (unsigned)((bottom & west) != 0) << SOUTH_WEST |
+         (unsigned)((bottom & east) != 0) << SOUTH_EAST | 1u << DIRECTIONS;
+}
+
+/**
+ * @brief Update chunks after current generation changed: chunks reached by
+ * alive cells are allocated, dead chunks no alive cell reaches are freed and
+ * neighbour links are refreshed
+ *
+ * @return int 0 on success, -1 if chunks could not be allocated (links are
+ * then left stale)
+ */
+static int update_chunks(SparseEngine_t *e) {
+  size_t n = e->count;
+  for (size_t k = 0; k < n; k++) {
+    e->chunks[k]->needed = 0;
+  }
+  for (size_t k = 0; k < n; k++) {
+    Chunk_t *c = e->chunks[k];
+    unsigned reached = reached_directions(c->cells[e->parity]);
+    if (reached == 0) {
+      continue;
+    }
+    c->needed = 1;
+    for (int d = 0; d < DIRECTIONS; d++) {
+      if ((reached >> d) & 1) {
+        Chunk_t *nb = find_chunk(e, c->cx + dx[d], c->cy + dy[d]);
+        if (nb == NULL) {
+          nb = add_chunk(e, c->cx + dx[d], c->cy + dy[d]);
+          if (nb == NULL) {
+            return -1;
+          }
+        }
+        nb->needed = 1;
+      }
+    }
+  }
+  size_t kept = 0;
+  for (size_t k = 0; k < e->count; k++) {
+    if (e->chunks[k]->needed) {
+      e->chunks[kept++] = e->chunks[k];
+    } else {
+      free(e->chunks[k]);
+    }
+  }
+  e->count = kept;
+  if (rebuild_table(e) != 0) {
+    return -1;
+  }
+  for (size_t k = 0; k < e->count; k++) {
+    Chunk_t *c = e->chunks[k];
+    for (int d = 0; d < DIRECTIONS; d++) {
+      c->neighbours[d] = find_chunk(e, c->cx + dx[d], c->cy + dy[d]);
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Free chunks, chunks list and table of engine, and engine itself
+ * (not the view, owned by caller until create succeeds)
+ */
+static void free_chunks(SparseEngine_t *e) {
+  for (size_t k = 0; k < e->count; k++) {
+    free(e->chunks[k]);
+  }
+  free(e->chunks);
+  free(e->table);
+  free(e);
+}
+
+/**
+ * @brief Compute next generation of a chunk from its rows and the rows of its
+ * neighbours (missing neighbours being dead)
+ *
+ * @param c chunk
+ * @param cur index of current generation in cells
+ * @param hashing whether to hash the computed generation into c->hash
+ * @param birth rule birth mask
+ * @param survive rule survive mask
+ */
+static inline __attribute__((always_inline)) void
+step_chunk(Chunk_t *c, int cur, int hashing, unsigned birth,
+           unsigned survive) {
+  // columns of words west, at and east of the chunk, with one row above and
+  // one below taken from north and south neighbours
+  Chunk_t *const *nb = c->neighbours;
+  Chunk_t *above[3] = {nb[NORTH_WEST], nb[NORTH], nb[NORTH_EAST]};
+  Chunk_t *middle[3] = {nb[WEST], c, nb[EAST]};
+  Chunk_t *below[3] = {nb[SOUTH_WEST], nb[SOUTH], nb[SOUTH_EAST]};
+  word col[3][CHUNK_SIZE + 2];
+  for (int k = 0; k < 3; k++) {
+    col[k][0] = above[k] != NULL ? above[k]->cells[cur][CHUNK_SIZE - 1] : 0;
+    if (middle[k] != NULL) {
+      memcpy(&col[k][1], middle[k]->cells[cur], sizeof(c->cells[cur]));
+    } else {
+      memset(&col[k][1], 0, sizeof(c->cells[cur]));
+    }
+    col[k][CHUNK_SIZE + 1] = below[k] != NULL ? below[k]->cells[cur][0] : 0;
+  }
+  word *out = c->cells[cur ^ 1];
+  for (int r = 1; r <= CHUNK_SIZE; r++) {
+    word a = col[1][r - 1], m = col[1][r], b = col[1][r + 1];
+    out[r - 1] =
+        life_word(west_of(a, col[0][r - 1]), a, east_of(a, col[2][r - 1]),
+                  west_of(m, col[0][r]), m, east_of(m, col[2][r]),
+                  west_of(b, col[0][r + 1]), b, east_of(b, col[2][r + 1]),
+                  birth, survive);
+  }
+  if (hashing) {
+    c->hash = hash_chunk(out, c->cx, c->cy);
+  }
+}
+
+/*
+ * Chunk kernels of SPECIALIZED_RULES are compiled with constant rule masks,
+ * the generic kernel reads them from engine.
+ */
+#define SPARSE_KERNEL(name, birth, survive)                                    \
+  static void sparse_chunks_##name(SparseEngine_t *e, size_t begin,            \
+                                   size_t end) {                               \
+    for (size_t k = begin; k < end; k++) {                                     \
+      step_chunk(e->chunks[k], e->parity, e->hashing, birth, survive);         \
+    }                                                                          \
+  }
+SPECIALIZED_RULES(SPARSE_KERNEL)
+SPARSE_KERNEL(generic, e->rule.birth, e->rule.survive)
+
+#define SPARSE_KERNEL_ENTRY(name, birth, survive)                              \
+  {{birth, survive}, sparse_chunks_##name},
+static const struct {
+  Rule_t rule;
+  SparseKernel kernel;
+} sparse_kernels[] = {SPECIALIZED_RULES(SPARSE_KERNEL_ENTRY)};
+
+static void *sparse_engine_create(GameOfLifeData_t *data,
+                                  const EngineConfig_t *config) {
+  SparseEngine_t *e = (SparseEngine_t *)calloc(1, sizeof(SparseEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->h = data->h;
+  e->cap = MIN_TABLE_SIZE;
+  e->chunks = (Chunk_t **)malloc(e->cap * sizeof(Chunk_t *));
+  if (e->chunks == NULL || rebuild_table(e) != 0) {
+    free_chunks(e);
+    return NULL;
+  }
+  for (int i = 0; i < data->h; i++) {
+    for (int j = 0; j < data->w; j++) {
+      if (get_cell_state(i, j, data) != ALIVE) {
+        continue;
+      }
+      int cx = j / CHUNK_SIZE, cy = i / CHUNK_SIZE;
+      Chunk_t *c = find_chunk(e, cx, cy);
+      if (c == NULL) {
+        c = add_chunk(e, cx, cy);
+        if (c == NULL) {
+          free_chunks(e);
+          return NULL;
+        }
+      }
+      c->cells[0][i % CHUNK_SIZE] |= (word)1 << (j % CHUNK_SIZE);
+    }
+  }
+  if (update_chunks(e) != 0) {
+    free_chunks(e);
+    return NULL;
+  }
+  e->hashing = config->hash;
+  for (size_t k = 0; e->hashing && k < e->count; k++) {
+    Chunk_t *c = e->chunks[k];
+    c->hash = hash_chunk(c->cells[0], c->cx, c->cy);
+  }
+  e->rule = config->rule;
+  e->kernel = sparse_chunks_generic;
+  for (size_t k = 0; k < sizeof(sparse_kernels) / sizeof(sparse_kernels[0]);
+       k++) {
+    if (sparse_kernels[k].rule.birth == e->rule.birth &&
+        sparse_kernels[k].rule.survive == e->rule.survive) {
+      e->kernel = sparse_kernels[k].kernel;
+    }
+  }
+  e->view = data;
+  e->view_valid = 1;
+  return e;
+}
+
+static void sparse_engine_step_rows(void *state, int begin, int end) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  // an empty board starts without alive cells, so without chunks
+  if (e->h == 0) {
+    return;
+  }
+  // bands of rows are mapped to bands of chunks
+  e->kernel(e, e->count * begin / e->h, e->count * end / e->h);
+}
+
+static void sparse_engine_swap(void *state) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  e->parity ^= 1;
+  if (!e->failed && update_chunks(e) != 0) {
+    printf("Failed to allocate chunks of sparse engine\n");
+    e->failed = 1;
+  }
+  e->view_valid = 0;
+}
+
+static uint64_t sparse_engine_hash(void *state) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  // chunks are hashed by step_rows, chunks added since are dead
+  uint64_t hash = 0;
+  for (size_t k = 0; k < e->count; k++) {
+    hash += e->chunks[k]->hash;
+  }
+  return hash;
+}
+
+static int sparse_engine_extinct(void *state) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  // dead chunks no alive cell reaches are freed
+  return e->count == 0;
+}
+
+static int sparse_engine_failed(void *state) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  return e->failed;
+}
+
+static GameOfLifeData_t *sparse_engine_data(void *state) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  GameOfLifeData_t *view = e->view;
+  if (!e->view_valid) {
+    memset(view->grid, DEAD, (size_t)view->w * view->h);
+    for (size_t k = 0; k < e->count; k++) {
+      Chunk_t *c = e->chunks[k];
+      for (int r = 0; r < CHUNK_SIZE; r++) {
+        long i = (long)c->cy * CHUNK_SIZE + r;
+        if (i < 0 || i >= view->h) {
+          continue;
+        }
+        for (word v = c->cells[e->parity][r]; v != 0; v &= v - 1) {
+          long j = (long)c->cx * CHUNK_SIZE + __builtin_ctzll(v);
+          if (j >= 0 && j < view->w) {
+            set_cell_state(i, j, view, ALIVE);
+          }
+        }
+      }
+    }
+    e->view_valid = 1;
+  }
+  return view;
+}
+
+static long sparse_engine_active_tiles(void *state, long *total) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  // every allocated chunk is computed
+  *total = (long)e->count;
+  return (long)e->count;
+}
+
+static void sparse_engine_destroy(void *state) {
+  SparseEngine_t *e = (SparseEngine_t *)state;
+  free_data(e->view);
+  free_chunks(e);
+}
+
+const EngineOps_t sparse_engine_ops = {
+    .name = "sparse",
+    .create = sparse_engine_create,
+    .step_rows = sparse_engine_step_rows,
+    .swap = sparse_engine_swap,
+    .active_tiles = sparse_engine_active_tiles,
+    .hash = sparse_engine_hash,
+    .extinct = sparse_engine_extinct,
+    .failed = sparse_engine_failed,
+    .data = sparse_engine_data,
+    .destroy = sparse_engine_destroy,
+};
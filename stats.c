@@ -0,0 +1,356 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "stats.h"
+
+void stats_clear(GenerationStats_t *stats) {
+  stats->population = 0;
+  stats->births = 0;
+  stats->deaths = 0;
+  stats->min_row = INT_MAX;
+  stats->max_row = -1;
+  stats->min_col = INT_MAX;
+  stats->max_col = -1;
+}
+
+/**
+ * @brief Extend bounding box of stats to columns first..last of row
+ */
+static void stats_extend(GenerationStats_t *stats, int row, int first,
+                         int last) {
+  if (row < stats->min_row) {
+    stats->min_row = row;
+  }
+  if (row > stats->max_row) {
+    stats->max_row = row;
+  }
+  if (first < stats->min_col) {
+    stats->min_col = first;
+  }
+  if (last > stats->max_col) {
+    stats->max_col = last;
+  }
+}
+
+void stats_count_bytes(const byte *prev, const byte *next, int w, int row,
+                       GenerationStats_t *stats) {
+  long population = 0, births = 0, deaths = 0;
+  int j = 0;
+#ifdef __SSE2__
+  // cells are 0 or 1, so that sums of absolute differences with zero count
+  // 16 cells at once
+  const __m128i zero = _mm_setzero_si128();
+  __m128i pop = zero, born = zero, died = zero;
+  for (; j + 16 <= w; j += 16) {
+    __m128i p = _mm_loadu_si128((const __m128i *)(prev + j));
+    __m128i n = _mm_loadu_si128((const __m128i *)(next + j));
+    pop = _mm_add_epi64(pop, _mm_sad_epu8(n, zero));
+    born = _mm_add_epi64(born, _mm_sad_epu8(_mm_andnot_si128(p, n), zero));
+    died = _mm_add_epi64(died, _mm_sad_epu8(_mm_andnot_si128(n, p), zero));
+  }
+  uint64_t sums[6];
+  _mm_storeu_si128((__m128i *)sums, pop);
+  _mm_storeu_si128((__m128i *)(sums + 2), born);
+  _mm_storeu_si128((__m128i *)(sums + 4), died);
+  population = (long)(sums[0] + sums[1]);
+  births = (long)(sums[2] + sums[3]);
+  deaths = (long)(sums[4] + sums[5]);
+#endif
+  for (; j < w; j++) {
+    population += next[j];
+    births += next[j] & (prev[j] ^ 1);
+    deaths += prev[j] & (next[j] ^ 1);
+  }
+  long counts[3] = {population, births, deaths};
+  stats_add_row(next, w, row, counts, stats);
+}
+
+void stats_add_row(const byte *next, int w, int row, const long counts[3],
+                   GenerationStats_t *stats) {
+  stats->population += counts[0];
+  stats->births += counts[1];
+  stats->deaths += counts[2];
+  if (counts[0] > 0) {
+    // only live cells outside the bounding box columns can extend it
+    int first = stats->min_col < w ? stats->min_col : w;
+    const byte *cell = (const byte *)memchr(next, ALIVE, first);
+    first = cell != NULL ? (int)(cell - next) : first;
+    int last = w - 1;
+    while (last > stats->max_col && next[last] == DEAD) {
+      last--;
+    }
+    stats_extend(stats, row, first < w ? first : stats->min_col,
+                 last > stats->max_col ? last : stats->max_col);
+  }
+}
+
+static inline __attribute__((always_inline)) void
+count_words(const uint64_t *prev, const uint64_t *next, int nw, int row,
+            int col, GenerationStats_t *stats) {
+  long population = 0, births = 0, deaths = 0;
+  for (int k = 0; k < nw; k++) {
+    population += __builtin_popcountll(next[k]);
+    births += __builtin_popcountll(next[k] & ~prev[k]);
+    deaths += __builtin_popcountll(prev[k] & ~next[k]);
+  }
+  stats->population += population;
+  stats->births += births;
+  stats->deaths += deaths;
+  if (population > 0) {
+    int first = 0, last = nw - 1;
+    while (next[first] == 0) {
+      first++;
+    }
+    while (next[last] == 0) {
+      last--;
+    }
+    stats_extend(stats, row, col + 64 * first + __builtin_ctzll(next[first]),
+                 col + 64 * last + 63 - __builtin_clzll(next[last]));
+  }
+}
+
+static inline __attribute__((always_inline)) void
+count_tile(const uint64_t *prev, const uint64_t *next, size_t stride, int rows,
+           int row, int col, GenerationStats_t *stats) {
+  long population = 0, births = 0, deaths = 0;
+  uint64_t live = 0;
+  int first = -1, last = -1;
+  for (int r = 0; r < rows; r++) {
+    uint64_t p = prev[stride * r], n = next[stride * r];
+    population += __builtin_popcountll(n);
+    births += __builtin_popcountll(n & ~p);
+    deaths += __builtin_popcountll(p & ~n);
+    if (n != 0) {
+      first = first < 0 ? r : first;
+      last = r;
+    }
+    live |= n;
+  }
+  stats->population += population;
+  stats->births += births;
+  stats->deaths += deaths;
+  if (population > 0) {
+    stats_extend(stats, row + first, col + __builtin_ctzll(live),
+                 col + 63 - __builtin_clzll(live));
+    stats_extend(stats, row + last, col + __builtin_ctzll(live),
+                 col + 63 - __builtin_clzll(live));
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// popcount instruction (the default build calls a bit twiddling routine)
+__attribute__((target("popcnt"))) static void
+count_words_popcnt(const uint64_t *prev, const uint64_t *next, int nw,
+                   int row, int col, GenerationStats_t *stats) {
+  count_words(prev, next, nw, row, col, stats);
+}
+
+__attribute__((target("popcnt"))) static void
+count_tile_popcnt(const uint64_t *prev, const uint64_t *next, size_t stride,
+                  int rows, int row, int col, GenerationStats_t *stats) {
+  count_tile(prev, next, stride, rows, row, col, stats);
+}
+#endif
+
+void stats_count_words(const uint64_t *prev, const uint64_t *next, int nw,
+                       int row, GenerationStats_t *stats) {
+  stats_count_segment(prev, next, nw, row, 0, stats);
+}
+
+void stats_count_segment(const uint64_t *prev, const uint64_t *next, int nw,
+                         int row, int col, GenerationStats_t *stats) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("popcnt")) {
+    count_words_popcnt(prev, next, nw, row, col, stats);
+    return;
+  }
+#endif
+  count_words(prev, next, nw, row, col, stats);
+}
+
+void stats_count_tile(const uint64_t *prev, const uint64_t *next,
+                      size_t stride, int rows, int row, int col,
+                      GenerationStats_t *stats) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("popcnt")) {
+    count_tile_popcnt(prev, next, stride, rows, row, col, stats);
+    return;
+  }
+#endif
+  count_tile(prev, next, stride, rows, row, col, stats);
+}
+
+void stats_add(GenerationStats_t *into, const GenerationStats_t *part) {
+  into->population += part->population;
+  into->births += part->births;
+  into->deaths += part->deaths;
+  if (part->min_row <= part->max_row) {
+    stats_extend(into, part->min_row, part->min_col, part->max_col);
+    stats_extend(into, part->max_row, part->min_col, part->max_col);
+  }
+}
+
+static void atomic_min(int *p, int v) {
+  int cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+  while (v < cur && !__atomic_compare_exchange_n(p, &cur, v, 1,
+                                                 __ATOMIC_RELAXED,
+                                                 __ATOMIC_RELAXED))
+    ;
+}
+
+static void atomic_max(int *p, int v) {
+  int cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+  while (v > cur && !__atomic_compare_exchange_n(p, &cur, v, 1,
+                                                 __ATOMIC_RELAXED,
+                                                 __ATOMIC_RELAXED))
+    ;
+}
+
+void stats_merge(GenerationStats_t *into, const GenerationStats_t *band) {
+  __atomic_fetch_add(&into->population, band->population, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&into->births, band->births, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&into->deaths, band->deaths, __ATOMIC_RELAXED);
+  if (band->min_row <= band->max_row) {
+    atomic_min(&into->min_row, band->min_row);
+    atomic_max(&into->max_row, band->max_row);
+    atomic_min(&into->min_col, band->min_col);
+    atomic_max(&into->max_col, band->max_col);
+  }
+}
+
+StatsLog_t *stats_log_init(const char *path, GameOfLifeData_t *data,
+                           int scan) {
+  StatsLog_t *log = (StatsLog_t *)calloc(1, sizeof(StatsLog_t));
+  if (log == NULL) {
+    printf("Failed to allocate stats buffers\n");
+    return NULL;
+  }
+  log->path = path;
+  if (scan) {
+    size_t size = (size_t)data->w * data->h;
+    log->prev = (byte *)malloc(size);
+    if (log->prev == NULL) {
+      printf("Failed to allocate %dx%d stats buffers\n", data->w, data->h);
+      free(log);
+      return NULL;
+    }
+    memcpy(log->prev, data->grid, size);
+  }
+  log->file = fopen(path, "w");
+  if (log->file == NULL) {
+    printf("Failed to open file: %s\n", path);
+    free(log->prev);
+    free(log);
+    return NULL;
+  }
+  return log;
+}
+
+void stats_log_scan(StatsLog_t *log, GameOfLifeData_t *data,
+                    GenerationStats_t *stats) {
+  stats_clear(stats);
+  for (int i = 0; i < data->h; i++) {
+    stats_count_bytes(log->prev + (size_t)data->w * i,
+                      &get_cell_state(i, 0, data), data->w, i, stats);
+  }
+  memcpy(log->prev, data->grid, (size_t)data->w * data->h);
+}
+
+void stats_log_add(StatsLog_t *log, long generation, long generations,
+                   const GenerationStats_t *stats, double seconds) {
+  if (log->steps == log->capacity) {
+    size_t capacity = log->capacity == 0 ? 1024 : 2 * log->capacity;
+    double *grown = (double *)realloc(log->seconds, capacity * sizeof(double));
+    if (grown != NULL) {
+      log->seconds = grown;
+      log->capacity = capacity;
+    }
+  }
+  if (log->steps < log->capacity) {
+    log->seconds[log->steps++] = seconds;
+  }
+  fprintf(log->file,
+          "{\"generation\": %ld, \"generations\": %ld, \"population\": %ld, "
+          "\"births\": %ld, \"deaths\": %ld, ",
+          generation, generations, stats->population, stats->births,
+          stats->deaths);
+  if (stats->min_row <= stats->max_row) {
+    fprintf(log->file, "\"bbox\": [%d, %d, %d, %d], ", stats->min_col,
+            stats->min_row, stats->max_col, stats->max_row);
+  } else {
+    fprintf(log->file, "\"bbox\": null, ");
+  }
+  fprintf(log->file, "\"step_ms\": %.6f}\n", seconds * 1e3);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Nearest rank percentile p of n sorted values
+ */
+static double percentile(const double *sorted, size_t n, double p) {
+  size_t rank = (size_t)(p / 100 * n + 0.999999);
+  return sorted[rank == 0 ? 0 : rank - 1];
+}
+
+/**
+ * @brief Step time summary in milliseconds (step times get sorted)
+ */
+struct StatsSummary {
+  double mean, p50, p90, p99, max;
+};
+typedef struct StatsSummary StatsSummary_t;
+
+static StatsSummary_t summarize(StatsLog_t *log) {
+  StatsSummary_t s = {0, 0, 0, 0, 0};
+  size_t n = log->steps;
+  if (n == 0) {
+    return s;
+  }
+  qsort(log->seconds, n, sizeof(double), compare_doubles);
+  double total = 0;
+  for (size_t k = 0; k < n; k++) {
+    total += log->seconds[k];
+  }
+  s.mean = total / n * 1e3;
+  s.p50 = percentile(log->seconds, n, 50) * 1e3;
+  s.p90 = percentile(log->seconds, n, 90) * 1e3;
+  s.p99 = percentile(log->seconds, n, 99) * 1e3;
+  s.max = log->seconds[n - 1] * 1e3;
+  return s;
+}
+
+void print_stats_summary(StatsLog_t *log) {
+  StatsSummary_t s = summarize(log);
+  printf("step time: mean %.3f ms, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, "
+         "max %.3f ms (%zu steps)\n",
+         s.mean, s.p50, s.p90, s.p99, s.max, log->steps);
+}
+
+int free_stats_log(StatsLog_t *log) {
+  if (log == NULL) {
+    return 0;
+  }
+  StatsSummary_t s = summarize(log);
+  fprintf(log->file,
+          "{\"summary\": {\"steps\": %zu, \"mean_ms\": %.6f, \"p50_ms\": %.6f, "
+          "\"p90_ms\": %.6f, \"p99_ms\": %.6f, \"max_ms\": %.6f}}\n",
+          log->steps, s.mean, s.p50, s.p90, s.p99, s.max);
+  int ok = !ferror(log->file);
+  ok = fclose(log->file) == 0 && ok;
+  if (!ok) {
+    printf("Failed to write stats: %s\n", log->path);
+  }
+  free(log->prev);
+  free(log->seconds);
+  free(log);
+  return ok ? 0 : -1;
+}
@@ -0,0 +1,181 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "gameoflife.h"
+
+/**
+ * @brief Counters of one generation (births and deaths relative to the
+ * previous one), the bounding box being empty (min_row > max_row) when no
+ * cell is alive
+ */
+struct GenerationStats {
+  long population; // number of live cells
+  long births;     // number of cells that became alive
+  long deaths;     // number of cells that died
+  int min_row;     // first row holding a live cell
+  int max_row;     // last row holding a live cell
+  int min_col;     // first column holding a live cell
+  int max_col;     // last column holding a live cell
+};
+typedef struct GenerationStats GenerationStats_t;
+
+/**
+ * @brief Reset counters (empty bounding box)
+ *
+ * @param stats counters to reset
+ */
+void stats_clear(GenerationStats_t *stats);
+
+/**
+ * @brief Count a row of byte cells into stats
+ *
+ * @param prev row in previous generation
+ * @param next row in new generation
+ * @param w number of cells
+ * @param row row index
+ * @param stats counters to update
+ */
+void stats_count_bytes(const byte *prev, const byte *next, int w, int row,
+                       GenerationStats_t *stats);
+
+/**
+ * @brief Add counters of a row of byte cells computed by the caller into
+ * stats, the bounding box being extended to the live cells of the row
+ *
+ * @param next row in new generation
+ * @param w number of cells
+ * @param row row index
+ * @param counts population, births and deaths of the row
+ * @param stats counters to update
+ */
+void stats_add_row(const byte *next, int w, int row, const long counts[3],
+                   GenerationStats_t *stats);
+
+/**
+ * @brief Count a row of bit-packed cells into stats (column j being bit
+ * j % 64 of word j / 64, bits beyond the grid width being 0)
+ *
+ * @param prev row in previous generation
+ * @param next row in new generation
+ * @param nw number of words
+ * @param row row index
+ * @param stats counters to update
+ */
+void stats_count_words(const uint64_t *prev, const uint64_t *next, int nw,
+                       int row, GenerationStats_t *stats);
+
+/**
+ * @brief Count a segment of a row of bit-packed cells into stats (same
+ * layout as stats_count_words, the segment starting at column col)
+ *
+ * @param prev words of segment in previous generation
+ * @param next words of segment in new generation
+ * @param nw number of words
+ * @param row row index
+ * @param col column of bit 0 of first word (multiple of 64)
+ * @param stats counters to update
+ */
+void stats_count_segment(const uint64_t *prev, const uint64_t *next, int nw,
+                         int row, int col, GenerationStats_t *stats);
+
+/**
+ * @brief Count a column of bit-packed words into stats (one word of each of
+ * rows consecutive rows, stride words apart)
+ *
+ * @param prev first word in previous generation
+ * @param next first word in new generation
+ * @param stride words between two rows
+ * @param rows number of rows
+ * @param row index of first row
+ * @param col column of bit 0 of the words (multiple of 64)
+ * @param stats counters to update
+ */
+void stats_count_tile(const uint64_t *prev, const uint64_t *next,
+                      size_t stride, int rows, int row, int col,
+                      GenerationStats_t *stats);
+
+/**
+ * @brief Add counters of a part of a band into band counters (single
+ * thread, see stats_merge)
+ *
+ * @param into band counters
+ * @param part counters of a part of the band
+ */
+void stats_add(GenerationStats_t *into, const GenerationStats_t *part);
+
+/**
+ * @brief Add band counters into shared counters (bands computed by
+ * concurrent threads merge with atomic operations)
+ *
+ * @param into shared counters
+ * @param band counters of a band of rows
+ */
+void stats_merge(GenerationStats_t *into, const GenerationStats_t *band);
+
+/**
+ * @brief Per generation statistics stream of a run: one JSON object per line
+ * and a summary line with step time percentiles when closed
+ */
+struct StatsLog {
+  const char *path; // stats file
+  FILE *file;       // stats file
+  byte *prev;       // previous generation of scanned engines (NULL if none)
+  double *seconds;  // wall time of each step
+  size_t steps;     // number of steps
+  size_t capacity;  // capacity of seconds
+};
+typedef struct StatsLog StatsLog_t;
+
+/**
+ * @brief Create stats file
+ *
+ * @param path path of stats file
+ * @param data initial grid
+ * @param scan whether engine has no counters (generations are then scanned
+ * and compared with a copy of the previous one)
+ * @return StatsLog_t* log (must be closed by caller with free_stats_log,
+ * NULL on error)
+ */
+StatsLog_t *stats_log_init(const char *path, GameOfLifeData_t *data, int scan);
+
+/**
+ * @brief Count generation by scanning its grid (engines without counters)
+ *
+ * @param log stats log holding previous generation
+ * @param data new generation
+ * @param stats receives counters
+ */
+void stats_log_scan(StatsLog_t *log, GameOfLifeData_t *data,
+                    GenerationStats_t *stats);
+
+/**
+ * @brief Write one step to stats file
+ *
+ * @param log stats log
+ * @param generation generation reached
+ * @param generations number of generations computed by the step
+ * @param stats counters of reached generation
+ * @param seconds wall time of the step
+ */
+void stats_log_add(StatsLog_t *log, long generation, long generations,
+                   const GenerationStats_t *stats, double seconds);
+
+/**
+ * @brief Print step time percentiles to stdout
+ *
+ * @param log stats log
+ */
+void print_stats_summary(StatsLog_t *log);
+
+/**
+ * @brief Write summary line, close stats file and free log (NULL is ignored)
+ *
+ * @param log stats log to close
+ * @return int 0 if OK, -1 if a write failed
+ */
+int free_stats_log(StatsLog_t *log);
+
+#endif /* STATS_H */
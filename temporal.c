@@ -0,0 +1,348 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "packed.h"
+
+#define TILE_ROWS 256 // rows of a tile
+#define TILE_WORDS 32 // words of a tile row (64 cells each)
+
+/**
+ * @brief Temporal blocking engine state. The bit-packed grid is split in
+ * tiles of TILE_ROWS x TILE_WORDS words; each pass loads every tile with a
+ * ghost zone of depth rows above and below and one word (64 cells) on each
+ * side into a cache resident buffer, advances it depth generations there (the
+ * valid region shrinking by one cell per generation) and writes the tile
+ * back. The grid goes through memory once per pass instead of once per
+ * generation.
+ */
+struct TemporalEngine {
+  int w;                  // grid width
+  int h;                  // grid height
+  int nw;                 // number of words per row
+  word last_mask;         // valid bits of the last word of a row
+  word *cur;              // current generation (h * nw words)
+  word *next;             // preallocated grid receiving next pass
+  int torus;              // whether grid wraps around
+  Rule_t rule;            // rule (read by generic kernel)
+  PackedRowKernel kernel; // row kernel for rule
+  int depth;              // generations per pass
+  int tiles_x;            // number of tiles per row of tiles
+  int tiles;              // number of tiles
+  int stride;             // words per row of tile buffers
+  size_t tile_words;      // words of a tile buffer
+  ThreadPool_t *pool;     // threads computing tiles
+  word *buffers;          // 2 tile buffers per thread
+  double *traffic;        // bytes loaded and stored by each thread
+  int pass;               // generations of pass being computed
+  int last;               // whether pass being computed ends the step
+  double naive;           // bytes a pass per generation would have moved
+  GameOfLifeData_t *view; // byte grid returned by data()
+  int view_valid;         // whether view is up to date with cur
+  int hashing;            // whether last pass of a step hashes tiles
+  uint64_t hash;          // hash of current generation (sum of hashes of
+                          // rows of tiles)
+  uint64_t next_hash;     // hash of tiles of next generation computed so far
+  int count;              // whether last pass of a step collects counters
+  const word *from;       // generation counters of the step are relative to
+  word *start;            // copy of the generation a step of several passes
+                          // starts from (NULL unless counting)
+  GenerationStats_t stats; // counters since last stats() call
+};
+typedef struct TemporalEngine TemporalEngine_t;
+
+/**
+ * @brief Load the 64 cells of row i starting at column c (a multiple of 64)
+ * into a word, cells outside the grid being dead or wrapped around on a torus
+ */
+static word load_word(TemporalEngine_t *e, long i, long c) {
+  if (e->torus) {
+    i = (i % e->h + e->h) % e->h;
+  } else if (i < 0 || i >= e->h) {
+    return 0;
+  }
+  const word *row = e->cur + (size_t)e->nw * i;
+  if (!e->torus) {
+    return c >= 0 && c / WORD_BITS < e->nw ? row[c / WORD_BITS] : 0;
+  }
+  if (c >= 0 && c + WORD_BITS <= e->w) {
+    return row[c / WORD_BITS];
+  }
+  // ghost word across the edges of the torus
+  word x = 0;
+  for (int b = 0; b < WORD_BITS; b++) {
+    long j = ((c + b) % e->w + e->w) % e->w;
+    x |= ((row[j / WORD_BITS] >> (j % WORD_BITS)) & 1) << b;
+  }
+  return x;
+}
+
+/**
+ * @brief Hash of row i of tile column tx of grid g (see hash_part)
+ */
+static uint64_t hash_tile_row(TemporalEngine_t *e, const word *g, long i,
+                              int tx) {
+  int words = TILE_WORDS < e->nw - tx * TILE_WORDS ? TILE_WORDS
+                                                   : e->nw - tx * TILE_WORDS;
+  return hash_words(g + (size_t)e->nw * i + (size_t)tx * TILE_WORDS, words,
+                    (uint64_t)i * e->tiles_x + tx);
+}
+
+/**
+ * @brief Advance one tile pass generations from cur into next
+ *
+ * @param e engine
+ * @param t tile index
+ * @param buf 2 tile buffers
+ * @return double bytes loaded and stored
+ */
+static double step_tile(TemporalEngine_t *e, int t, word *buf) {
+  int d = e->pass;
+  int ty = t / e->tiles_x, tx = t % e->tiles_x;
+  long row0 = (long)ty * TILE_ROWS - d; // grid row of buffer row 0
+  long word0 = (long)tx * TILE_WORDS - 1; // grid word of buffer word 0
+  int rows = TILE_ROWS < e->h - ty * TILE_ROWS ? TILE_ROWS
+                                               : e->h - ty * TILE_ROWS;
+  int words = TILE_WORDS < e->nw - tx * TILE_WORDS ? TILE_WORDS
+                                                   : e->nw - tx * TILE_WORDS;
+  rows += 2 * d;
+  words += 2;
+  long last = e->nw - 1 - word0; // buffer word of the last word of a row
+  word *cur = buf, *next = buf + e->tile_words;
+  for (int r = 0; r < rows; r++) {
+    word *row = cur + (size_t)e->stride * r;
+    if (row0 + r >= 0 && row0 + r < e->h) {
+      // the tile itself is inside the grid, only ghost words may wrap
+      memcpy(row + 1, e->cur + (size_t)e->nw * (row0 + r) + word0 + 1,
+             (size_t)(words - 2) * sizeof(word));
+      if (e->torus && e->w % WORD_BITS != 0 && last == words - 2) {
+        row[last] = load_word(e, row0 + r, (word0 + last) * WORD_BITS);
+      }
+      row[0] = load_word(e, row0 + r, word0 * WORD_BITS);
+      row[words - 1] = load_word(e, row0 + r, (word0 + words - 1) * WORD_BITS);
+    } else {
+      for (int x = 0; x < words; x++) {
+        row[x] = load_word(e, row0 + r, (word0 + x) * WORD_BITS);
+      }
+    }
+  }
+  for (int g = 0; g < d; g++) {
+    // rows next to the computed ones are only valid up to generation g
+    for (int r = g + 1; r < rows - 1 - g; r++) {
+      word *out = next + (size_t)e->stride * r;
+      e->kernel(cur + (size_t)e->stride * (r - 1), cur + (size_t)e->stride * r,
+                cur + (size_t)e->stride * (r + 1), out, words, ~(word)0, 0, 0,
+                &e->rule);
+      if (!e->torus) {
+        // cells outside the grid stay dead
+        if (row0 + r < 0 || row0 + r >= e->h) {
+          memset(out, 0, (size_t)words * sizeof(word));
+        } else {
+          if (word0 < 0) {
+            out[0] = 0;
+          }
+          if (last < words) {
+            out[last] &= e->last_mask;
+            if (last + 1 < words) {
+              out[last + 1] = 0;
+            }
+          }
+        }
+      }
+    }
+    word *tmp = cur;
+    cur = next;
+    next = tmp;
+  }
+  uint64_t hash = 0;
+  GenerationStats_t stats;
+  stats_clear(&stats);
+  for (int r = d; r < rows - d; r++) {
+    word *out = e->next + (size_t)e->nw * (row0 + r) + word0 + 1;
+    memcpy(out, cur + (size_t)e->stride * r + 1,
+           (size_t)(words - 2) * sizeof(word));
+    if (last == words - 2) {
+      out[words - 3] &= e->last_mask;
+    }
+    if (e->last && e->hashing) {
+      // row of tile is still in cache
+      hash += hash_tile_row(e, e->next, row0 + r, tx);
+    }
+    if (e->last && e->count) {
+      stats_count_segment(e->from + (size_t)e->nw * (row0 + r) + word0 + 1,
+                          out, words - 2, (int)(row0 + r),
+                          (int)(WORD_BITS * (word0 + 1)), &stats);
+    }
+  }
+  if (e->last && e->hashing) {
+    __atomic_fetch_add(&e->next_hash, hash, __ATOMIC_RELAXED);
+  }
+  if (e->last && e->count) {
+    stats_merge(&e->stats, &stats);
+  }
+  return (double)((size_t)rows * words + (size_t)(rows - 2 * d) * (words - 2)) *
+         sizeof(word);
+}
+
+/**
+ * @brief Thread task computing one band of tiles of the pass
+ *
+ * @param arg engine
+ * @param id band index
+ * @param count number of bands
+ */
+static void step_tiles(void *arg, int id, int count) {
+  TemporalEngine_t *e = (TemporalEngine_t *)arg;
+  word *buf = e->buffers + 2 * e->tile_words * id;
+  for (int t = (int)((long)e->tiles * id / count);
+       t < (int)((long)e->tiles * (id + 1) / count); t++) {
+    e->traffic[id] += step_tile(e, t, buf);
+  }
+}
+
+static void *temporal_engine_create(GameOfLifeData_t *data,
+                                    const EngineConfig_t *config) {
+  TemporalEngine_t *e =
+      (TemporalEngine_t *)calloc(1, sizeof(TemporalEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->w = data->w;
+  e->h = data->h;
+  e->nw = (data->w + WORD_BITS - 1) / WORD_BITS;
+  e->last_mask = data->w % WORD_BITS == 0
+                     ? ~(word)0
+                     : ((word)1 << (data->w % WORD_BITS)) - 1;
+  size_t words = (size_t)e->nw * e->h;
+  e->cur = (word *)calloc(words, sizeof(word));
+  e->next = (word *)calloc(words, sizeof(word));
+  e->depth = config->temporal_depth;
+  e->stride = TILE_WORDS + 2;
+  e->tile_words = (size_t)e->stride * (TILE_ROWS + 2 * e->depth);
+  e->buffers =
+      (word *)malloc(2 * e->tile_words * config->threads * sizeof(word));
+  e->traffic = (double *)calloc(config->threads, sizeof(double));
+  e->count = config->stats;
+  if (e->count) {
+    e->start = (word *)malloc(words * sizeof(word));
+  }
+  e->pool = threadpool_init(config->threads);
+  if (e->cur == NULL || e->next == NULL || e->buffers == NULL ||
+      e->traffic == NULL || (e->count && e->start == NULL) ||
+      e->pool == NULL) {
+    if (e->pool != NULL) {
+      free_threadpool(e->pool);
+    }
+    free(e->cur);
+    free(e->next);
+    free(e->buffers);
+    free(e->traffic);
+    free(e->start);
+    free(e);
+    return NULL;
+  }
+  pack_rows(data, e->cur, e->nw);
+  e->torus = config->torus;
+  e->rule = config->rule;
+  e->kernel = packed_row_kernel(&e->rule);
+  e->tiles_x = (e->nw + TILE_WORDS - 1) / TILE_WORDS;
+  e->tiles = e->tiles_x * ((e->h + TILE_ROWS - 1) / TILE_ROWS);
+  e->view = data;
+  e->view_valid = 1;
+  stats_clear(&e->stats);
+  e->hashing = config->hash;
+  for (long i = 0; e->hashing && i < e->h; i++) {
+    for (int tx = 0; tx < e->tiles_x; tx++) {
+      e->hash += hash_tile_row(e, e->cur, i, tx);
+    }
+  }
+  return e;
+}
+
+static void temporal_engine_step(void *state, long n) {
+  TemporalEngine_t *e = (TemporalEngine_t *)state;
+  // the first passes of a step overwrite the generation it starts from
+  e->from = e->cur;
+  if (e->count && n > e->depth) {
+    memcpy(e->start, e->cur, (size_t)e->nw * e->h * sizeof(word));
+    e->from = e->start;
+  }
+  while (n > 0) {
+    e->pass = n < e->depth ? (int)n : e->depth;
+    e->last = e->pass == n;
+    threadpool_run(e->pool, step_tiles, e);
+    word *tmp = e->cur;
+    e->cur = e->next;
+    e->next = tmp;
+    if (e->last) {
+      e->hash = e->next_hash;
+      e->next_hash = 0;
+    }
+    // a pass per generation loads and stores the whole grid every generation
+    e->naive += 2.0 * e->pass * e->nw * e->h * sizeof(word);
+    n -= e->pass;
+  }
+  e->view_valid = 0;
+}
+
+static double temporal_engine_traffic(void *state, double *naive) {
+  TemporalEngine_t *e = (TemporalEngine_t *)state;
+  double traffic = 0;
+  for (int k = 0; k < e->pool->count; k++) {
+    traffic += e->traffic[k];
+  }
+  *naive = e->naive;
+  return traffic;
+}
+
+static void temporal_engine_stats(void *state, GenerationStats_t *stats) {
+  TemporalEngine_t *e = (TemporalEngine_t *)state;
+  *stats = e->stats;
+  stats_clear(&e->stats);
+}
+
+static uint64_t temporal_engine_hash(void *state) {
+  TemporalEngine_t *e = (TemporalEngine_t *)state;
+  return e->hash;
+}
+
+static const uint64_t *temporal_engine_packed(void *state) {
+  TemporalEngine_t *e = (TemporalEngine_t *)state;
+  return e->cur;
+}
+
+static GameOfLifeData_t *temporal_engine_data(void *state) {
+  TemporalEngine_t *e = (TemporalEngine_t *)state;
+  if (!e->view_valid) {
+    unpack_rows(e->cur, e->nw, e->view);
+    e->view_valid = 1;
+  }
+  return e->view;
+}
+
+static void temporal_engine_destroy(void *state) {
+  TemporalEngine_t *e = (TemporalEngine_t *)state;
+  free_threadpool(e->pool);
+  free(e->cur);
+  free(e->next);
+  free(e->buffers);
+  free(e->traffic);
+  free(e->start);
+  free_data(e->view);
+  free(e);
+}
+
+const EngineOps_t temporal_engine_ops = {
+    .name = "temporal",
+    .torus = 1,
+    .birth0 = 1,
+    .bounded = 1,
+    .create = temporal_engine_create,
+    .step = temporal_engine_step,
+    .traffic = temporal_engine_traffic,
+    .stats = temporal_engine_stats,
+    .hash = temporal_engine_hash,
+    .packed = temporal_engine_packed,
+    .data = temporal_engine_data,
+    .destroy = temporal_engine_destroy,
+};
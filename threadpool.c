@@ -0,0 +1,115 @@
+#include <stdlib.h>
+
+#include "threadpool.h"
+#include "trace.h"
+
+struct Worker {
+  ThreadPool_t *pool;
+  int id;
+};
+typedef struct Worker Worker_t;
+
+static void *worker_main(void *arg) {
+  Worker_t *worker = (Worker_t *)arg;
+  ThreadPool_t *pool = worker->pool;
+  int id = worker->id;
+  free(worker);
+  // wait until threadpool_init started every worker or gave up
+  pthread_mutex_lock(&pool->lock);
+  int started = pool->started;
+  pthread_mutex_unlock(&pool->lock);
+  if (!started) {
+    return NULL;
+  }
+  trace_thread_name("worker", id);
+  while (1) {
+    pthread_barrier_wait(&pool->start);
+    if (pool->task == NULL) {
+      break;
+    }
+    double start = trace_begin();
+    pool->task(pool->arg, id, pool->count);
+    trace_end("task", start);
+    pthread_barrier_wait(&pool->done);
+  }
+  return NULL;
+}
+
+ThreadPool_t *threadpool_init(int count) {
+  ThreadPool_t *pool = (ThreadPool_t *)malloc(sizeof(ThreadPool_t));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pool->count = count;
+  pool->threads = (pthread_t *)malloc((count - 1) * sizeof(pthread_t));
+  if (count > 1 && pool->threads == NULL) {
+    free(pool);
+    return NULL;
+  }
+  pool->task = NULL;
+  pool->arg = NULL;
+  pool->started = 0;
+  pthread_barrier_init(&pool->start, NULL, count);
+  pthread_barrier_init(&pool->done, NULL, count);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_mutex_lock(&pool->lock);
+  int k;
+  for (k = 1; k < count; k++) {
+    Worker_t *worker = (Worker_t *)malloc(sizeof(Worker_t));
+    if (worker == NULL) {
+      break;
+    }
+    worker->pool = pool;
+    worker->id = k;
+    if (pthread_create(&pool->threads[k - 1], NULL, worker_main, worker) !=
+        0) {
+      free(worker);
+      break;
+    }
+  }
+  pool->started = k == count;
+  pthread_mutex_unlock(&pool->lock);
+  if (!pool->started) {
+    // workers started so far exit without waiting on barriers
+    for (int j = 1; j < k; j++) {
+      pthread_join(pool->threads[j - 1], NULL);
+    }
+    free_threadpool(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+void threadpool_run(ThreadPool_t *pool, ThreadTask task, void *arg) {
+  if (pool->count == 1) {
+    double start = trace_begin();
+    task(arg, 0, 1);
+    trace_end("task", start);
+    return;
+  }
+  pool->task = task;
+  pool->arg = arg;
+  pthread_barrier_wait(&pool->start);
+  double start = trace_begin();
+  task(arg, 0, pool->count);
+  trace_end("task", start);
+  // time spent waiting for the slowest thread
+  start = trace_begin();
+  pthread_barrier_wait(&pool->done);
+  trace_end("join", start);
+}
+
+void free_threadpool(ThreadPool_t *pool) {
+  if (pool->started && pool->count > 1) {
+    pool->task = NULL;
+    pthread_barrier_wait(&pool->start);
+    for (int k = 1; k < pool->count; k++) {
+      pthread_join(pool->threads[k - 1], NULL);
+    }
+  }
+  pthread_barrier_destroy(&pool->start);
+  pthread_barrier_destroy(&pool->done);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->threads);
+  free(pool);
+}
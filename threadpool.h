@@ -0,0 +1,60 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+/**
+ * @brief Task run by every thread of the pool
+ *
+ * @param arg task argument (shared by all threads)
+ * @param id thread index in [0, count)
+ * @param count number of threads running the task
+ */
+typedef void (*ThreadTask)(void *arg, int id, int count);
+
+/**
+ * @brief Pool of worker threads living for the whole run. Workers sleep on a
+ * barrier until a task is submitted, and a second barrier waits for all of
+ * them to complete it.
+ */
+struct ThreadPool {
+  int count;                 // number of threads (including caller thread)
+  pthread_t *threads;        // count - 1 worker threads
+  pthread_barrier_t start;   // released when a task is submitted
+  pthread_barrier_t done;    // released when all threads completed task
+  ThreadTask task;           // current task (NULL asks workers to exit)
+  void *arg;                 // current task argument
+  pthread_mutex_t lock;      // held while workers are started
+  int started;               // whether every worker was started (workers
+                             // exit right away otherwise)
+};
+typedef struct ThreadPool ThreadPool_t;
+
+/**
+ * @brief Start thread pool
+ *
+ * @param count number of threads running tasks, the thread calling
+ * threadpool_run being one of them (count - 1 workers are started)
+ * @return ThreadPool_t* pool (must be free'd by caller with free_threadpool,
+ * NULL if it could not be allocated or a worker could not be started)
+ */
+ThreadPool_t *threadpool_init(int count);
+
+/**
+ * @brief Run task on all threads of the pool (caller thread runs it with id
+ * 0) and wait for all of them to complete it
+ *
+ * @param pool thread pool
+ * @param task task to run
+ * @param arg task argument
+ */
+void threadpool_run(ThreadPool_t *pool, ThreadTask task, void *arg);
+
+/**
+ * @brief Stop workers and free thread pool
+ *
+ * @param pool thread pool to free
+ */
+void free_threadpool(ThreadPool_t *pool);
+
+#endif /* THREADPOOL_H */
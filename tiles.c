@@ -0,0 +1,368 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "packed.h"
+
+#define TILE_ROWS 64
+
+struct TiledEngine;
+/**
+ * @brief Band kernel: compute tile rows starting in rows [begin, end)
+ */
+typedef void (*TiledBandKernel)(struct TiledEngine *e, int begin, int end);
+
+/**
+ * @brief Active-region engine state: the bit-packed grid is split into tiles
+ * of 64 x 64 cells (one word wide, TILE_ROWS rows high). A tile is computed
+ * only if it or one of its 8 neighbour tiles changed during last generation,
+ * other tiles cannot change. Skipped tiles are not copied: since they did not
+ * change during last generation the next grid, holding the generation before
+ * the current one, already has their state.
+ */
+struct TiledEngine {
+  int w;                  // grid width
+  int h;                  // grid height
+  int nw;                 // number of words per row (tile columns)
+  int th;                 // number of tile rows
+  word last_mask;         // valid bits of the last word of a row
+  word *cur;              // current generation ((h + 2) * nw words)
+  word *next;             // preallocated grid receiving next generation
+  int torus;              // whether grid wraps around
+  Rule_t rule;            // rule (used by generic kernel)
+  TiledBandKernel kernel; // band kernel for rule
+  byte *changed;          // th * nw flags: tile changed during last generation
+  byte *changed_next;     // flags of generation being computed
+  long active;            // tiles computed so far by generation being computed
+  long last_active;       // tiles computed during last generation
+  GameOfLifeData_t *view; // byte grid returned by data()
+  int view_valid;         // whether view is up to date with cur
+  uint64_t *tile_hash;    // th * nw hashes of tiles of current generation
+                          // (NULL unless generations are hashed)
+  uint64_t hash;          // hash of current generation (sum of tiles hashes)
+  uint64_t hash_delta;    // change of hash by tiles computed so far
+  GenerationStats_t *tile_stats; // th * nw counters of tiles of current
+                                 // generation (NULL unless counting)
+  GenerationStats_t stats; // counters since last stats() call
+};
+typedef struct TiledEngine TiledEngine_t;
+
+#define tiled_row(e, g, i) ((g) + (size_t)(e)->nw * ((i) + 1))
+#define tile_changed(e, ty, tx) (e)->changed[(size_t)(e)->nw * (ty) + (tx)]
+
+/**
+ * @brief Whether tile (ty, tx) or one of its neighbours changed during last
+ * generation (edge tiles neighbour the opposite edge ones on a torus)
+ */
+static int tile_active(TiledEngine_t *e, int ty, int tx) {
+  for (int dy = -1; dy <= 1; dy++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      int y = ty + dy, x = tx + dx;
+      if (e->torus) {
+        y = (y + e->th) % e->th;
+        x = (x + e->nw) % e->nw;
+      }
+      if (y >= 0 && y < e->th && x >= 0 && x < e->nw &&
+          tile_changed(e, y, x)) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Hash of tile (ty, tx) of grid g (see hash_part)
+ */
+static uint64_t hash_tile(TiledEngine_t *e, const word *g, int ty, int tx) {
+  int end = ty * TILE_ROWS + TILE_ROWS < e->h ? ty * TILE_ROWS + TILE_ROWS
+                                              : e->h;
+  uint64_t hash = FNV_OFFSET;
+  for (int i = ty * TILE_ROWS; i < end; i++) {
+    hash = hash_fold(hash, tiled_row(e, g, i)[tx]);
+  }
+  return hash_part(hash, (uint64_t)e->nw * ty + tx);
+}
+
+/**
+ * @brief Recount tile (ty, tx) from grid prev to grid next into stats
+ */
+static void count_tile(TiledEngine_t *e, const word *prev, const word *next,
+                       int ty, int tx, GenerationStats_t *stats) {
+  int rows = ty * TILE_ROWS + TILE_ROWS < e->h ? TILE_ROWS
+                                               : e->h - ty * TILE_ROWS;
+  stats_clear(stats);
+  stats_count_tile(tiled_row(e, prev, ty * TILE_ROWS) + tx,
+                   tiled_row(e, next, ty * TILE_ROWS) + tx, e->nw, rows,
+                   ty * TILE_ROWS, WORD_BITS * tx, stats);
+}
+
+/**
+ * @brief Compute next state of tile (ty, tx) with rule birth/survive masks
+ *
+ * @param hash receives hash of the next state of the tile if it changed and
+ * generations are hashed
+ * @return int whether tile changed
+ */
+static inline __attribute__((always_inline)) int
+step_tile(TiledEngine_t *e, int ty, int tx, unsigned birth, unsigned survive,
+          uint64_t *hash) {
+  int end = ty * TILE_ROWS + TILE_ROWS < e->h ? ty * TILE_ROWS + TILE_ROWS
+                                              : e->h;
+  word mask = tx == e->nw - 1 ? e->last_mask : ~(word)0;
+  word diff = 0;
+  uint64_t h = FNV_OFFSET;
+  for (int i = ty * TILE_ROWS; i < end; i++) {
+    const word *a = tiled_row(e, e->cur, i - 1);
+    const word *r = tiled_row(e, e->cur, i);
+    const word *b = tiled_row(e, e->cur, i + 1);
+    word ap = 0, rp = 0, bp = 0, an = 0, rn = 0, bn = 0;
+    if (tx > 0) {
+      ap = a[tx - 1], rp = r[tx - 1], bp = b[tx - 1];
+    } else if (e->torus) {
+      ap = west_wrap(a, e->w), rp = west_wrap(r, e->w), bp = west_wrap(b, e->w);
+    }
+    word ae, re, be;
+    if (tx + 1 < e->nw) {
+      an = a[tx + 1], rn = r[tx + 1], bn = b[tx + 1];
+    }
+    if (e->torus && tx + 1 == e->nw) {
+      ae = east_wrap(a[tx], a, e->w);
+      re = east_wrap(r[tx], r, e->w);
+      be = east_wrap(b[tx], b, e->w);
+    } else {
+      ae = east_of(a[tx], an), re = east_of(r[tx], rn);
+      be = east_of(b[tx], bn);
+    }
+    word out = life_word(west_of(a[tx], ap), a[tx], ae, west_of(r[tx], rp),
+                         r[tx], re, west_of(b[tx], bp), b[tx], be, birth,
+                         survive) &
+               mask;
+    tiled_row(e, e->next, i)[tx] = out;
+    diff |= out ^ r[tx];
+    if (e->tile_hash != NULL) {
+      h = hash_fold(h, out);
+    }
+  }
+  if (e->tile_hash != NULL && diff != 0) {
+    *hash = hash_part(h, (uint64_t)e->nw * ty + tx);
+  }
+  return diff != 0;
+}
+
+/*
+ * Band kernels of SPECIALIZED_RULES are compiled with constant rule masks,
+ * the generic kernel reads them from engine. A band computes tile rows
+ * starting in [begin, end), and updates the hashes and counters of the tiles
+ * that changed (the other tiles keep their population and bounding box, with
+ * no birth nor death).
+ */
+#define TILED_BAND_KERNEL(name, birth, survive)                                \
+  static void tiled_band_##name(TiledEngine_t *e, int begin, int end) {        \
+    long active = 0;                                                           \
+    uint64_t delta = 0;                                                        \
+    GenerationStats_t band;                                                    \
+    stats_clear(&band);                                                        \
+    for (int ty = (begin + TILE_ROWS - 1) / TILE_ROWS; ty * TILE_ROWS < end;   \
+         ty++) {                                                               \
+      for (int tx = 0; tx < e->nw; tx++) {                                     \
+        size_t t = (size_t)e->nw * ty + tx;                                    \
+        byte changed = 0;                                                      \
+        if (tile_active(e, ty, tx)) {                                          \
+          uint64_t hash;                                                       \
+          changed = (byte)step_tile(e, ty, tx, birth, survive, &hash);         \
+          active++;                                                            \
+          if (changed && e->tile_hash != NULL) {                               \
+            delta += hash - e->tile_hash[t];                                   \
+            e->tile_hash[t] = hash;                                            \
+          }                                                                    \
+        }                                                                      \
+        e->changed_next[t] = changed;                                          \
+        if (e->tile_stats != NULL) {                                           \
+          if (changed) {                                                       \
+            count_tile(e, e->cur, e->next, ty, tx, &e->tile_stats[t]);         \
+          } else {                                                             \
+            e->tile_stats[t].births = 0;                                       \
+            e->tile_stats[t].deaths = 0;                                       \
+          }                                                                    \
+          stats_add(&band, &e->tile_stats[t]);                                 \
+        }                                                                      \
+      }                                                                        \
+    }                                                                          \
+    __atomic_fetch_add(&e->active, active, __ATOMIC_RELAXED);                  \
+    if (delta != 0) {                                                          \
+      __atomic_fetch_add(&e->hash_delta, delta, __ATOMIC_RELAXED);             \
+    }                                                                          \
+    if (e->tile_stats != NULL) {                                               \
+      stats_merge(&e->stats, &band);                                           \
+    }                                                                          \
+  }
+SPECIALIZED_RULES(TILED_BAND_KERNEL)
+TILED_BAND_KERNEL(generic, e->rule.birth, e->rule.survive)
+
+#define TILED_BAND_KERNEL_ENTRY(name, birth, survive)                          \
+  {{birth, survive}, tiled_band_##name},
+static const struct {
+  Rule_t rule;
+  TiledBandKernel kernel;
+} tiled_band_kernels[] = {SPECIALIZED_RULES(TILED_BAND_KERNEL_ENTRY)};
+
+static void *tiled_engine_create(GameOfLifeData_t *data,
+                                 const EngineConfig_t *config) {
+  TiledEngine_t *e = (TiledEngine_t *)malloc(sizeof(TiledEngine_t));
+  if (e == NULL) {
+    return NULL;
+  }
+  e->w = data->w;
+  e->h = data->h;
+  e->nw = (data->w + WORD_BITS - 1) / WORD_BITS;
+  e->th = (data->h + TILE_ROWS - 1) / TILE_ROWS;
+  e->last_mask = data->w % WORD_BITS == 0
+                     ? ~(word)0
+                     : ((word)1 << (data->w % WORD_BITS)) - 1;
+  size_t words = (size_t)e->nw * (e->h + 2);
+  size_t tiles = (size_t)e->nw * e->th;
+  e->cur = (word *)calloc(words, sizeof(word));
+  e->next = (word *)calloc(words, sizeof(word));
+  e->changed = (byte *)malloc(tiles);
+  e->changed_next = (byte *)malloc(tiles);
+  e->tile_hash =
+      config->hash ? (uint64_t *)malloc(tiles * sizeof(uint64_t)) : NULL;
+  e->tile_stats = config->stats ? (GenerationStats_t *)malloc(
+                                      tiles * sizeof(GenerationStats_t))
+                                : NULL;
+  if (e->cur == NULL || e->next == NULL || e->changed == NULL ||
+      e->changed_next == NULL || (config->hash && e->tile_hash == NULL) ||
+      (config->stats && e->tile_stats == NULL)) {
+    free(e->cur);
+    free(e->next);
+    free(e->changed);
+    free(e->changed_next);
+    free(e->tile_hash);
+    free(e->tile_stats);
+    free(e);
+    return NULL;
+  }
+  // every tile must be computed at first generation
+  memset(e->changed, 1, tiles);
+  pack_rows(data, tiled_row(e, e->cur, 0), e->nw);
+  e->torus = config->torus;
+  if (e->torus) {
+    wrap_rows(tiled_row(e, e->cur, 0), e->nw, e->h);
+  }
+  e->rule = config->rule;
+  e->kernel = tiled_band_generic;
+  for (size_t k = 0;
+       k < sizeof(tiled_band_kernels) / sizeof(tiled_band_kernels[0]); k++) {
+    if (tiled_band_kernels[k].rule.birth == e->rule.birth &&
+        tiled_band_kernels[k].rule.survive == e->rule.survive) {
+      e->kernel = tiled_band_kernels[k].kernel;
+    }
+  }
+  e->active = 0;
+  e->last_active = 0;
+  e->view = data;
+  e->view_valid = 1;
+  e->hash = 0;
+  e->hash_delta = 0;
+  stats_clear(&e->stats);
+  // counters of unchanged tiles are carried over from generation to
+  // generation
+  for (int ty = 0; e->tile_stats != NULL && ty < e->th; ty++) {
+    for (int tx = 0; tx < e->nw; tx++) {
+      count_tile(e, e->cur, e->cur, ty, tx,
+                 &e->tile_stats[(size_t)e->nw * ty + tx]);
+    }
+  }
+  if (config->hash) {
+    for (int ty = 0; ty < e->th; ty++) {
+      for (int tx = 0; tx < e->nw; tx++) {
+        e->tile_hash[(size_t)e->nw * ty + tx] = hash_tile(e, e->cur, ty, tx);
+        e->hash += e->tile_hash[(size_t)e->nw * ty + tx];
+      }
+    }
+  }
+  return e;
+}
+
+static void tiled_engine_step_rows(void *state, int begin, int end) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  e->kernel(e, begin, end);
+}
+
+static void tiled_engine_swap(void *state) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  word *tmp = e->cur;
+  e->cur = e->next;
+  e->next = tmp;
+  byte *flags = e->changed;
+  e->changed = e->changed_next;
+  e->changed_next = flags;
+  e->last_active = e->active;
+  e->active = 0;
+  if (e->torus) {
+    wrap_rows(tiled_row(e, e->cur, 0), e->nw, e->h);
+  }
+  e->view_valid = 0;
+  e->hash += e->hash_delta;
+  e->hash_delta = 0;
+}
+
+static long tiled_engine_active_tiles(void *state, long *total) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  *total = (long)e->nw * e->th;
+  return e->last_active;
+}
+
+static void tiled_engine_stats(void *state, GenerationStats_t *stats) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  *stats = e->stats;
+  stats_clear(&e->stats);
+}
+
+static uint64_t tiled_engine_hash(void *state) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  return e->hash;
+}
+
+static const uint64_t *tiled_engine_packed(void *state) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  return tiled_row(e, e->cur, 0);
+}
+
+static GameOfLifeData_t *tiled_engine_data(void *state) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  if (!e->view_valid) {
+    unpack_rows(tiled_row(e, e->cur, 0), e->nw, e->view);
+    e->view_valid = 1;
+  }
+  return e->view;
+}
+
+static void tiled_engine_destroy(void *state) {
+  TiledEngine_t *e = (TiledEngine_t *)state;
+  free(e->cur);
+  free(e->next);
+  free(e->changed);
+  free(e->changed_next);
+  free(e->tile_hash);
+  free(e->tile_stats);
+  free_data(e->view);
+  free(e);
+}
+
+const EngineOps_t tiled_engine_ops = {
+    .name = "tiled",
+    .torus = 1,
+    .birth0 = 1,
+    .bounded = 1,
+    .create = tiled_engine_create,
+    .step_rows = tiled_engine_step_rows,
+    .swap = tiled_engine_swap,
+    .active_tiles = tiled_engine_active_tiles,
+    .stats = tiled_engine_stats,
+    .hash = tiled_engine_hash,
+    .packed = tiled_engine_packed,
+    .data = tiled_engine_data,
+    .destroy = tiled_engine_destroy,
+};
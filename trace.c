@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+// spans per chunk of a thread buffer
+#define TRACE_CHUNK 4096
+
+/**
+ * @brief Recorded span (times in microseconds since trace_init)
+ */
+struct TraceEvent {
+  const char *name;
+  double start;
+  double duration;
+};
+typedef struct TraceEvent TraceEvent_t;
+
+struct TraceChunk {
+  TraceEvent_t events[TRACE_CHUNK];
+  struct TraceChunk *next; // previous chunk (chunks are listed newest first)
+};
+typedef struct TraceChunk TraceChunk_t;
+
+/**
+ * @brief Spans of one thread, only written by that thread
+ */
+struct TraceBuffer {
+  int tid;                   // thread id in trace
+  const char *name;          // thread name (NULL if unnamed)
+  int index;                 // appended to name (negative: none)
+  TraceChunk_t *chunks;      // chunks, the first one being filled
+  int count;                 // spans in first chunk
+  long dropped;              // spans lost when a chunk allocation failed
+  struct TraceBuffer *next;  // next buffer of global list
+};
+typedef struct TraceBuffer TraceBuffer_t;
+
+int trace_enabled = 0;
+
+static const char *trace_path;
+static double trace_origin;
+static int trace_tids;
+static TraceBuffer_t *trace_buffers; // all thread buffers (lock-free list)
+static __thread TraceBuffer_t *trace_buffer; // calling thread buffer
+
+static double monotonic_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+int trace_init(const char *path) {
+  // fail early rather than after the run
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Failed to open file: %s\n", path);
+    return -1;
+  }
+  fclose(file);
+  trace_path = path;
+  trace_origin = monotonic_us();
+  trace_enabled = 1;
+  return 0;
+}
+
+double trace_now(void) { return monotonic_us() - trace_origin; }
+
+/**
+ * @brief Buffer of calling thread, created and linked on first use
+ */
+static TraceBuffer_t *thread_buffer(void) {
+  TraceBuffer_t *buffer = trace_buffer;
+  if (buffer != NULL) {
+    return buffer;
+  }
+  buffer = (TraceBuffer_t *)calloc(1, sizeof(TraceBuffer_t));
+  if (buffer == NULL) {
+    return NULL;
+  }
+  buffer->tid = __atomic_add_fetch(&trace_tids, 1, __ATOMIC_RELAXED);
+  buffer->index = -1;
+  buffer->next = __atomic_load_n(&trace_buffers, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&trace_buffers, &buffer->next, buffer,
+                                      1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    ;
+  trace_buffer = buffer;
+  return buffer;
+}
+
+void trace_add(const char *name, double start, double end) {
+  TraceBuffer_t *buffer = thread_buffer();
+  if (buffer == NULL) {
+    return;
+  }
+  if (buffer->chunks == NULL || buffer->count == TRACE_CHUNK) {
+    TraceChunk_t *chunk = (TraceChunk_t *)malloc(sizeof(TraceChunk_t));
+    if (chunk == NULL) {
+      buffer->dropped++;
+      return;
+    }
+    chunk->next = buffer->chunks;
+    buffer->chunks = chunk;
+    buffer->count = 0;
+  }
+  TraceEvent_t *event = &buffer->chunks->events[buffer->count++];
+  event->name = name;
+  event->start = start;
+  event->duration = end - start;
+}
+
+void trace_thread_name(const char *name, int index) {
+  if (!trace_enabled) {
+    return;
+  }
+  TraceBuffer_t *buffer = thread_buffer();
+  if (buffer != NULL) {
+    buffer->name = name;
+    buffer->index = index;
+  }
+}
+
+/**
+ * @brief Write spans of a chunk
+ *
+ * @param file trace file
+ * @param pid process id
+ * @param tid thread id
+ * @param chunk chunk
+ * @param count spans in chunk
+ */
+static void write_chunk(FILE *file, int pid, int tid,
+                        const TraceChunk_t *chunk, int count) {
+  for (int k = 0; k < count; k++) {
+    const TraceEvent_t *event = &chunk->events[k];
+    fprintf(file,
+            ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, "
+            "\"ts\": %.3f, \"dur\": %.3f}",
+            event->name, pid, tid, event->start, event->duration);
+  }
+}
+
+int free_trace(void) {
+  if (!trace_enabled) {
+    return 0;
+  }
+  trace_enabled = 0;
+  int pid = (int)getpid();
+  FILE *file = fopen(trace_path, "w");
+  if (file == NULL) {
+    printf("Failed to open file: %s\n", trace_path);
+  } else {
+    fprintf(file,
+            "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"
+            "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, "
+            "\"args\": {\"name\": \"gameoflife\"}}",
+            pid);
+  }
+  TraceBuffer_t *buffer = __atomic_load_n(&trace_buffers, __ATOMIC_ACQUIRE);
+  while (buffer != NULL) {
+    if (file != NULL && buffer->name != NULL) {
+      fprintf(file,
+              ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, "
+              "\"tid\": %d, \"args\": {\"name\": \"%s",
+              pid, buffer->tid, buffer->name);
+      if (buffer->index >= 0) {
+        fprintf(file, " %d", buffer->index);
+      }
+      fprintf(file, "\"}}");
+    }
+    if (buffer->dropped > 0) {
+      printf("Failed to allocate trace buffer: %ld spans dropped\n",
+             buffer->dropped);
+    }
+    int count = buffer->count;
+    TraceChunk_t *chunk = buffer->chunks;
+    while (chunk != NULL) {
+      if (file != NULL) {
+        write_chunk(file, pid, buffer->tid, chunk, count);
+      }
+      TraceChunk_t *next = chunk->next;
+      free(chunk);
+      chunk = next;
+      count = TRACE_CHUNK;
+    }
+    TraceBuffer_t *next = buffer->next;
+    free(buffer);
+    buffer = next;
+  }
+  trace_buffers = NULL;
+  trace_buffer = NULL;
+  if (file == NULL) {
+    return -1;
+  }
+  fprintf(file, "\n]}\n");
+  int ok = !ferror(file);
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    printf("Failed to write trace: %s\n", trace_path);
+  }
+  return ok ? 0 : -1;
+}
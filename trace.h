@@ -0,0 +1,68 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * Phase profiling in Chrome trace-event format (chrome://tracing, Perfetto).
+ * Each thread appends spans to its own buffer without locking, buffers being
+ * linked once in a global list and only written out by free_trace, after
+ * every traced thread has been joined.
+ */
+
+// whether spans are recorded (set by trace_init)
+extern int trace_enabled;
+
+/**
+ * @brief Start recording spans
+ *
+ * @param path path of trace file written by free_trace
+ * @return int 0 if OK, -1 if file cannot be created
+ */
+int trace_init(const char *path);
+
+/**
+ * @brief Monotonic time in microseconds since trace_init
+ */
+double trace_now(void);
+
+/**
+ * @brief Record span in calling thread buffer
+ *
+ * @param name span name (string literal without quotes, not copied)
+ * @param start start time (see trace_now)
+ * @param end end time (see trace_now)
+ */
+void trace_add(const char *name, double start, double end);
+
+/**
+ * @brief Name calling thread in trace
+ *
+ * @param name thread name (string literal, not copied)
+ * @param index appended to name (negative: none)
+ */
+void trace_thread_name(const char *name, int index);
+
+/**
+ * @brief Start of a span (0 if not tracing)
+ */
+static inline double trace_begin(void) {
+  return trace_enabled ? trace_now() : 0;
+}
+
+/**
+ * @brief End span started at start (see trace_begin)
+ */
+static inline void trace_end(const char *name, double start) {
+  if (trace_enabled) {
+    trace_add(name, start, trace_now());
+  }
+}
+
+/**
+ * @brief Stop tracing, write trace file and free buffers (nothing is done if
+ * tracing was not started). Threads that recorded spans must be joined.
+ *
+ * @return int 0 if OK, -1 if a write failed
+ */
+int free_trace(void);
+
+#endif /* TRACE_H */